@@ -0,0 +1,224 @@
+#include"Test.h"
+#include"AABBTree.h"
+#include<algorithm>
+#include<random>
+#include<vector>
+
+namespace
+{
+	// Spheres spread through a cube sized for roughly constant density,
+	// the tree has had moves, removals and reinserts
+	struct Scene
+	{
+		std::vector<Vector3> mCenters;
+		std::vector<float> mRadii;
+		std::vector<int> mProxies;
+		AABBTree mTree;
+		float mExtent;
+
+		Scene(int count, unsigned int seed)
+			:mExtent(100.0f * std::cbrt(static_cast<float>(count)))
+		{
+			std::mt19937 random(seed);
+			std::uniform_real_distribution<float> position(-mExtent, mExtent);
+			std::uniform_real_distribution<float> radius(5.0f, 25.0f);
+			std::uniform_real_distribution<float> step(0.0f, 50.0f);
+			for (int i = 0; i < count; i++)
+			{
+				mCenters.emplace_back(Vector3(position(random), position(random), position(random)));
+				mRadii.emplace_back(radius(random));
+				mProxies.emplace_back(mTree.CreateProxy(GetBox(i), ToUserData(i)));
+			}
+			for (int i = 0; i < count / 10; i++)
+			{
+				int k = static_cast<int>(random() % count);
+				mCenters[k] += Vector3(step(random), step(random), step(random));
+				mTree.MoveProxy(mProxies[k], GetBox(k));
+			}
+			for (int k = 0; k < count; k += 20)
+			{
+				mTree.DestroyProxy(mProxies[k]);
+			}
+			for (int k = 0; k < count; k += 20)
+			{
+				mProxies[k] = mTree.CreateProxy(GetBox(k), ToUserData(k));
+			}
+		}
+
+		int GetCount() const { return static_cast<int>(mCenters.size()); }
+		AABB GetBox(int i) const { return AABB::FromSphere(mCenters[i], mRadii[i]); }
+		int GetIndex(int proxy) const { return static_cast<int>(reinterpret_cast<size_t>(mTree.GetUserData(proxy))); }
+		static void* ToUserData(int i) { return reinterpret_cast<void*>(static_cast<size_t>(i)); }
+
+		// Fraction along start -> end where it enters sphere i, < 0 for a miss
+		float HitSphere(int i, const Vector3& start, const Vector3& end) const
+		{
+			Vector3 dir = end - start;
+			Vector3 m = start - mCenters[i];
+			float a = Vector3::Dot(dir, dir);
+			float b = Vector3::Dot(m, dir);
+			float c = Vector3::Dot(m, m) - mRadii[i] * mRadii[i];
+			float disc = b * b - a * c;
+			if (disc < 0.0f)
+			{
+				return -1.0f;
+			}
+			float t = (-b - Math::Sqrt(disc)) / a;
+			return (t >= 0.0f && t <= 1.0f) ? t : -1.0f;
+		}
+	};
+
+	Frustum MakeFrustum()
+	{
+		Matrix4 view = Matrix4::CreateLookAt(Vector3::Zero, Vector3::UnitX, Vector3::UnitZ);
+		Matrix4 proj = Matrix4::CreatePerspectiveFOV(Math::ToRadians(70.0f), 1024.0f, 768.0f, 25.0f, 10000.0f);
+		Frustum frustum;
+		frustum.SetFromViewProj(view * proj);
+		return frustum;
+	}
+}
+
+TEST(AABBTree_QueriesMatchBruteForce)
+{
+	Scene scene(2000, 11);
+	const int count = scene.GetCount();
+	CHECK(scene.mTree.GetProxyCount() == static_cast<size_t>(count));
+
+	// Frustum: the tree's candidates hold every visible sphere exactly once
+	Frustum frustum = MakeFrustum();
+	std::vector<int> found(count, 0);
+	scene.mTree.QueryFrustum(frustum, [&scene, &found](int proxy)
+	{
+		found[scene.GetIndex(proxy)]++;
+		return true;
+	});
+	bool frustumOk = true;
+	for (int i = 0; i < count; i++)
+	{
+		frustumOk = frustumOk && found[i] <= 1 &&
+			(!frustum.TestSphere(scene.mCenters[i], scene.mRadii[i]) || found[i] == 1);
+	}
+	CHECK(frustumOk);
+
+	// Sphere: same as testing every box
+	bool sphereOk = true;
+	for (int q = 0; q < 100; q++)
+	{
+		const Vector3& center = scene.mCenters[q * 7];
+		std::fill(found.begin(), found.end(), 0);
+		scene.mTree.QuerySphere(center, 60.0f, [&scene, &found](int proxy)
+		{
+			found[scene.GetIndex(proxy)]++;
+			return true;
+		});
+		for (int i = 0; i < count; i++)
+		{
+			// Fat boxes may add candidates, never lose one
+			sphereOk = sphereOk && found[i] <= 1 &&
+				(!scene.GetBox(i).OverlapsSphere(center, 60.0f) || found[i] == 1);
+		}
+	}
+	CHECK(sphereOk);
+
+	// Ray: the closest hit, as found by testing every sphere
+	std::mt19937 random(5);
+	std::uniform_real_distribution<float> across(-scene.mExtent, scene.mExtent);
+	std::uniform_real_distribution<float> rise(0.0f, 100.0f);
+	bool rayOk = true;
+	for (int q = 0; q < 200; q++)
+	{
+		Vector3 start(-scene.mExtent, across(random), across(random));
+		Vector3 end(scene.mExtent, start.y + rise(random), start.z);
+		float fraction = 0.0f;
+		int hit = scene.mTree.RayCast(start, end, [&scene, &start, &end](int proxy, float)
+		{
+			return scene.HitSphere(scene.GetIndex(proxy), start, end);
+		}, fraction);
+
+		float best = 2.0f;
+		int bestIndex = -1;
+		for (int i = 0; i < count; i++)
+		{
+			float t = scene.HitSphere(i, start, end);
+			if (t >= 0.0f && t < best)
+			{
+				best = t;
+				bestIndex = i;
+			}
+		}
+		rayOk = rayOk && (hit == AABBTree::NullNode) == (bestIndex < 0) &&
+			(bestIndex < 0 || std::fabs(best - fraction) <= 1.0e-5f);
+	}
+	CHECK(rayOk);
+
+	// Everything can be taken out again
+	for (int proxy : scene.mProxies)
+	{
+		scene.mTree.DestroyProxy(proxy);
+	}
+	CHECK(scene.mTree.GetProxyCount() == 0);
+	CHECK(scene.mTree.GetHeight() == -1);
+}
+
+BENCH(AABBTree_VersusBruteForce)
+{
+	// One frustum cull and 1000 sphere queries, against testing every sphere
+	Frustum frustum = MakeFrustum();
+	const int counts[] = { 1000, 10000, 100000 };
+	for (int count : counts)
+	{
+		Scene scene(count, static_cast<unsigned int>(count));
+		size_t visible = 0;
+		double treeFrustum = EngineTests::BestOf(5, [&scene, &frustum, &visible]()
+		{
+			visible = 0;
+			scene.mTree.QueryFrustum(frustum, [&scene, &frustum, &visible](int proxy)
+			{
+				int i = scene.GetIndex(proxy);
+				visible += frustum.TestSphere(scene.mCenters[i], scene.mRadii[i]) ? 1 : 0;
+				return true;
+			});
+		});
+		size_t bruteVisible = 0;
+		double bruteFrustum = EngineTests::BestOf(5, [&scene, &frustum, &bruteVisible]()
+		{
+			bruteVisible = 0;
+			for (int i = 0; i < scene.GetCount(); i++)
+			{
+				bruteVisible += frustum.TestSphere(scene.mCenters[i], scene.mRadii[i]) ? 1 : 0;
+			}
+		});
+
+		size_t candidates = 0;
+		double treeSpheres = EngineTests::BestOf(3, [&scene, &candidates]()
+		{
+			candidates = 0;
+			for (int q = 0; q < 1000; q++)
+			{
+				scene.mTree.QuerySphere(scene.mCenters[q % scene.GetCount()], 60.0f, [&candidates](int)
+				{
+					candidates++;
+					return true;
+				});
+			}
+		});
+		size_t overlaps = 0;
+		double bruteSpheres = EngineTests::BestOf(3, [&scene, &overlaps]()
+		{
+			overlaps = 0;
+			for (int q = 0; q < 1000; q++)
+			{
+				const Vector3& center = scene.mCenters[q % scene.GetCount()];
+				for (int i = 0; i < scene.GetCount(); i++)
+				{
+					overlaps += scene.GetBox(i).OverlapsSphere(center, 60.0f) ? 1 : 0;
+				}
+			}
+		});
+
+		std::printf("  %d proxies, height %d: frustum tree %.3f ms, brute %.3f ms (%zu/%zu visible)\n",
+			count, scene.mTree.GetHeight(), treeFrustum, bruteFrustum, visible, bruteVisible);
+		std::printf("    1000 sphere queries tree %.3f ms, brute %.3f ms (%zu candidates, %zu overlaps)\n",
+			treeSpheres, bruteSpheres, candidates, overlaps);
+	}
+}
@@ -0,0 +1,184 @@
+#include"Test.h"
+#include"Game.h"
+#include"Renderer.h"
+#include"SDL.h"
+#include"SOIL.h"
+#include"glew.h"
+#include<cstdio>
+#include<fstream>
+#include<string>
+#include<vector>
+
+// Loading needs a window and GL context: the benchmark opens one through
+// the Renderer, from the game's directory (EngineTests' debugger working
+// directory) so the shaders are found. Without video it is skipped.
+
+namespace
+{
+	const int NumTextures = 24;
+	const int TextureSize = 512;
+	const int NumMeshes = 24;
+	// Grid of GridSize x GridSize vertices
+	const int GridSize = 80;
+
+	std::string GetTextureName(int i)
+	{
+		char name[64];
+		std::snprintf(name, sizeof(name), "LoadBench_%02d.tga", i);
+		return name;
+	}
+
+	std::string GetMeshName(int i)
+	{
+		char name[64];
+		std::snprintf(name, sizeof(name), "LoadBench_%02d.gpmesh", i);
+		return name;
+	}
+
+	// RGB noise, so nothing is cheaper to decode than a real image
+	bool WriteTexture(const std::string& fileName, unsigned int seed)
+	{
+		std::vector<unsigned char> pixels(TextureSize * TextureSize * 3);
+		for (unsigned char& pixel : pixels)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			pixel = static_cast<unsigned char>(seed >> 24);
+		}
+		return SOIL_save_image(fileName.c_str(), SOIL_SAVE_TYPE_TGA, TextureSize, TextureSize, 3, pixels.data()) != 0;
+	}
+
+	// A wavy grid in the gpmesh format, on texture
+	bool WriteMesh(const std::string& fileName, const std::string& texture, int index)
+	{
+		std::ofstream file(fileName);
+		file << "{\n\t\"version\":1,\n\t\"vertexformat\":\"PosNormTex\",\n\t\"shader\":\"BasicMesh\",\n";
+		file << "\t\"textures\":[\n\t\t\"" << texture << "\"\n\t],\n\t\"specularPower\":100.0,\n\t\"vertices\":[\n";
+		for (int y = 0; y < GridSize; y++)
+		{
+			for (int x = 0; x < GridSize; x++)
+			{
+				float u = static_cast<float>(x) / (GridSize - 1);
+				float v = static_cast<float>(y) / (GridSize - 1);
+				float z = Math::Sin(u * 6.0f + index) * Math::Cos(v * 6.0f) * 0.1f;
+				file << "\t\t[" << u - 0.5f << "," << v - 0.5f << "," << z << ",0,0,1," << u << "," << -v << "]";
+				file << (x == GridSize - 1 && y == GridSize - 1 ? "\n" : ",\n");
+			}
+		}
+		file << "\t],\n\t\"indices\":[\n";
+		for (int y = 0; y < GridSize - 1; y++)
+		{
+			for (int x = 0; x < GridSize - 1; x++)
+			{
+				int i = y * GridSize + x;
+				file << "\t\t[" << i << "," << i + 1 << "," << i + GridSize + 1 << "],\n";
+				file << "\t\t[" << i << "," << i + GridSize + 1 << "," << i + GridSize << "]";
+				file << (x == GridSize - 2 && y == GridSize - 2 ? "\n" : ",\n");
+			}
+		}
+		file << "\t]\n}\n";
+		return file.good();
+	}
+
+	void RemoveAssets()
+	{
+		for (int i = 0; i < NumTextures; i++)
+		{
+			std::remove(GetTextureName(i).c_str());
+		}
+		for (int i = 0; i < NumMeshes; i++)
+		{
+			std::remove(GetMeshName(i).c_str());
+		}
+	}
+}
+
+BENCH(AssetLoader_LoadTime)
+{
+	// LoadData's stall loading every asset on the calling thread, against
+	// queueing them on the AssetLoader and uploading a budget per frame
+	if (SDL_Init(SDL_INIT_VIDEO) != 0)
+	{
+		std::printf("  skipped, no video: %s\n", SDL_GetError());
+		return;
+	}
+	bool written = true;
+	for (int i = 0; i < NumTextures; i++)
+	{
+		written = written && WriteTexture(GetTextureName(i), static_cast<unsigned int>(i));
+	}
+	for (int i = 0; i < NumMeshes; i++)
+	{
+		written = written && WriteMesh(GetMeshName(i), GetTextureName(i % NumTextures), i);
+	}
+	// Only the renderer is needed, no game data
+	Game game;
+	game.InitializeHeadless();
+	Renderer* renderer = game.GetRenderer();
+	if (!written || !renderer->Initialize(1024.0f, 768.0f))
+	{
+		std::printf("  skipped, %s\n", written ? "no GL context or shaders" : "can't write the assets");
+		RemoveAssets();
+		game.ShutDown();
+		return;
+	}
+	std::printf("  %d %dx%d textures, %d meshes of %d vertices\n", NumTextures, TextureSize, TextureSize,
+		NumMeshes, GridSize * GridSize);
+
+	EngineTests::Timer timer;
+	for (int i = 0; i < NumTextures; i++)
+	{
+		renderer->GetTexture(GetTextureName(i));
+	}
+	for (int i = 0; i < NumMeshes; i++)
+	{
+		renderer->GetMesh(GetMeshName(i));
+	}
+	glFinish();
+	std::printf("  sync: %.1f ms before the first frame\n", timer.GetMilliseconds());
+	renderer->UnloadData();
+
+	// Frames draw while the rest loads, each uploading within the budget
+	timer.Reset();
+	for (int i = 0; i < NumTextures; i++)
+	{
+		renderer->GetTextureAsync(GetTextureName(i));
+	}
+	for (int i = 0; i < NumMeshes; i++)
+	{
+		renderer->GetMeshAsync(GetMeshName(i));
+	}
+	double queued = timer.GetMilliseconds();
+	int frames = 0;
+	double worstFrame = 0.0;
+	while (renderer->GetNumPendingAssets() > 0)
+	{
+		EngineTests::Timer frame;
+		renderer->Draw();
+		frames++;
+		worstFrame = frame.GetMilliseconds() > worstFrame ? frame.GetMilliseconds() : worstFrame;
+	}
+	glFinish();
+	std::printf("  async: %.1f ms before the first frame, all in after %.1f ms and %d frames (worst %.1f ms%s)\n",
+		queued, timer.GetMilliseconds(), frames, worstFrame, renderer->IsVSync() ? ", vsync" : "");
+	renderer->UnloadData();
+
+	// A loading screen waiting for everything
+	timer.Reset();
+	for (int i = 0; i < NumTextures; i++)
+	{
+		renderer->GetTextureAsync(GetTextureName(i));
+	}
+	for (int i = 0; i < NumMeshes; i++)
+	{
+		renderer->GetMeshAsync(GetMeshName(i));
+	}
+	renderer->FinishLoading();
+	glFinish();
+	std::printf("  async with FinishLoading: %.1f ms\n", timer.GetMilliseconds());
+
+	// The headless game doesn't shut the renderer down itself
+	renderer->UnloadData();
+	renderer->Shutdown();
+	RemoveAssets();
+	game.ShutDown();
+}
@@ -0,0 +1,196 @@
+#include"Test.h"
+#include"AtlasPacker.h"
+#include<random>
+#include<vector>
+
+namespace
+{
+	bool Contains(const AtlasRect& outer, const AtlasRect& inner)
+	{
+		return inner.mX >= outer.mX && inner.mY >= outer.mY &&
+			inner.mX + inner.mWidth <= outer.mX + outer.mWidth &&
+			inner.mY + inner.mHeight <= outer.mY + outer.mHeight;
+	}
+
+	bool Overlaps(const AtlasRect& a, const AtlasRect& b)
+	{
+		return a.mX < b.mX + b.mWidth && b.mX < a.mX + a.mWidth &&
+			a.mY < b.mY + b.mHeight && b.mY < a.mY + a.mHeight;
+	}
+
+	bool InBounds(const AtlasPacker& packer, const AtlasRect& rect)
+	{
+		return rect.mX >= 0 && rect.mY >= 0 && rect.mWidth > 0 && rect.mHeight > 0 &&
+			rect.mX + rect.mWidth <= packer.GetWidth() && rect.mY + rect.mHeight <= packer.GetHeight();
+	}
+
+	// Free rectangles are in the page, clear of last and pruned
+	bool CheckFreeRects(const AtlasPacker& packer, const AtlasRect& last)
+	{
+		bool ok = true;
+		const std::vector<AtlasRect>& free = packer.GetFreeRects();
+		for (size_t i = 0; i < free.size(); i++)
+		{
+			ok = ok && InBounds(packer, free[i]) && !Overlaps(free[i], last);
+			// No free rectangle inside another, equal ones included
+			for (size_t j = 0; j < free.size(); j++)
+			{
+				ok = ok && (i == j || !Contains(free[j], free[i]));
+			}
+		}
+		return ok;
+	}
+
+	// Placed rectangles are in the page, apart and add up to the used area
+	bool CheckPlaced(const AtlasPacker& packer, const std::vector<AtlasRect>& placed)
+	{
+		bool ok = true;
+		int64_t area = 0;
+		for (size_t i = 0; i < placed.size(); i++)
+		{
+			ok = ok && InBounds(packer, placed[i]);
+			area += static_cast<int64_t>(placed[i].mWidth) * placed[i].mHeight;
+			for (size_t j = i + 1; j < placed.size(); j++)
+			{
+				ok = ok && !Overlaps(placed[i], placed[j]);
+			}
+		}
+		return ok && area == packer.GetUsedArea();
+	}
+}
+
+TEST(AtlasPacker_RandomInsertsStayValid)
+{
+	std::mt19937 random(1234);
+	// Small pages of small and large images, the free rectangles are
+	// checked after every insert
+	for (int page = 0; page < 300; page++)
+	{
+		int width = 16 + static_cast<int>(random() % 113);
+		int height = 16 + static_cast<int>(random() % 113);
+		int maxSide = 4 + static_cast<int>(random() % 45);
+		AtlasPacker packer(width, height);
+		std::vector<AtlasRect> placed;
+		int failures = 0;
+		bool ok = true;
+		while (failures < 20 && ok)
+		{
+			int w = 1 + static_cast<int>(random() % maxSide);
+			int h = 1 + static_cast<int>(random() % maxSide);
+			AtlasRect rect;
+			if (!packer.Insert(w, h, rect))
+			{
+				failures++;
+				continue;
+			}
+			ok = rect.mWidth == w && rect.mHeight == h;
+			placed.emplace_back(rect);
+			ok = ok && CheckFreeRects(packer, rect);
+		}
+		CHECK(ok);
+		CHECK(CheckPlaced(packer, placed));
+	}
+}
+
+TEST(AtlasPacker_SameSizeTiles)
+{
+	// Equal sized images leave equal sized gaps, where several splits cut
+	// out the same free space
+	const int sizes[] = { 1, 3, 16, 17 };
+	for (int size : sizes)
+	{
+		AtlasPacker packer(64, 64);
+		std::vector<AtlasRect> placed;
+		AtlasRect rect;
+		while (packer.Insert(size, size, rect))
+		{
+			placed.emplace_back(rect);
+		}
+		CHECK(CheckPlaced(packer, placed));
+		CHECK(CheckFreeRects(packer, placed.back()));
+		int perSide = 64 / size;
+		CHECK(placed.size() == static_cast<size_t>(perSide * perSide));
+	}
+}
+
+TEST(AtlasPacker_InsertFailsWhenFull)
+{
+	AtlasPacker packer(64, 64);
+	AtlasRect rect;
+	CHECK(!packer.Insert(65, 1, rect));
+	CHECK(!packer.Insert(1, 65, rect));
+	CHECK(!packer.Insert(0, 8, rect));
+	CHECK(!packer.Insert(8, -1, rect));
+	CHECK(packer.GetUsedArea() == 0);
+
+	for (int i = 0; i < 16; i++)
+	{
+		CHECK(packer.Insert(16, 16, rect));
+	}
+	CHECK(!packer.Insert(16, 16, rect));
+	CHECK(!packer.Insert(1, 1, rect));
+	CHECK(packer.GetNumFreeRects() == 0);
+
+	// Room again after Reset
+	packer.Reset();
+	CHECK(packer.GetUsedArea() == 0);
+	CHECK(packer.Insert(64, 64, rect));
+	CHECK(rect.mX == 0 && rect.mY == 0);
+	CHECK(!packer.Insert(1, 1, rect));
+}
+
+TEST(AtlasPacker_Occupancy)
+{
+	AtlasPacker packer(256, 128);
+	CHECK(packer.GetOccupancy() == 0.0f);
+	AtlasRect rect;
+	CHECK(packer.Insert(128, 128, rect));
+	CHECK(packer.GetOccupancy() == 0.5f);
+	CHECK(packer.Insert(64, 32, rect));
+	CHECK(packer.GetUsedArea() == 128 * 128 + 64 * 32);
+	CHECK_NEAR(packer.GetOccupancy(), (128.0f * 128.0f + 64.0f * 32.0f) / (256.0f * 128.0f), 1.0e-6f);
+	// Failed inserts don't count
+	CHECK(!packer.Insert(256, 1, rect));
+	CHECK(packer.GetUsedArea() == 128 * 128 + 64 * 32);
+	CHECK(packer.Insert(128, 96, rect));
+	CHECK(packer.Insert(64, 32, rect));
+	CHECK(packer.GetOccupancy() == 1.0f);
+}
+
+BENCH(AtlasPacker_FillPage)
+{
+	// Images inserted into a 2048 page until 50 in a row don't fit
+	struct Case
+	{
+		const char* mName;
+		int mMinSide;
+		int mMaxSide;
+	};
+	const Case cases[] = { { "8-128 px", 8, 128 }, { "16-32 px", 16, 32 }, { "8-512 px", 8, 512 } };
+	for (const Case& c : cases)
+	{
+		size_t images = 0;
+		float occupancy = 0.0f;
+		double ms = EngineTests::BestOf(3, [&c, &images, &occupancy]()
+		{
+			std::mt19937 random(7);
+			std::uniform_int_distribution<int> side(c.mMinSide, c.mMaxSide);
+			AtlasPacker packer(2048, 2048);
+			AtlasRect rect;
+			images = 0;
+			for (int failures = 0; failures < 50;)
+			{
+				if (packer.Insert(side(random), side(random), rect))
+				{
+					images++;
+				}
+				else
+				{
+					failures++;
+				}
+			}
+			occupancy = packer.GetOccupancy();
+		});
+		std::printf("  %s: %zu images, %.1f%% used, %.2f ms\n", c.mName, images, occupancy * 100.0f, ms);
+	}
+}
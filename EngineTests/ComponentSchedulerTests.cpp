@@ -0,0 +1,154 @@
+#include"Test.h"
+#include"Game.h"
+#include"Actor.h"
+#include"Component.h"
+#include<atomic>
+#include<vector>
+
+namespace
+{
+	// Every update takes the next ticket, so tickets give the order
+	// updates ran in, across threads
+	std::atomic<int> NextTicket(0);
+
+	class TicketComponent : public Component
+	{
+	public:
+		TicketComponent(Actor* owner, int updateOrder, bool exclusive)
+			:Component(owner, updateOrder)
+			, mExclusive(exclusive)
+			, mTicket(-1)
+			, mUpdates(0)
+		{
+		}
+		void Update(float deltaTime) override
+		{
+			mTicket = NextTicket++;
+			mUpdates++;
+		}
+		ComponentAccess GetAccess() const override
+		{
+			return mExclusive ? ComponentAccess::Exclusive() : ComponentAccess::Owner(0, ComponentData::ESprite);
+		}
+		int GetTicket() const { return mTicket; }
+		int GetUpdates() const { return mUpdates; }
+
+	private:
+		bool mExclusive;
+		int mTicket;
+		int mUpdates;
+	};
+
+	class TicketActor : public Actor
+	{
+	public:
+		TicketActor(Game* game)
+			:Actor(game)
+			, mTicket(-1)
+			, mSpawnOnUpdate(false)
+			, mSpawned(nullptr)
+		{
+		}
+		void UpdateActor(float deltaTime) override
+		{
+			mTicket = NextTicket++;
+			if (mSpawnOnUpdate && !mSpawned)
+			{
+				mSpawned = new TicketComponent(this, 350, false);
+			}
+		}
+		int GetTicket() const { return mTicket; }
+		void SetSpawnOnUpdate() { mSpawnOnUpdate = true; }
+		TicketComponent* GetSpawned() const { return mSpawned; }
+
+	private:
+		int mTicket;
+		// Adds a component from UpdateActor
+		bool mSpawnOnUpdate;
+		TicketComponent* mSpawned;
+	};
+}
+
+TEST(ComponentScheduler_UpdateActorAfterOwnComponents)
+{
+	// Owner only components at order 100 (a parallel step), exclusive
+	// ones at 200 (a serial step), both, or none. Owner only ones at 300
+	// and 400 share the last, parallel, step
+	Game game;
+	game.InitializeHeadless();
+	std::vector<TicketActor*> owners;
+	std::vector<TicketComponent*> ownerComps;
+	std::vector<TicketActor*> exclusives;
+	std::vector<TicketComponent*> exclusiveComps;
+	for (int i = 0; i < 500; i++)
+	{
+		owners.emplace_back(new TicketActor(&game));
+		ownerComps.emplace_back(new TicketComponent(owners.back(), 100, false));
+		exclusives.emplace_back(new TicketActor(&game));
+		exclusiveComps.emplace_back(new TicketComponent(exclusives.back(), 200, true));
+	}
+	TicketActor* mixed = new TicketActor(&game);
+	TicketComponent* mixedOwner = new TicketComponent(mixed, 100, false);
+	TicketComponent* mixedExclusive = new TicketComponent(mixed, 200, true);
+	TicketActor* bare = new TicketActor(&game);
+	TicketActor* late = new TicketActor(&game);
+	new TicketComponent(late, 300, false);
+	new TicketComponent(late, 400, false);
+	owners[0]->SetSpawnOnUpdate();
+	game.UpdateGame(1.0f / 60.0f);
+
+	// Owner actors update once the parallel step is done, before the
+	// serial step
+	int lastOwnerComp = -1;
+	int firstExclusiveComp = NextTicket;
+	bool ownersOk = true;
+	for (size_t i = 0; i < owners.size(); i++)
+	{
+		lastOwnerComp = ownerComps[i]->GetTicket() > lastOwnerComp ? ownerComps[i]->GetTicket() : lastOwnerComp;
+		firstExclusiveComp = exclusiveComps[i]->GetTicket() < firstExclusiveComp ? exclusiveComps[i]->GetTicket() : firstExclusiveComp;
+		ownersOk = ownersOk && ownerComps[i]->GetTicket() >= 0;
+	}
+	for (TicketActor* owner : owners)
+	{
+		ownersOk = ownersOk && owner->GetTicket() > lastOwnerComp && owner->GetTicket() < firstExclusiveComp;
+	}
+	CHECK(ownersOk);
+
+	// In the serial step each actor updates right after its component,
+	// as Actor::Update did
+	bool exclusivesOk = true;
+	for (size_t i = 0; i < exclusives.size(); i++)
+	{
+		exclusivesOk = exclusivesOk && exclusives[i]->GetTicket() == exclusiveComps[i]->GetTicket() + 1;
+	}
+	CHECK(exclusivesOk);
+	CHECK(mixedOwner->GetTicket() < mixedExclusive->GetTicket());
+	CHECK(mixed->GetTicket() == mixedExclusive->GetTicket() + 1);
+	CHECK(bare->GetTicket() == NextTicket - 1);
+
+	// A component added during the update waits for the next one, even
+	// when its order is within a step still to come
+	TicketComponent* spawned = owners[0]->GetSpawned();
+	CHECK(spawned != nullptr && spawned->GetUpdates() == 0);
+	game.UpdateGame(1.0f / 60.0f);
+	CHECK(spawned != nullptr && spawned->GetUpdates() == 1);
+	game.ShutDown();
+}
+
+TEST(ComponentScheduler_ActorUpdateStillWorks)
+{
+	// Gameplay code may still update an actor by itself
+	Game game;
+	game.InitializeHeadless();
+	TicketActor* actor = new TicketActor(&game);
+	TicketComponent* late = new TicketComponent(actor, 200, false);
+	TicketComponent* early = new TicketComponent(actor, 100, true);
+	actor->Update(1.0f / 60.0f);
+	CHECK(early->GetTicket() < late->GetTicket());
+	CHECK(actor->GetTicket() == late->GetTicket() + 1);
+
+	actor->SetState(Actor::State::EPaused);
+	actor->Update(1.0f / 60.0f);
+	CHECK(early->GetUpdates() == 1 && late->GetUpdates() == 1);
+	game.ShutDown();
+}
@@ -0,0 +1,242 @@
+#include"Test.h"
+#include"JobSystem.h"
+#include<algorithm>
+#include<atomic>
+#include<mutex>
+#include<vector>
+
+namespace
+{
+	// Tests run on every one of these, 0 runs all jobs inside Wait
+	const unsigned int WorkerCounts[] = { 0, 1, 3, 7 };
+}
+
+TEST(JobSystem_ParallelForCoversEachIndexOnce)
+{
+	for (unsigned int workers : WorkerCounts)
+	{
+		JobSystem jobs(workers);
+		// Grains that divide the range evenly, don't, and exceed MaxRanges
+		const size_t grains[] = { 1, 97, 1000, 200000 };
+		for (size_t grain : grains)
+		{
+			std::vector<std::atomic<int>> hits(100000);
+			for (std::atomic<int>& hit : hits)
+			{
+				hit = 0;
+			}
+			jobs.ParallelFor(0, hits.size(), grain, [&hits](size_t first, size_t last)
+			{
+				for (size_t i = first; i < last; i++)
+				{
+					hits[i]++;
+				}
+			});
+			bool once = true;
+			for (const std::atomic<int>& hit : hits)
+			{
+				once = once && hit.load() == 1;
+			}
+			CHECK(once);
+		}
+
+		// Offset and empty ranges
+		std::atomic<size_t> covered(0);
+		jobs.ParallelFor(10, 20, 3, [&covered](size_t first, size_t last)
+		{
+			CHECK(first >= 10 && last <= 20 && first < last);
+			covered += last - first;
+		});
+		CHECK(covered.load() == 10);
+		bool called = false;
+		jobs.ParallelFor(5, 5, 10, [&called](size_t, size_t) { called = true; });
+		CHECK(!called);
+	}
+}
+
+TEST(JobSystem_DependencyChainRunsInOrder)
+{
+	for (unsigned int workers : WorkerCounts)
+	{
+		JobSystem jobs(workers);
+		const int count = 20;
+		std::mutex mutex;
+		std::vector<int> order;
+		JobHandle chain[count];
+		for (int i = 0; i < count; i++)
+		{
+			chain[i] = jobs.Create([&mutex, &order, i]()
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				order.emplace_back(i);
+			});
+		}
+		for (int i = 1; i < count; i++)
+		{
+			jobs.AddDependency(chain[i], chain[i - 1]);
+		}
+		// Run the last first, nothing may start before its dependency
+		for (int i = count - 1; i >= 0; i--)
+		{
+			jobs.Run(chain[i]);
+		}
+		jobs.Wait(chain[count - 1]);
+		CHECK(order.size() == static_cast<size_t>(count));
+		for (size_t i = 0; i < order.size(); i++)
+		{
+			CHECK(order[i] == static_cast<int>(i));
+		}
+
+		// One job after many
+		std::atomic<int> finished(0);
+		int seen = -1;
+		JobHandle last = jobs.Create([&finished, &seen]() { seen = finished.load(); });
+		for (int i = 0; i < 64; i++)
+		{
+			JobHandle job = jobs.Create([&finished]() { finished++; });
+			jobs.AddDependency(last, job);
+			jobs.Run(job);
+		}
+		jobs.Run(last);
+		jobs.Wait(last);
+		CHECK(seen == 64);
+	}
+}
+
+TEST(JobSystem_ParentWaitsForNestedChildren)
+{
+	for (unsigned int workers : WorkerCounts)
+	{
+		JobSystem jobs(workers);
+		std::atomic<int> count(0);
+		JobHandle root = jobs.Create([&count]() { count++; });
+		for (int i = 0; i < 50; i++)
+		{
+			// Each child adds a grandchild to root while running
+			JobHandle child = jobs.Create([&jobs, &count, root]()
+			{
+				count++;
+				JobHandle grandchild = jobs.Create([&count]() { count++; }, root);
+				jobs.Run(grandchild);
+			}, root);
+			jobs.Run(child);
+		}
+		jobs.Run(root);
+		jobs.Wait(root);
+		CHECK(jobs.IsFinished(root));
+		CHECK(count.load() == 101);
+
+		// ParallelFor inside jobs
+		std::atomic<size_t> nested(0);
+		jobs.ParallelFor(0, 8, 1, [&jobs, &nested](size_t, size_t)
+		{
+			jobs.ParallelFor(0, 1000, 10, [&nested](size_t first, size_t last) { nested += last - first; });
+		});
+		CHECK(nested.load() == 8000);
+	}
+}
+
+TEST(JobSystem_DependencyOnFinishedJob)
+{
+	for (unsigned int workers : WorkerCounts)
+	{
+		JobSystem jobs(workers);
+		JobHandle done = jobs.Create([]() {});
+		jobs.Run(done);
+		jobs.Wait(done);
+		CHECK(jobs.IsFinished(done));
+
+		bool ran = false;
+		JobHandle after = jobs.Create([&ran]() { ran = true; });
+		jobs.AddDependency(after, done);
+		jobs.Run(after);
+		jobs.Wait(after);
+		CHECK(ran);
+	}
+}
+
+TEST(JobSystem_RingWrapsAround)
+{
+	for (unsigned int workers : WorkerCounts)
+	{
+		JobSystem jobs(workers);
+		// Several times the ring in batches of half of it, each batch
+		// reuses slots of finished jobs
+		const size_t batch = JobSystem::MaxJobs / 2;
+		const size_t batches = 7;
+		std::atomic<size_t> ran(0);
+		std::vector<JobHandle> handles(batch);
+		for (size_t b = 0; b < batches; b++)
+		{
+			JobHandle root = jobs.Create([]() {});
+			for (size_t i = 0; i < batch - 1; i++)
+			{
+				handles[i] = jobs.Create([&ran]() { ran++; }, root);
+				jobs.Run(handles[i]);
+			}
+			jobs.Run(root);
+			jobs.Wait(root);
+			for (size_t i = 0; i < batch - 1; i++)
+			{
+				CHECK(jobs.IsFinished(handles[i]));
+			}
+		}
+		CHECK(ran.load() == batches * (batch - 1));
+
+		// ParallelFor at its finest grain, many frames
+		std::atomic<size_t> covered(0);
+		for (int frame = 0; frame < 100; frame++)
+		{
+			jobs.ParallelFor(0, 20000, 1, [&covered](size_t first, size_t last) { covered += last - first; });
+		}
+		CHECK(covered.load() == 100 * 20000);
+	}
+}
+
+BENCH(JobSystem_WorkerScaling)
+{
+	// CPU bound work over 1M elements, serial and then on 1..N threads
+	// (the calling thread plus 0..N-1 workers)
+	const size_t count = 1 << 20;
+	std::vector<float> out(count);
+	auto work = [&out](size_t first, size_t last)
+	{
+		for (size_t i = first; i < last; i++)
+		{
+			float x = static_cast<float>(i) * 0.001f;
+			for (int k = 0; k < 20; k++)
+			{
+				x = std::sin(x) + std::cos(x);
+			}
+			out[i] = x;
+		}
+	};
+	double serial = EngineTests::BestOf(3, [&work]() { work(0, count); });
+	std::printf("  serial: %.2f ms\n", serial);
+
+	unsigned int threads = std::max(std::thread::hardware_concurrency(), 1u);
+	for (unsigned int workers = 0; workers < threads; workers++)
+	{
+		JobSystem jobs(workers);
+		double ms = EngineTests::BestOf(5, [&jobs, &work]() { jobs.ParallelFor(0, count, 4096, work); });
+		std::printf("  %u threads: %.2f ms (x%.2f)\n", workers + 1, ms, serial / ms);
+	}
+
+	// Cost of a job: a parent with 100 children, run and waited
+	JobSystem jobs(0);
+	const int frames = 1000;
+	double ms = EngineTests::BestOf(3, [&jobs]()
+	{
+		for (int frame = 0; frame < frames; frame++)
+		{
+			JobHandle root = jobs.Create([]() {});
+			for (int i = 0; i < 100; i++)
+			{
+				jobs.Run(jobs.Create([]() {}, root));
+			}
+			jobs.Run(root);
+			jobs.Wait(root);
+		}
+	});
+	std::printf("  job overhead: %.0f ns per job\n", ms * 1.0e6 / (frames * 101));
+}
@@ -0,0 +1,74 @@
+#include<cstdio>
+#include<cstring>
+#include"Test.h"
+
+// Unit tests and benchmarks of the engine's subsystems.
+//
+// Usage:
+//   EngineTests [filter]
+//     Run every test whose name contains filter (all without one),
+//     the exit code is the number of failed tests
+//   EngineTests -bench [filter]
+//     Run the matching benchmarks instead. Build Release for numbers
+//     worth comparing.
+
+namespace
+{
+	int checkFailures = 0;
+}
+
+namespace EngineTests
+{
+	std::vector<TestCase>& GetTestCases()
+	{
+		// Function local, registrars run during static initialization
+		static std::vector<TestCase> testCases;
+		return testCases;
+	}
+
+	void ReportFailure(const char* file, int line, const char* expression)
+	{
+		std::printf("  %s(%d): CHECK failed: %s\n", file, line, expression);
+		checkFailures++;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	bool bench = false;
+	const char* filter = "";
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::strcmp(argv[i], "-bench") == 0)
+		{
+			bench = true;
+		}
+		else
+		{
+			filter = argv[i];
+		}
+	}
+
+	int run = 0;
+	int failed = 0;
+	for (const EngineTests::TestCase& test : EngineTests::GetTestCases())
+	{
+		if (test.mIsBench != bench || std::strstr(test.mName, filter) == nullptr)
+		{
+			continue;
+		}
+		std::printf("[%s] %s\n", bench ? "BENCH" : "TEST", test.mName);
+		std::fflush(stdout);
+		int before = checkFailures;
+		test.mFunction();
+		run++;
+		if (checkFailures != before)
+		{
+			std::printf("  FAILED\n");
+			failed++;
+		}
+	}
+
+	std::printf("%d %s run, %d failed\n", run, bench ? "benchmarks" : "tests", failed);
+	return failed;
+}
@@ -0,0 +1,239 @@
+#include"Test.h"
+#include"MathBatch.h"
+#include"Frustum.h"
+#include<random>
+#include<vector>
+
+// Each MathBatch kernel against looping over the one-at-a-time function
+// in Math.h it replaces.
+
+namespace
+{
+	// Not a multiple of the SIMD width, so the scalar tails run too
+	const size_t Count = 10003;
+
+	struct BatchData
+	{
+		MathBatch::FloatArray mX;
+		MathBatch::FloatArray mY;
+		MathBatch::FloatArray mZ;
+		MathBatch::FloatArray mW;
+		MathBatch::FloatArray mRadius;
+		std::vector<Vector3> mPoints;
+		std::vector<Quaternion> mQuaternions;
+		std::vector<Matrix4> mMatrices;
+		Matrix4 mTransform;
+		Frustum mFrustum;
+
+		BatchData()
+		{
+			std::mt19937 random(17);
+			std::uniform_real_distribution<float> position(-1000.0f, 1000.0f);
+			std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+			std::uniform_real_distribution<float> radius(1.0f, 50.0f);
+			for (size_t i = 0; i < Count; i++)
+			{
+				Vector3 point(position(random), position(random), position(random));
+				mPoints.emplace_back(point);
+				mX.emplace_back(point.x);
+				mY.emplace_back(point.y);
+				mZ.emplace_back(point.z);
+				mRadius.emplace_back(radius(random));
+
+				Quaternion q(unit(random), unit(random), unit(random), unit(random));
+				q.Normalize();
+				mQuaternions.emplace_back(q);
+				mW.emplace_back(q.w);
+
+				mMatrices.emplace_back(Matrix4::CreateScale(radius(random)) * Matrix4::CreateFromQuaternion(q) *
+					Matrix4::CreateTranslation(point));
+			}
+			mTransform = Matrix4::CreateRotationY(0.7f) * Matrix4::CreateTranslation(Vector3(5.0f, -3.0f, 20.0f));
+
+			Matrix4 view = Matrix4::CreateLookAt(Vector3::Zero, Vector3::UnitX, Vector3::UnitZ);
+			Matrix4 proj = Matrix4::CreatePerspectiveFOV(Math::ToRadians(70.0f), 1024.0f, 768.0f, 25.0f, 10000.0f);
+			mFrustum.SetFromViewProj(view * proj);
+		}
+	};
+
+	const BatchData& GetData()
+	{
+		static BatchData data;
+		return data;
+	}
+
+	// Quaternion components of the data, as the kernel reads them
+	void GetQuaternionArrays(const BatchData& data, MathBatch::FloatArray& x, MathBatch::FloatArray& y,
+		MathBatch::FloatArray& z)
+	{
+		for (const Quaternion& q : data.mQuaternions)
+		{
+			x.emplace_back(q.x);
+			y.emplace_back(q.y);
+			z.emplace_back(q.z);
+		}
+	}
+
+	bool MatricesEqual(const Matrix4& a, const Matrix4& b, float tolerance)
+	{
+		bool equal = true;
+		for (int row = 0; row < 4; row++)
+		{
+			for (int col = 0; col < 4; col++)
+			{
+				equal = equal && std::fabs(a.matrix[row][col] - b.matrix[row][col]) <= tolerance;
+			}
+		}
+		return equal;
+	}
+}
+
+TEST(MathBatch_TransformPointsMatchesTransform)
+{
+	const BatchData& data = GetData();
+	MathBatch::FloatArray x(Count), y(Count), z(Count);
+	MathBatch::TransformPoints(data.mX.data(), data.mY.data(), data.mZ.data(), Count, data.mTransform,
+		x.data(), y.data(), z.data());
+	bool equal = true;
+	for (size_t i = 0; i < Count; i++)
+	{
+		Vector3 expected = Vector3::Transform(data.mPoints[i], data.mTransform);
+		equal = equal && x[i] == expected.x && y[i] == expected.y && z[i] == expected.z;
+	}
+	CHECK(equal);
+
+	// In place gives the same
+	MathBatch::FloatArray inX(data.mX), inY(data.mY), inZ(data.mZ);
+	MathBatch::TransformPoints(inX.data(), inY.data(), inZ.data(), Count, data.mTransform,
+		inX.data(), inY.data(), inZ.data());
+	CHECK(inX == x && inY == y && inZ == z);
+}
+
+TEST(MathBatch_MultiplyMatricesMatchesMultiply)
+{
+	const BatchData& data = GetData();
+	std::vector<Matrix4> out(Count);
+	MathBatch::MultiplyMatrices(data.mMatrices.data(), Count, data.mTransform, out.data());
+	bool equal = true;
+	for (size_t i = 0; i < Count; i++)
+	{
+		equal = equal && MatricesEqual(out[i], data.mMatrices[i] * data.mTransform, 0.0f);
+	}
+	CHECK(equal);
+
+	std::vector<Matrix4> inPlace(data.mMatrices);
+	MathBatch::MultiplyMatrices(inPlace.data(), Count, data.mTransform, inPlace.data());
+	equal = true;
+	for (size_t i = 0; i < Count; i++)
+	{
+		equal = equal && MatricesEqual(inPlace[i], out[i], 0.0f);
+	}
+	CHECK(equal);
+}
+
+TEST(MathBatch_QuaternionsToMatricesMatchesCreateFromQuaternion)
+{
+	const BatchData& data = GetData();
+	MathBatch::FloatArray x, y, z;
+	GetQuaternionArrays(data, x, y, z);
+	std::vector<Matrix4> out(Count);
+	MathBatch::QuaternionsToMatrices(x.data(), y.data(), z.data(), data.mW.data(), Count, out.data());
+	bool equal = true;
+	for (size_t i = 0; i < Count; i++)
+	{
+		equal = equal && MatricesEqual(out[i], Matrix4::CreateFromQuaternion(data.mQuaternions[i]), 0.0f);
+	}
+	CHECK(equal);
+}
+
+TEST(MathBatch_SpheresInsidePlanesMatchesTestSphere)
+{
+	const BatchData& data = GetData();
+	SphereBatch spheres;
+	for (size_t i = 0; i < Count; i++)
+	{
+		spheres.Add(data.mPoints[i], data.mRadius[i]);
+	}
+	std::vector<uint8_t> visible;
+	size_t numVisible = data.mFrustum.CullSpheres(spheres, visible);
+	CHECK(visible.size() == Count);
+
+	size_t expectedVisible = 0;
+	bool equal = true;
+	for (size_t i = 0; i < Count; i++)
+	{
+		bool expected = data.mFrustum.TestSphere(data.mPoints[i], data.mRadius[i]);
+		expectedVisible += expected ? 1 : 0;
+		equal = equal && visible[i] == (expected ? 1 : 0);
+	}
+	CHECK(equal);
+	CHECK(numVisible == expectedVisible);
+	CHECK(numVisible > 0 && numVisible < Count);
+}
+
+BENCH(MathBatch_KernelThroughput)
+{
+	// Count elements per run, best of 20, against the per-element loop
+	const BatchData& data = GetData();
+	const int runs = 20;
+	auto report = [](const char* name, double batch, double loop)
+	{
+		std::printf("  %-22s %6.2f ns  loop %6.2f ns  (x%.2f)\n", name,
+			batch * 1.0e6 / Count, loop * 1.0e6 / Count, loop / batch);
+	};
+	std::printf("  ns per element\n");
+
+	MathBatch::FloatArray x(Count), y(Count), z(Count);
+	std::vector<Vector3> points(Count);
+	report("TransformPoints",
+		EngineTests::BestOf(runs, [&]() { MathBatch::TransformPoints(data.mX.data(), data.mY.data(), data.mZ.data(),
+			Count, data.mTransform, x.data(), y.data(), z.data()); }),
+		EngineTests::BestOf(runs, [&]()
+		{
+			for (size_t i = 0; i < Count; i++)
+			{
+				points[i] = Vector3::Transform(data.mPoints[i], data.mTransform);
+			}
+		}));
+
+	std::vector<Matrix4> matrices(Count);
+	report("MultiplyMatrices",
+		EngineTests::BestOf(runs, [&]() { MathBatch::MultiplyMatrices(data.mMatrices.data(), Count, data.mTransform,
+			matrices.data()); }),
+		EngineTests::BestOf(runs, [&]()
+		{
+			for (size_t i = 0; i < Count; i++)
+			{
+				matrices[i] = data.mMatrices[i] * data.mTransform;
+			}
+		}));
+
+	MathBatch::FloatArray qx, qy, qz;
+	GetQuaternionArrays(data, qx, qy, qz);
+	report("QuaternionsToMatrices",
+		EngineTests::BestOf(runs, [&]() { MathBatch::QuaternionsToMatrices(qx.data(), qy.data(), qz.data(),
+			data.mW.data(), Count, matrices.data()); }),
+		EngineTests::BestOf(runs, [&]()
+		{
+			for (size_t i = 0; i < Count; i++)
+			{
+				matrices[i] = Matrix4::CreateFromQuaternion(data.mQuaternions[i]);
+			}
+		}));
+
+	SphereBatch spheres;
+	for (size_t i = 0; i < Count; i++)
+	{
+		spheres.Add(data.mPoints[i], data.mRadius[i]);
+	}
+	std::vector<uint8_t> visible(Count);
+	report("SpheresInsidePlanes",
+		EngineTests::BestOf(runs, [&]() { data.mFrustum.CullSpheres(spheres, visible); }),
+		EngineTests::BestOf(runs, [&]()
+		{
+			for (size_t i = 0; i < Count; i++)
+			{
+				visible[i] = data.mFrustum.TestSphere(data.mPoints[i], data.mRadius[i]) ? 1 : 0;
+			}
+		}));
+}
@@ -0,0 +1,91 @@
+#include"MathReference.h"
+// Headers Math.h includes, before the renames below
+#include<cmath>
+#include<cstring>
+#include<limits>
+#include<memory.h>
+
+// Math.cpp (and with it Math.h) compiled with MATH_NO_SIMD, every type
+// renamed so they don't clash with the SIMD build the engine uses
+#define MATH_NO_SIMD
+#define Math ScalarMath
+#define Vector2 ScalarVector2
+#define Vector3 ScalarVector3
+#define Matrix3 ScalarMatrix3
+#define Matrix4 ScalarMatrix4
+#define Quaternion ScalarQuaternion
+#define Color ScalarColor
+#include"Math.cpp"
+
+namespace
+{
+	Matrix4 LoadMatrix(const float* m)
+	{
+		Matrix4 returnValue;
+		memcpy(returnValue.matrix, m, 16 * sizeof(float));
+		return returnValue;
+	}
+
+	Quaternion LoadQuaternion(const float* q)
+	{
+		return Quaternion(q[0], q[1], q[2], q[3]);
+	}
+
+	void StoreQuaternion(const Quaternion& q, float* out)
+	{
+		out[0] = q.x;
+		out[1] = q.y;
+		out[2] = q.z;
+		out[3] = q.w;
+	}
+}
+
+namespace MathReference
+{
+	void Multiply(const float* a, const float* b, size_t count, float* out)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			Matrix4 result = LoadMatrix(a + i * 16) * LoadMatrix(b + i * 16);
+			memcpy(out + i * 16, result.matrix, 16 * sizeof(float));
+		}
+	}
+
+	void Invert(const float* m, size_t count, float* out)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			Matrix4 result = LoadMatrix(m + i * 16);
+			result.Invert();
+			memcpy(out + i * 16, result.matrix, 16 * sizeof(float));
+		}
+	}
+
+	void Transform(const float* points, const float* m, size_t count, float* out)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			const float* p = points + i * 3;
+			Vector3 result = Vector3::Transform(Vector3(p[0], p[1], p[2]), LoadMatrix(m + i * 16));
+			out[i * 3] = result.x;
+			out[i * 3 + 1] = result.y;
+			out[i * 3 + 2] = result.z;
+		}
+	}
+
+	void Concatenate(const float* q, const float* p, size_t count, float* out)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			StoreQuaternion(Quaternion::Concatenate(LoadQuaternion(q + i * 4), LoadQuaternion(p + i * 4)), out + i * 4);
+		}
+	}
+
+	void Slerp(const float* a, const float* b, const float* f, size_t count, float* out)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			StoreQuaternion(Quaternion::Slerp(LoadQuaternion(a + i * 4), LoadQuaternion(b + i * 4), f[i]), out + i * 4);
+		}
+	}
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include<cstddef>
+
+// The Math library built a second time with MATH_NO_SIMD, the reference
+// the SIMD paths are compared against (see MathReference.cpp). Matrices
+// are 16 floats row by row, points x, y, z and quaternions x, y, z, w.
+// Every function works on count consecutive elements.
+namespace MathReference
+{
+	// out = a * b
+	void Multiply(const float* a, const float* b, size_t count, float* out);
+	// out = m inverted
+	void Invert(const float* m, size_t count, float* out);
+	// out = Vector3::Transform(point, m)
+	void Transform(const float* points, const float* m, size_t count, float* out);
+	// out = Quaternion::Concatenate(q, p)
+	void Concatenate(const float* q, const float* p, size_t count, float* out);
+	// out = Quaternion::Slerp(a, b, f)
+	void Slerp(const float* a, const float* b, const float* f, size_t count, float* out);
+}
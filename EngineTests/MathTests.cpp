@@ -0,0 +1,301 @@
+#include"Test.h"
+#include"Math.h"
+#include"MathReference.h"
+#include<algorithm>
+#include<random>
+#include<vector>
+
+// The SIMD paths of Math (the ones this build compiled) against the
+// MATH_NO_SIMD build in MathReference. Paths that keep the scalar order
+// of operations must match exactly, the others within a stated tolerance.
+
+namespace
+{
+	static_assert(sizeof(Matrix4) == 16 * sizeof(float), "Matrix4 is read as 16 floats");
+	static_assert(sizeof(Vector3) == 3 * sizeof(float), "Vector3 is read as 3 floats");
+	static_assert(sizeof(Quaternion) == 4 * sizeof(float), "Quaternion is read as 4 floats");
+
+	const size_t Count = 10000;
+
+	const char* GetPathName()
+	{
+#if defined(MATH_AVX)
+		return "AVX";
+#elif defined(MATH_SSE)
+		return "SSE";
+#elif defined(MATH_NEON)
+		return "NEON";
+#else
+		return "scalar";
+#endif
+	}
+
+	// Inputs shared by the tests and benchmarks
+	struct MathData
+	{
+		// Entries in [-10, 10]
+		std::vector<Matrix4> mMatrices;
+		std::vector<Matrix4> mOtherMatrices;
+		// Scale, rotation and translation, as world and view transforms are
+		std::vector<Matrix4> mTransforms;
+		std::vector<Vector3> mPoints;
+		// Unit length
+		std::vector<Quaternion> mQuaternions;
+		std::vector<Quaternion> mOtherQuaternions;
+		// In [0, 1]
+		std::vector<float> mFactors;
+
+		MathData()
+		{
+			std::mt19937 random(42);
+			std::uniform_real_distribution<float> entry(-10.0f, 10.0f);
+			std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+			std::uniform_real_distribution<float> scale(0.1f, 10.0f);
+			std::uniform_real_distribution<float> factor(0.0f, 1.0f);
+			auto randomMatrix = [&]()
+			{
+				Matrix4 m;
+				for (int r = 0; r < 4; r++)
+				{
+					for (int c = 0; c < 4; c++)
+					{
+						m.matrix[r][c] = entry(random);
+					}
+				}
+				return m;
+			};
+			auto randomQuaternion = [&]()
+			{
+				Quaternion q(unit(random), unit(random), unit(random), unit(random));
+				q.Normalize();
+				return q;
+			};
+			for (size_t i = 0; i < Count; i++)
+			{
+				mMatrices.emplace_back(randomMatrix());
+				mOtherMatrices.emplace_back(randomMatrix());
+				Vector3 translation(entry(random) * 10.0f, entry(random) * 10.0f, entry(random) * 10.0f);
+				mTransforms.emplace_back(Matrix4::CreateScale(scale(random)) *
+					Matrix4::CreateFromQuaternion(randomQuaternion()) * Matrix4::CreateTranslation(translation));
+				mPoints.emplace_back(Vector3(entry(random), entry(random), entry(random)));
+				mQuaternions.emplace_back(randomQuaternion());
+				mOtherQuaternions.emplace_back(randomQuaternion());
+				mFactors.emplace_back(factor(random));
+			}
+		}
+	};
+
+	const MathData& GetData()
+	{
+		static MathData data;
+		return data;
+	}
+
+	const float* Floats(const Matrix4* m) { return &m->matrix[0][0]; }
+	float* Floats(Matrix4* m) { return &m->matrix[0][0]; }
+	const float* Floats(const Vector3* v) { return &v->x; }
+	float* Floats(Vector3* v) { return &v->x; }
+	const float* Floats(const Quaternion* q) { return &q->x; }
+	float* Floats(Quaternion* q) { return &q->x; }
+
+	// The SIMD build's side of MathReference
+	void Multiply(const Matrix4* a, const Matrix4* b, size_t count, Matrix4* out)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			out[i] = a[i] * b[i];
+		}
+	}
+
+	void Invert(const Matrix4* m, size_t count, Matrix4* out)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			out[i] = m[i];
+			out[i].Invert();
+		}
+	}
+
+	void Transform(const Vector3* points, const Matrix4* m, size_t count, Vector3* out)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			out[i] = Vector3::Transform(points[i], m[i]);
+		}
+	}
+
+	void Concatenate(const Quaternion* q, const Quaternion* p, size_t count, Quaternion* out)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			out[i] = Quaternion::Concatenate(q[i], p[i]);
+		}
+	}
+
+	void Slerp(const Quaternion* a, const Quaternion* b, const float* f, size_t count, Quaternion* out)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			out[i] = Quaternion::Slerp(a[i], b[i], f[i]);
+		}
+	}
+
+	// Largest |a - b| over n floats
+	float MaxDifference(const float* a, const float* b, size_t n)
+	{
+		float difference = 0.0f;
+		for (size_t i = 0; i < n; i++)
+		{
+			difference = std::max(difference, std::fabs(a[i] - b[i]));
+		}
+		return difference;
+	}
+
+	bool Equal(const float* a, const float* b, size_t n)
+	{
+		for (size_t i = 0; i < n; i++)
+		{
+			if (a[i] != b[i])
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+TEST(Math_MultiplyMatchesScalar)
+{
+	// Each path sums a[i][k] * b[k][j] over k in order: exact
+	const MathData& data = GetData();
+	std::vector<Matrix4> simd(Count);
+	std::vector<Matrix4> scalar(Count);
+	Multiply(data.mMatrices.data(), data.mOtherMatrices.data(), Count, simd.data());
+	MathReference::Multiply(Floats(data.mMatrices.data()), Floats(data.mOtherMatrices.data()), Count, Floats(scalar.data()));
+	std::printf("  %s path, max difference %g\n", GetPathName(), MaxDifference(Floats(simd.data()), Floats(scalar.data()), Count * 16));
+	CHECK(Equal(Floats(simd.data()), Floats(scalar.data()), Count * 16));
+
+	// operator*= and aliasing
+	Matrix4 m = data.mMatrices[0];
+	m *= m;
+	Matrix4 expected;
+	MathReference::Multiply(Floats(&data.mMatrices[0]), Floats(&data.mMatrices[0]), 1, Floats(&expected));
+	CHECK(Equal(Floats(&m), Floats(&expected), 16));
+}
+
+TEST(Math_TransformMatchesScalar)
+{
+	// (x, y, z, 1) times the rows in order on every path: exact
+	const MathData& data = GetData();
+	std::vector<Vector3> simd(Count);
+	std::vector<Vector3> scalar(Count);
+	Transform(data.mPoints.data(), data.mMatrices.data(), Count, simd.data());
+	MathReference::Transform(Floats(data.mPoints.data()), Floats(data.mMatrices.data()), Count, Floats(scalar.data()));
+	CHECK(Equal(Floats(simd.data()), Floats(scalar.data()), Count * 3));
+}
+
+TEST(Math_InvertMatchesScalar)
+{
+	// The SSE path inverts through 2x2 blocks and their adjugates, the
+	// scalar one through cofactors: same inverse, different rounding.
+	// Within 1e-5 of the inverse's largest element, and both give
+	// M * inverse within 1e-3 of the identity (translations go up to
+	// 1000, where floats are 6e-5 apart).
+	const float relativeTolerance = 1.0e-5f;
+	const float identityTolerance = 1.0e-3f;
+	const MathData& data = GetData();
+	std::vector<Matrix4> simd(Count);
+	std::vector<Matrix4> scalar(Count);
+	Invert(data.mTransforms.data(), Count, simd.data());
+	MathReference::Invert(Floats(data.mTransforms.data()), Count, Floats(scalar.data()));
+
+	float worstRelative = 0.0f;
+	float worstIdentity = 0.0f;
+	for (size_t i = 0; i < Count; i++)
+	{
+		const float* s = Floats(&scalar[i]);
+		float largest = 0.0f;
+		for (int k = 0; k < 16; k++)
+		{
+			largest = std::max(largest, std::fabs(s[k]));
+		}
+		worstRelative = std::max(worstRelative, MaxDifference(Floats(&simd[i]), s, 16) / largest);
+
+		Matrix4 product = data.mTransforms[i] * simd[i];
+		Matrix4 scalarProduct;
+		MathReference::Multiply(Floats(&data.mTransforms[i]), s, 1, Floats(&scalarProduct));
+		worstIdentity = std::max(worstIdentity, MaxDifference(Floats(&product), Floats(&Matrix4::Identity), 16));
+		worstIdentity = std::max(worstIdentity, MaxDifference(Floats(&scalarProduct), Floats(&Matrix4::Identity), 16));
+	}
+	std::printf("  %s path, max relative difference %g, max M * inverse - I %g\n",
+		GetPathName(), worstRelative, worstIdentity);
+	CHECK(worstRelative <= relativeTolerance);
+	CHECK(worstIdentity <= identityTolerance);
+}
+
+TEST(Math_ConcatenateMatchesScalar)
+{
+	// The SSE path sums p.w * q + p.x * (...) + ..., the scalar one
+	// p.w * qv + q.w * pv + pv x qv: unit quaternions agree within 1e-6
+	const float tolerance = 1.0e-6f;
+	const MathData& data = GetData();
+	std::vector<Quaternion> simd(Count);
+	std::vector<Quaternion> scalar(Count);
+	Concatenate(data.mQuaternions.data(), data.mOtherQuaternions.data(), Count, simd.data());
+	MathReference::Concatenate(Floats(data.mQuaternions.data()), Floats(data.mOtherQuaternions.data()), Count, Floats(scalar.data()));
+	float difference = MaxDifference(Floats(simd.data()), Floats(scalar.data()), Count * 4);
+	std::printf("  %s path, max difference %g\n", GetPathName(), difference);
+	CHECK(difference <= tolerance);
+#if !defined(MATH_SSE)
+	CHECK(difference == 0.0f);
+#endif
+}
+
+TEST(Math_SlerpMatchesScalar)
+{
+	// Slerp has no SIMD path of its own: exact
+	const MathData& data = GetData();
+	std::vector<Quaternion> simd(Count);
+	std::vector<Quaternion> scalar(Count);
+	Slerp(data.mQuaternions.data(), data.mOtherQuaternions.data(), data.mFactors.data(), Count, simd.data());
+	MathReference::Slerp(Floats(data.mQuaternions.data()), Floats(data.mOtherQuaternions.data()),
+		data.mFactors.data(), Count, Floats(scalar.data()));
+	CHECK(Equal(Floats(simd.data()), Floats(scalar.data()), Count * 4));
+}
+
+BENCH(Math_SIMDVersusScalar)
+{
+	// Count operations per run, best of 20
+	const MathData& data = GetData();
+	const int runs = 20;
+	std::vector<Matrix4> matrices(Count);
+	std::vector<Vector3> points(Count);
+	std::vector<Quaternion> quaternions(Count);
+	auto report = [](const char* name, double simd, double scalar)
+	{
+		std::printf("  %-12s %6.2f ns  scalar %6.2f ns  (x%.2f)\n", name,
+			simd * 1.0e6 / Count, scalar * 1.0e6 / Count, scalar / simd);
+	};
+	std::printf("  %s path, ns per operation\n", GetPathName());
+
+	report("multiply",
+		EngineTests::BestOf(runs, [&]() { Multiply(data.mMatrices.data(), data.mOtherMatrices.data(), Count, matrices.data()); }),
+		EngineTests::BestOf(runs, [&]() { MathReference::Multiply(Floats(data.mMatrices.data()),
+			Floats(data.mOtherMatrices.data()), Count, Floats(matrices.data())); }));
+	report("invert",
+		EngineTests::BestOf(runs, [&]() { Invert(data.mTransforms.data(), Count, matrices.data()); }),
+		EngineTests::BestOf(runs, [&]() { MathReference::Invert(Floats(data.mTransforms.data()), Count, Floats(matrices.data())); }));
+	report("transform",
+		EngineTests::BestOf(runs, [&]() { Transform(data.mPoints.data(), data.mTransforms.data(), Count, points.data()); }),
+		EngineTests::BestOf(runs, [&]() { MathReference::Transform(Floats(data.mPoints.data()),
+			Floats(data.mTransforms.data()), Count, Floats(points.data())); }));
+	report("concatenate",
+		EngineTests::BestOf(runs, [&]() { Concatenate(data.mQuaternions.data(), data.mOtherQuaternions.data(), Count, quaternions.data()); }),
+		EngineTests::BestOf(runs, [&]() { MathReference::Concatenate(Floats(data.mQuaternions.data()),
+			Floats(data.mOtherQuaternions.data()), Count, Floats(quaternions.data())); }));
+	report("slerp",
+		EngineTests::BestOf(runs, [&]() { Slerp(data.mQuaternions.data(), data.mOtherQuaternions.data(),
+			data.mFactors.data(), Count, quaternions.data()); }),
+		EngineTests::BestOf(runs, [&]() { MathReference::Slerp(Floats(data.mQuaternions.data()),
+			Floats(data.mOtherQuaternions.data()), data.mFactors.data(), Count, Floats(quaternions.data())); }));
+}
@@ -0,0 +1,58 @@
+#include"Test.h"
+#include"MeshData.h"
+#include"MeshFile.h"
+#include<cstdio>
+
+namespace
+{
+	const char* const TestFileName = "EngineTests_Quads.gpbin";
+
+	// Two sub meshes of a quad each, the second with lastIndex as its
+	// last index (relative to its own 4 vertices)
+	MeshData MakeQuads(unsigned int lastIndex)
+	{
+		MeshData data;
+		data.mShaderName = "BasicMesh";
+		const float quad[4][MeshData::VertexSize] = {
+			{ 0, 0, 0, 0, 0, 1, 0, 0 },
+			{ 1, 0, 0, 0, 0, 1, 1, 0 },
+			{ 1, 1, 0, 0, 0, 1, 1, 1 },
+			{ 0, 1, 0, 0, 0, 1, 0, 1 }
+		};
+		const unsigned int indices[6] = { 0, 1, 2, 2, 3, 0 };
+		for (int i = 0; i < 2; i++)
+		{
+			SubMeshData subMesh;
+			subMesh.mVertexOffset = data.GetNumVerts();
+			subMesh.mNumVerts = 4;
+			subMesh.mIndexOffset = static_cast<unsigned int>(data.mIndices.size());
+			subMesh.mNumIndices = 6;
+			data.mSubMeshes.emplace_back(subMesh);
+			for (int v = 0; v < 4; v++)
+			{
+				data.mVertices.insert(data.mVertices.end(), quad[v], quad[v] + MeshData::VertexSize);
+			}
+			data.mIndices.insert(data.mIndices.end(), indices, indices + 6);
+		}
+		data.mIndices.back() = lastIndex;
+		return data;
+	}
+
+	bool WriteAndOpen(const MeshData& data)
+	{
+		MeshFile file;
+		bool opened = MeshFile::Write(data, TestFileName) && file.Open(TestFileName);
+		file.Close();
+		std::remove(TestFileName);
+		return opened;
+	}
+}
+
+TEST(MeshFile_RejectsIndicesPastSubMeshVertices)
+{
+	CHECK(WriteAndOpen(MakeQuads(0)));
+	CHECK(WriteAndOpen(MakeQuads(3)));
+	// Inside the mesh's 8 vertices, but past the second sub mesh's 4
+	CHECK(!WriteAndOpen(MakeQuads(4)));
+	CHECK(!WriteAndOpen(MakeQuads(0xFFFFFFFF)));
+}
@@ -0,0 +1,66 @@
+#include"Test.h"
+#include"MeshData.h"
+#include"MeshImporter.h"
+#include"MeshOptimizer.h"
+#include<cstdio>
+#include<fstream>
+#include<string>
+
+namespace
+{
+	const char* const TestMeshName = "EngineTests_Quad.gpmesh";
+
+	// A quad of 4 vertices with the given two triangles
+	bool LoadQuad(const std::string& triangles, MeshData& outData)
+	{
+		{
+			std::ofstream file(TestMeshName);
+			file << "{\n\t\"version\":1,\n\t\"vertexformat\":\"PosNormTex\",\n\t\"shader\":\"BasicMesh\",\n"
+				"\t\"textures\":[\"Assets/Cube.png\"],\n\t\"specularPower\":100.0,\n\t\"vertices\":[\n"
+				"\t\t[0,0,0,0,0,1,0,0],\n\t\t[1,0,0,0,0,1,1,0],\n\t\t[1,1,0,0,0,1,1,-1],\n\t\t[0,1,0,0,0,1,0,-1]\n"
+				"\t],\n\t\"indices\":[" << triangles << "]\n}\n";
+		}
+		bool loaded = MeshImporter::LoadGPMesh(TestMeshName, outData);
+		std::remove(TestMeshName);
+		return loaded;
+	}
+}
+
+TEST(MeshImporter_RejectsIndicesPastVertices)
+{
+	MeshData valid;
+	CHECK(LoadQuad("[0,1,2],[2,3,0]", valid));
+	CHECK(valid.GetNumVerts() == 4);
+	CHECK(valid.mIndices.size() == 6);
+
+	MeshData pastEnd;
+	CHECK(!LoadQuad("[0,1,2],[2,4,0]", pastEnd));
+	MeshData huge;
+	CHECK(!LoadQuad("[0,1,2],[2,3,4000000000]", huge));
+	MeshData negative;
+	CHECK(!LoadQuad("[0,1,2],[2,-1,0]", negative));
+	MeshData notTriangles;
+	CHECK(!LoadQuad("[0,1,2],[2,3]", notTriangles));
+}
+
+TEST(MeshOptimizer_SkipsIndicesPastVertices)
+{
+	// As an importer that doesn't check would hand it over
+	MeshData data;
+	const float vertex[MeshData::VertexSize] = {};
+	for (int i = 0; i < 4; i++)
+	{
+		data.mVertices.insert(data.mVertices.end(), vertex, vertex + MeshData::VertexSize);
+	}
+	const unsigned int indices[] = { 0, 1, 2, 2, 7, 0 };
+	data.mIndices.assign(indices, indices + 6);
+	SubMeshData subMesh;
+	subMesh.mNumVerts = 4;
+	subMesh.mNumIndices = 6;
+	data.mSubMeshes.emplace_back(subMesh);
+
+	MeshOptimizer::Optimize(data, "out of range");
+	CHECK(data.mIndices.size() == 6 && data.mIndices[4] == 7);
+	CHECK(data.mSubMeshes[0].mNumVerts == 4);
+	CHECK(data.GetNumVerts() == 4);
+}
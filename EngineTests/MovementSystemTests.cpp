@@ -0,0 +1,119 @@
+#include"Test.h"
+#include"Game.h"
+#include"Actor.h"
+#include"MoveComponent.h"
+#include"MovementSystem.h"
+#include<random>
+#include<vector>
+
+namespace
+{
+	const float StepTime = 1.0f / 60.0f;
+
+	// count movers at random places, headings and speeds, some standing still
+	std::vector<Actor*> AddMovers(Game& game, size_t count)
+	{
+		std::mt19937 random(23);
+		std::uniform_real_distribution<float> position(-1000.0f, 1000.0f);
+		std::uniform_real_distribution<float> angle(0.0f, Math::TwoPi);
+		std::uniform_real_distribution<float> speed(-200.0f, 200.0f);
+		std::vector<Actor*> actors;
+		for (size_t i = 0; i < count; i++)
+		{
+			Actor* actor = new Actor(&game);
+			actor->SetVec3Position(Vector3(position(random), position(random), 0.0f));
+			actor->SetQRotation(Quaternion(Vector3::UnitZ, angle(random)));
+			MoveComponent* move = new MoveComponent(actor);
+			move->SetAngularSpeed(i % 5 == 0 ? 0.0f : angle(random) - Math::Pi);
+			move->SetForwardSpeed(i % 7 == 0 ? 0.0f : speed(random));
+			actors.emplace_back(actor);
+		}
+		return actors;
+	}
+}
+
+TEST(MovementSystem_MatchesComponentUpdates)
+{
+	// The same movers in a pooled game and one updating each component
+	Game pooled;
+	pooled.InitializeHeadless();
+	CHECK(pooled.GetMovementSystem() != nullptr);
+	Game objects;
+	objects.SetPooledComponents(false);
+	objects.InitializeHeadless();
+	CHECK(objects.GetMovementSystem() == nullptr);
+
+	const size_t count = 3000;
+	std::vector<Actor*> pooledActors = AddMovers(pooled, count);
+	std::vector<Actor*> objectActors = AddMovers(objects, count);
+	CHECK(pooled.GetMovementSystem()->GetCount() == count);
+	std::vector<Vector3> starts;
+	for (Actor* actor : objectActors)
+	{
+		starts.emplace_back(actor->GetVec3Position());
+	}
+
+	for (int step = 0; step < 20; step++)
+	{
+		// Movers removed halfway leave the others in the pool moving
+		if (step == 10)
+		{
+			for (size_t i = 0; i < count; i += 3)
+			{
+				pooledActors[i]->SetState(Actor::State::EDead);
+				objectActors[i]->SetState(Actor::State::EDead);
+			}
+		}
+		pooled.UpdateGame(StepTime);
+		objects.UpdateGame(StepTime);
+	}
+	CHECK(pooled.GetMovementSystem()->GetCount() == count - (count + 2) / 3);
+
+	bool match = true;
+	size_t moved = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		if (i % 3 == 0)
+		{
+			continue;
+		}
+		const Vector3& a = pooledActors[i]->GetVec3Position();
+		const Vector3& b = objectActors[i]->GetVec3Position();
+		const Quaternion& qa = pooledActors[i]->GetQRotation();
+		const Quaternion& qb = objectActors[i]->GetQRotation();
+		match = match && std::fabs(a.x - b.x) <= 1.0e-3f && std::fabs(a.y - b.y) <= 1.0e-3f &&
+			std::fabs(qa.z - qb.z) <= 1.0e-5f && std::fabs(qa.w - qb.w) <= 1.0e-5f;
+		moved += (b - starts[i]).LengthSq() > 0.0f ? 1 : 0;
+	}
+	CHECK(match);
+	// Only the ones without forward speed stay put
+	CHECK(moved >= count / 2);
+
+	pooled.ShutDown();
+	objects.ShutDown();
+}
+
+BENCH(MovementSystem_100kMovers)
+{
+	// A whole step of 100k movers: transforms composed, components updated
+	const size_t count = 100000;
+	const bool modes[] = { false, true };
+	for (bool pooledComponents : modes)
+	{
+		Game game;
+		game.SetPooledComponents(pooledComponents);
+		game.InitializeHeadless();
+		AddMovers(game, count);
+		// The first step composes every new transform
+		game.UpdateGame(StepTime);
+		double step = EngineTests::BestOf(10, [&game]() { game.UpdateGame(StepTime); });
+		std::printf("  %s: %.2f ms per step", pooledComponents ? "MovementSystem" : "MoveComponent::Update", step);
+		if (game.GetMovementSystem())
+		{
+			MovementSystem* movement = game.GetMovementSystem();
+			std::printf(", %.2f ms of it moving", EngineTests::BestOf(10, [movement]() { movement->Update(StepTime); }));
+		}
+		std::printf("\n");
+		game.ShutDown();
+	}
+}
@@ -0,0 +1,271 @@
+#include"Test.h"
+#include"ObjectPool.h"
+#include"Game.h"
+#include"Actor.h"
+#include"MoveComponent.h"
+#include<cstring>
+#include<deque>
+#include<random>
+#include<thread>
+#include<vector>
+
+// The pool is shared by the whole process, so tests look at how its
+// stats change rather than at their values.
+
+namespace
+{
+	// Stands in for a gameplay component with some data of its own
+	class TrailComponent : public Component
+	{
+	public:
+		TrailComponent(Actor* owner) :Component(owner, 50) {}
+		ComponentAccess GetAccess() const override { return ComponentAccess::None(); }
+	private:
+		float mPoints[12];
+	};
+
+	// Spawn count projectiles per frame and delete the ones spawned
+	// lifetime frames ago, as a stream of bullets would
+	void SpawnDespawn(Game& game, int frames, size_t count, size_t lifetime)
+	{
+		std::deque<std::vector<Actor*>> alive;
+		for (int frame = 0; frame < frames; frame++)
+		{
+			std::vector<Actor*> spawned;
+			spawned.reserve(count);
+			for (size_t i = 0; i < count; i++)
+			{
+				Actor* actor = new Actor(&game);
+				MoveComponent* move = new MoveComponent(actor);
+				move->SetForwardSpeed(100.0f);
+				new TrailComponent(actor);
+				spawned.emplace_back(actor);
+			}
+			alive.emplace_back(std::move(spawned));
+			if (alive.size() > lifetime)
+			{
+				for (Actor* actor : alive.front())
+				{
+					delete actor;
+				}
+				alive.pop_front();
+			}
+		}
+		for (std::vector<Actor*>& actors : alive)
+		{
+			for (Actor* actor : actors)
+			{
+				delete actor;
+			}
+		}
+	}
+
+	// The same pattern of allocations through allocate and release
+	template<typename Allocate, typename Release>
+	void SpawnDespawnRaw(int frames, size_t count, size_t lifetime, const size_t* sizes, size_t numSizes,
+		const Allocate& allocate, const Release& release)
+	{
+		std::deque<std::vector<void*>> alive;
+		for (int frame = 0; frame < frames; frame++)
+		{
+			std::vector<void*> spawned;
+			spawned.reserve(count * numSizes);
+			for (size_t i = 0; i < count; i++)
+			{
+				for (size_t s = 0; s < numSizes; s++)
+				{
+					spawned.emplace_back(allocate(sizes[s]));
+				}
+			}
+			alive.emplace_back(std::move(spawned));
+			if (alive.size() > lifetime)
+			{
+				for (size_t i = 0; i < alive.front().size(); i++)
+				{
+					release(alive.front()[i], sizes[i % numSizes]);
+				}
+				alive.pop_front();
+			}
+		}
+		for (std::vector<void*>& blocks : alive)
+		{
+			for (size_t i = 0; i < blocks.size(); i++)
+			{
+				release(blocks[i], sizes[i % numSizes]);
+			}
+		}
+	}
+}
+
+TEST(ObjectPool_BlocksAreDistinctAndReused)
+{
+	ObjectPool::Stats before = ObjectPool::GetStats();
+	// Every size the pool serves, filled to the last byte
+	std::vector<void*> blocks;
+	for (size_t size = 1; size <= ObjectPool::MaxSize; size++)
+	{
+		void* block = ObjectPool::Allocate(size);
+		std::memset(block, static_cast<int>(size & 0xFF), size);
+		blocks.emplace_back(block);
+	}
+	CHECK(ObjectPool::GetStats().mLive == before.mLive + ObjectPool::MaxSize);
+	CHECK(ObjectPool::GetStats().mHeapAllocations == before.mHeapAllocations);
+	bool intact = true;
+	for (size_t size = 1; size <= ObjectPool::MaxSize; size++)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(blocks[size - 1]);
+		for (size_t i = 0; i < size; i++)
+		{
+			intact = intact && bytes[i] == (size & 0xFF);
+		}
+		// Blocks start on a Granularity boundary
+		intact = intact && reinterpret_cast<uintptr_t>(bytes) % ObjectPool::Granularity == 0;
+	}
+	CHECK(intact);
+	for (size_t size = 1; size <= ObjectPool::MaxSize; size++)
+	{
+		ObjectPool::Free(blocks[size - 1], size);
+	}
+	CHECK(ObjectPool::GetStats().mLive == before.mLive);
+
+	// The block just freed is the next one handed out, for any size
+	// rounding to the same class
+	void* first = ObjectPool::Allocate(40);
+	ObjectPool::Free(first, 40);
+	void* second = ObjectPool::Allocate(33);
+	CHECK(second == first);
+	ObjectPool::Free(second, 33);
+	ObjectPool::Free(nullptr, 40);
+	CHECK(ObjectPool::GetStats().mLive == before.mLive);
+}
+
+TEST(ObjectPool_LargeObjectsUseHeap)
+{
+	ObjectPool::Stats before = ObjectPool::GetStats();
+	void* block = ObjectPool::Allocate(ObjectPool::MaxSize + 1);
+	std::memset(block, 0, ObjectPool::MaxSize + 1);
+	ObjectPool::Free(block, ObjectPool::MaxSize + 1);
+	ObjectPool::Stats after = ObjectPool::GetStats();
+	CHECK(after.mHeapAllocations == before.mHeapAllocations + 1);
+	CHECK(after.mAllocations == before.mAllocations);
+}
+
+TEST(ObjectPool_ThreadsFreeEachOthersBlocks)
+{
+	// Each thread frees the blocks the previous one allocated, so blocks
+	// move between the thread caches through the shared lists
+	ObjectPool::Stats before = ObjectPool::GetStats();
+	const int numThreads = 4;
+	const size_t perThread = 20000;
+	std::vector<std::vector<void*>> blocks(numThreads);
+	std::vector<std::vector<size_t>> sizes(numThreads);
+	for (int t = 0; t < numThreads; t++)
+	{
+		std::mt19937 random(static_cast<unsigned int>(t));
+		for (size_t i = 0; i < perThread; i++)
+		{
+			sizes[t].emplace_back(1 + random() % ObjectPool::MaxSize);
+		}
+	}
+	std::vector<std::thread> threads;
+	for (int t = 0; t < numThreads; t++)
+	{
+		threads.emplace_back([&blocks, &sizes, t]()
+		{
+			for (size_t i = 0; i < perThread; i++)
+			{
+				void* block = ObjectPool::Allocate(sizes[t][i]);
+				std::memset(block, t, sizes[t][i]);
+				blocks[t].emplace_back(block);
+			}
+		});
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+	bool intact = true;
+	for (int t = 0; t < numThreads; t++)
+	{
+		for (size_t i = 0; i < perThread; i++)
+		{
+			const unsigned char* bytes = static_cast<const unsigned char*>(blocks[t][i]);
+			intact = intact && bytes[0] == t && bytes[sizes[t][i] - 1] == t;
+		}
+	}
+	CHECK(intact);
+	CHECK(ObjectPool::GetStats().mLive == before.mLive + numThreads * perThread);
+
+	threads.clear();
+	for (int t = 0; t < numThreads; t++)
+	{
+		threads.emplace_back([&blocks, &sizes, t]()
+		{
+			int other = (t + 1) % numThreads;
+			for (size_t i = 0; i < perThread; i++)
+			{
+				ObjectPool::Free(blocks[other][i], sizes[other][i]);
+			}
+		});
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+	CHECK(ObjectPool::GetStats().mLive == before.mLive);
+}
+
+TEST(ObjectPool_ActorsAndComponentsArePooled)
+{
+	Game game;
+	game.InitializeHeadless();
+	ObjectPool::Stats before = ObjectPool::GetStats();
+	Actor* actor = new Actor(&game);
+	new MoveComponent(actor);
+	new TrailComponent(actor);
+#ifndef NO_OBJECT_POOL
+	CHECK(ObjectPool::GetStats().mLive == before.mLive + 3);
+#endif
+	// The actor deletes its components
+	delete actor;
+	CHECK(ObjectPool::GetStats().mLive == before.mLive);
+
+	SpawnDespawn(game, 20, 500, 5);
+	CHECK(ObjectPool::GetStats().mLive == before.mLive);
+	game.ShutDown();
+}
+
+BENCH(ObjectPool_SpawnDespawn)
+{
+	// 2000 projectiles a frame, each living 30 frames
+	const int frames = 300;
+	const size_t count = 2000;
+	const size_t lifetime = 30;
+	Game game;
+	game.InitializeHeadless();
+	ObjectPool::Stats before = ObjectPool::GetStats();
+	EngineTests::Timer timer;
+	SpawnDespawn(game, frames, count, lifetime);
+	double actors = timer.GetMilliseconds();
+	ObjectPool::Stats after = ObjectPool::GetStats();
+	game.ShutDown();
+	std::printf("  actors and components: %.3f ms per frame, %zu allocations, %zu slabs\n",
+		actors / frames, after.mAllocations - before.mAllocations, after.mSlabs);
+
+	// The allocations alone, pool against the heap, whichever way this
+	// build routes Actor and Component
+	const size_t sizes[] = { sizeof(Actor), sizeof(MoveComponent), sizeof(TrailComponent) };
+	double pool = EngineTests::BestOf(3, [&sizes]()
+	{
+		SpawnDespawnRaw(frames, count, lifetime, sizes, 3,
+			[](size_t size) { return ObjectPool::Allocate(size); },
+			[](void* ptr, size_t size) { ObjectPool::Free(ptr, size); });
+	});
+	double heap = EngineTests::BestOf(3, [&sizes]()
+	{
+		SpawnDespawnRaw(frames, count, lifetime, sizes, 3,
+			[](size_t size) { return ::operator new(size); },
+			[](void* ptr, size_t) { ::operator delete(ptr); });
+	});
+	std::printf("  allocations only: pool %.3f ms, new/delete %.3f ms per frame\n", pool / frames, heap / frames);
+}
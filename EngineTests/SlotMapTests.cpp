@@ -0,0 +1,158 @@
+#include"Test.h"
+#include"SlotMap.h"
+#include"Game.h"
+#include"Actor.h"
+#include"MeshComponent.h"
+#include<algorithm>
+#include<map>
+#include<random>
+#include<vector>
+
+TEST(SlotMap_MatchesReferenceMap)
+{
+	// Random inserts and removes, checked against a std::map
+	std::mt19937 random(31);
+	SlotMap<int> slots;
+	std::vector<std::pair<SlotHandle, int>> live;
+	std::vector<SlotHandle> removed;
+	int next = 0;
+	bool ok = true;
+	for (int i = 0; i < 20000; i++)
+	{
+		if (live.empty() || random() % 3 != 0)
+		{
+			live.emplace_back(slots.Insert(next), next);
+			next++;
+		}
+		else
+		{
+			size_t k = random() % live.size();
+			ok = ok && slots.Remove(live[k].first);
+			removed.emplace_back(live[k].first);
+			live[k] = live.back();
+			live.pop_back();
+		}
+	}
+	std::map<int, int> expected;
+	for (const std::pair<SlotHandle, int>& entry : live)
+	{
+		const int* value = slots.Get(entry.first);
+		ok = ok && value && *value == entry.second;
+		expected[entry.second]++;
+	}
+	CHECK(ok);
+	CHECK(slots.GetCount() == live.size());
+
+	// The dense values are exactly the live ones
+	std::map<int, int> values;
+	for (int value : slots)
+	{
+		values[value]++;
+	}
+	CHECK(values == expected);
+
+	// Removed handles stay stale even though their slots were reused
+	bool stale = true;
+	for (SlotHandle handle : removed)
+	{
+		stale = stale && !slots.IsValid(handle) && !slots.Get(handle) && !slots.Remove(handle);
+	}
+	CHECK(stale);
+	CHECK(!slots.IsValid(SlotHandle()));
+}
+
+TEST(SlotMap_ReusedSlotGetsNewGeneration)
+{
+	SlotMap<int> slots;
+	SlotHandle first = slots.Insert(1);
+	SlotHandle second = slots.Insert(2);
+	CHECK(slots.Remove(first));
+	CHECK(!slots.Remove(first));
+	SlotHandle third = slots.Insert(3);
+	CHECK(third.mIndex == first.mIndex);
+	CHECK(third != first);
+	CHECK(!slots.Get(first));
+	CHECK(*slots.Get(second) == 2);
+	CHECK(*slots.Get(third) == 3);
+	CHECK(slots.GetCount() == 2);
+}
+
+TEST(SlotMap_DeletedActorHandleIsStale)
+{
+	Game game;
+	game.InitializeHeadless();
+	Actor* kept = new Actor(&game);
+	Actor* killed = new Actor(&game);
+	SlotHandle keptHandle = kept->GetHandle();
+	SlotHandle killedHandle = killed->GetHandle();
+	CHECK(game.GetActor(killedHandle) == killed);
+
+	killed->SetState(Actor::State::EDead);
+	game.UpdateGame(1.0f / 60.0f);
+	CHECK(game.GetActor(killedHandle) == nullptr);
+	CHECK(game.GetActor(keptHandle) == kept);
+	// A new actor in the old slot doesn't answer to the old handle
+	Actor* spawned = new Actor(&game);
+	CHECK(game.GetActor(killedHandle) == nullptr);
+	CHECK(game.GetActor(spawned->GetHandle()) == spawned);
+	game.ShutDown();
+}
+
+BENCH(SlotMap_Destroy50kActors)
+{
+	// Every actor, each with a mesh component, dies in one step
+	const size_t count = 50000;
+	Game game;
+	game.InitializeHeadless();
+	std::vector<Actor*> actors;
+	for (size_t i = 0; i < count; i++)
+	{
+		Actor* actor = new Actor(&game);
+		new MeshComponent(actor);
+		actors.emplace_back(actor);
+	}
+	game.UpdateGame(1.0f / 60.0f);
+	for (Actor* actor : actors)
+	{
+		actor->SetState(Actor::State::EDead);
+	}
+	EngineTests::Timer timer;
+	game.UpdateGame(1.0f / 60.0f);
+	double step = timer.GetMilliseconds();
+	game.ShutDown();
+	std::printf("  step destroying %zu actors and mesh components: %.2f ms\n", count, step);
+
+	// The lookups alone, as the vectors they replaced did them: find and
+	// swap out of the actors, find and erase out of the mesh components
+	std::vector<int> objects(count);
+	std::vector<int*> actorList;
+	std::vector<int*> meshList;
+	SlotMap<int*> actorSlots;
+	SlotMap<int*> meshSlots;
+	std::vector<SlotHandle> actorHandles;
+	std::vector<SlotHandle> meshHandles;
+	for (int& object : objects)
+	{
+		actorList.emplace_back(&object);
+		meshList.emplace_back(&object);
+		actorHandles.emplace_back(actorSlots.Insert(&object));
+		meshHandles.emplace_back(meshSlots.Insert(&object));
+	}
+	timer.Reset();
+	for (int& object : objects)
+	{
+		auto actor = std::find(actorList.begin(), actorList.end(), &object);
+		std::iter_swap(actor, actorList.end() - 1);
+		actorList.pop_back();
+		meshList.erase(std::find(meshList.begin(), meshList.end(), &object));
+	}
+	double vectors = timer.GetMilliseconds();
+	timer.Reset();
+	for (size_t i = 0; i < count; i++)
+	{
+		actorSlots.Remove(actorHandles[i]);
+		meshSlots.Remove(meshHandles[i]);
+	}
+	double slotMaps = timer.GetMilliseconds();
+	std::printf("  removals only: vectors %.2f ms, slot maps %.3f ms\n", vectors, slotMaps);
+}
@@ -0,0 +1,173 @@
+#include"Test.h"
+#include"Game.h"
+#include"Actor.h"
+#include"Renderer.h"
+#include"SpriteBatch.h"
+#include"SpriteComponent.h"
+#include"Texture.h"
+#include"TransformStore.h"
+#include<vector>
+
+namespace
+{
+	const float Tolerance = 1.0e-4f;
+
+	AtlasRegion MakeRegion(Texture* page, float u0, float v0, float u1, float v1, int width, int height)
+	{
+		AtlasRegion region;
+		region.mPage = page;
+		region.mUVMin = Vector2(u0, v0);
+		region.mUVMax = Vector2(u1, v1);
+		region.mWidth = width;
+		region.mHeight = height;
+		return region;
+	}
+
+	SpriteComponent* AddSprite(Game& game, const Vector2& position, int drawOrder)
+	{
+		Actor* actor = new Actor(&game);
+		actor->SetPosition(position);
+		return new SpriteComponent(actor, drawOrder);
+	}
+
+	// Make the render transforms current, as a frame would
+	void ComposeTransforms(Game& game)
+	{
+		game.GetTransformStore()->ComposeDirty();
+		game.GetTransformStore()->Interpolate(1.0f);
+	}
+
+	bool VertexIs(const SpriteVertex& vert, float x, float y, float u, float v)
+	{
+		return std::fabs(vert.mPosition[0] - x) <= Tolerance && std::fabs(vert.mPosition[1] - y) <= Tolerance &&
+			std::fabs(vert.mPosition[2]) <= Tolerance && vert.mUV[0] == u && vert.mUV[1] == v;
+	}
+}
+
+TEST(SpriteBatch_QuadCornersAndRegionUVs)
+{
+	Game game;
+	game.InitializeHeadless();
+	Texture page;
+
+	// 32x16 region at (100, 50) drawn twice as large
+	SpriteComponent* sprite = AddSprite(game, Vector2(100.0f, 50.0f), 100);
+	sprite->GetOwner()->SetScale(2.0f);
+	sprite->SetRegion(MakeRegion(&page, 0.25f, 0.5f, 0.5f, 0.75f, 32, 16));
+	ComposeTransforms(game);
+
+	SpriteBatch batch;
+	batch.Build(game.GetRenderer()->GetSprites());
+	const std::vector<SpriteVertex>& verts = batch.GetVertices();
+	CHECK(verts.size() == 4);
+	if (verts.size() == 4)
+	{
+		// Top left, top right, bottom right, bottom left, with v = 0 at the top
+		CHECK(VertexIs(verts[0], 68.0f, 66.0f, 0.25f, 0.5f));
+		CHECK(VertexIs(verts[1], 132.0f, 66.0f, 0.5f, 0.5f));
+		CHECK(VertexIs(verts[2], 132.0f, 34.0f, 0.5f, 0.75f));
+		CHECK(VertexIs(verts[3], 68.0f, 34.0f, 0.25f, 0.75f));
+	}
+
+	// Rotated: the corners are the unit quad through the sprite transform
+	sprite->GetOwner()->SetRotation(Math::Pi / 6.0f);
+	ComposeTransforms(game);
+	batch.Build(game.GetRenderer()->GetSprites());
+	const float cornerX[] = { -0.5f, 0.5f, 0.5f, -0.5f };
+	const float cornerY[] = { 0.5f, 0.5f, -0.5f, -0.5f };
+	Matrix4 transform = sprite->GetSpriteTransform();
+	CHECK(batch.GetVertices().size() == 4);
+	for (size_t i = 0; i < batch.GetVertices().size() && i < 4; i++)
+	{
+		Vector3 expected = Vector3::Transform(Vector3(cornerX[i], cornerY[i], 0.0f), transform);
+		const SpriteVertex& vert = batch.GetVertices()[i];
+		CHECK_NEAR(vert.mPosition[0], expected.x, Tolerance);
+		CHECK_NEAR(vert.mPosition[1], expected.y, Tolerance);
+	}
+
+	// SetTexture draws the whole texture again
+	sprite->SetTexture(&page);
+	batch.Build(game.GetRenderer()->GetSprites());
+	CHECK(VertexIs(batch.GetVertices()[0], batch.GetVertices()[0].mPosition[0],
+		batch.GetVertices()[0].mPosition[1], 0.0f, 0.0f));
+	CHECK(VertexIs(batch.GetVertices()[2], batch.GetVertices()[2].mPosition[0],
+		batch.GetVertices()[2].mPosition[1], 1.0f, 1.0f));
+
+	game.ShutDown();
+}
+
+TEST(SpriteBatch_SplitsByLayerAndTexture)
+{
+	Game game;
+	game.InitializeHeadless();
+	// Two pages, each sprite on a page draws that page's region
+	Texture pages[2];
+	const AtlasRegion regions[2] = {
+		MakeRegion(&pages[0], 0.0f, 0.0f, 0.5f, 0.5f, 8, 8),
+		MakeRegion(&pages[1], 0.5f, 0.5f, 1.0f, 1.0f, 8, 8)
+	};
+
+	// Layer 20: pages alternate, layer 10: page 1 only (added later, but
+	// drawn first), plus sprites without a texture that are skipped
+	for (int i = 0; i < 10; i++)
+	{
+		AddSprite(game, Vector2(static_cast<float>(i), 0.0f), 20)->SetRegion(regions[i % 2]);
+	}
+	for (int i = 0; i < 3; i++)
+	{
+		AddSprite(game, Vector2(0.0f, static_cast<float>(i)), 10)->SetRegion(regions[1]);
+		AddSprite(game, Vector2(0.0f, static_cast<float>(i)), 10);
+	}
+	AddSprite(game, Vector2::Zero, 30);
+	ComposeTransforms(game);
+
+	SpriteBatch batch;
+	batch.Build(game.GetRenderer()->GetSprites());
+	const std::vector<SpriteBatch::Batch>& batches = batch.GetBatches();
+	const std::vector<SpriteVertex>& verts = batch.GetVertices();
+	CHECK(verts.size() == 13 * 4);
+	CHECK(batches.size() == 3);
+	if (batches.size() != 3)
+	{
+		game.ShutDown();
+		return;
+	}
+
+	CHECK(batches[0].mLayer == 10 && batches[0].mTexture == &pages[1] && batches[0].mIndexCount == 3 * 6);
+	CHECK(batches[1].mLayer == 20 && batches[2].mLayer == 20);
+	CHECK(batches[1].mTexture != batches[2].mTexture);
+	CHECK(batches[1].mIndexCount == 5 * 6 && batches[2].mIndexCount == 5 * 6);
+
+	// Batches cover the stream in order, and every quad in a batch has
+	// the UVs of its page's region
+	unsigned int nextIndex = 0;
+	for (const SpriteBatch::Batch& b : batches)
+	{
+		CHECK(b.mFirstIndex == nextIndex);
+		nextIndex += b.mIndexCount;
+		const AtlasRegion& region = b.mTexture == &pages[0] ? regions[0] : regions[1];
+		bool uvsMatch = true;
+		for (unsigned int quad = b.mFirstIndex / 6; quad < (b.mFirstIndex + b.mIndexCount) / 6; quad++)
+		{
+			const SpriteVertex& topLeft = verts[quad * 4];
+			const SpriteVertex& bottomRight = verts[quad * 4 + 2];
+			uvsMatch = uvsMatch && topLeft.mUV[0] == region.mUVMin.x && topLeft.mUV[1] == region.mUVMin.y &&
+				bottomRight.mUV[0] == region.mUVMax.x && bottomRight.mUV[1] == region.mUVMax.y;
+		}
+		CHECK(uvsMatch);
+	}
+	CHECK(nextIndex == verts.size() / 4 * 6);
+
+	// Moving every sprite of a layer to one page merges its batches
+	game.GetRenderer()->GetSprites().ForEach([&regions](SpriteComponent* sprite)
+	{
+		if (sprite->GetDrawOrder() == 20)
+		{
+			sprite->SetRegion(regions[0]);
+		}
+	});
+	batch.Build(game.GetRenderer()->GetSprites());
+	CHECK(batch.GetBatches().size() == 2);
+
+	game.ShutDown();
+}
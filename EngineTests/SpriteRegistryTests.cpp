@@ -0,0 +1,187 @@
+#include"Test.h"
+#include"SpriteRegistry.h"
+#include<algorithm>
+#include<random>
+#include<vector>
+
+namespace
+{
+	// The registry only keeps the pointers, entries stand in for sprites
+	struct Entry
+	{
+		int mDrawOrder;
+		SpriteRegistry::Handle mHandle;
+		bool mAdded;
+	};
+
+	SpriteComponent* ToSprite(Entry& entry) { return reinterpret_cast<SpriteComponent*>(&entry); }
+	Entry* ToEntry(SpriteComponent* sprite) { return reinterpret_cast<Entry*>(sprite); }
+
+	// Every added entry visited once, lowest draw order first
+	bool VisitsInOrder(const SpriteRegistry& registry, const std::vector<Entry>& entries)
+	{
+		bool ordered = true;
+		int last = 0;
+		std::vector<int> visits(entries.size(), 0);
+		registry.ForEach([&](SpriteComponent* sprite)
+		{
+			Entry* entry = ToEntry(sprite);
+			int layer = SpriteRegistry::GetLayer(entry->mDrawOrder);
+			ordered = ordered && layer >= last;
+			last = layer;
+			visits[entry - entries.data()]++;
+		});
+		size_t added = 0;
+		for (size_t i = 0; i < entries.size(); i++)
+		{
+			ordered = ordered && visits[i] == (entries[i].mAdded ? 1 : 0);
+			added += entries[i].mAdded ? 1 : 0;
+		}
+		return ordered && registry.GetCount() == added;
+	}
+}
+
+TEST(SpriteRegistry_ForEachVisitsInDrawOrder)
+{
+	std::mt19937 random(9);
+	std::uniform_int_distribution<int> drawOrder(0, SpriteRegistry::NumLayers - 1);
+	std::vector<Entry> entries(5000);
+	SpriteRegistry registry;
+	for (Entry& entry : entries)
+	{
+		entry.mDrawOrder = drawOrder(random);
+		entry.mHandle = registry.Add(ToSprite(entry), entry.mDrawOrder);
+		entry.mAdded = true;
+	}
+	CHECK(VisitsInOrder(registry, entries));
+
+	// Reorder some, remove some and add a few back
+	for (size_t i = 0; i < entries.size(); i += 2)
+	{
+		entries[i].mDrawOrder = drawOrder(random);
+		registry.SetDrawOrder(entries[i].mHandle, entries[i].mDrawOrder);
+	}
+	for (size_t i = 0; i < entries.size(); i += 3)
+	{
+		registry.Remove(entries[i].mHandle);
+		entries[i].mAdded = false;
+	}
+	for (size_t i = 0; i < entries.size(); i += 9)
+	{
+		entries[i].mHandle = registry.Add(ToSprite(entries[i]), entries[i].mDrawOrder);
+		entries[i].mAdded = true;
+	}
+	CHECK(VisitsInOrder(registry, entries));
+
+	// Layers come out in order, each with its own sprites only
+	bool layersOk = true;
+	int lastLayer = -1;
+	registry.ForEachLayer([&](int layer, const std::vector<SpriteComponent*>& sprites)
+	{
+		layersOk = layersOk && layer > lastLayer && !sprites.empty();
+		lastLayer = layer;
+		for (SpriteComponent* sprite : sprites)
+		{
+			layersOk = layersOk && SpriteRegistry::GetLayer(ToEntry(sprite)->mDrawOrder) == layer;
+		}
+	});
+	CHECK(layersOk);
+
+	for (Entry& entry : entries)
+	{
+		if (entry.mAdded)
+		{
+			registry.Remove(entry.mHandle);
+			entry.mAdded = false;
+		}
+	}
+	CHECK(registry.GetCount() == 0);
+}
+
+TEST(SpriteRegistry_ClampsDrawOrder)
+{
+	CHECK(SpriteRegistry::GetLayer(-5) == 0);
+	CHECK(SpriteRegistry::GetLayer(0) == 0);
+	CHECK(SpriteRegistry::GetLayer(100) == 100);
+	CHECK(SpriteRegistry::GetLayer(SpriteRegistry::NumLayers - 1) == SpriteRegistry::NumLayers - 1);
+	CHECK(SpriteRegistry::GetLayer(SpriteRegistry::NumLayers) == SpriteRegistry::NumLayers - 1);
+
+	// Out of range sprites (logged) go to the first and last layers
+	Entry below{ -5, SpriteRegistry::Handle(), true };
+	Entry above{ 1000, SpriteRegistry::Handle(), true };
+	SpriteRegistry registry;
+	below.mHandle = registry.Add(ToSprite(below), below.mDrawOrder);
+	above.mHandle = registry.Add(ToSprite(above), above.mDrawOrder);
+	CHECK(below.mHandle.mLayer == 0);
+	CHECK(above.mHandle.mLayer == SpriteRegistry::NumLayers - 1);
+	registry.SetDrawOrder(above.mHandle, -1);
+	CHECK(above.mHandle.mLayer == 0);
+
+	// A removed sprite's handle doesn't count twice
+	registry.Remove(below.mHandle);
+	registry.Remove(below.mHandle);
+	CHECK(registry.GetCount() == 1);
+	registry.Remove(above.mHandle);
+	CHECK(registry.GetCount() == 0);
+}
+
+BENCH(SpriteRegistry_100kSprites)
+{
+	// 100k sprites over 16 draw orders: the registry against the list
+	// kept sorted by insertion and searched on removal it replaced
+	const size_t count = 100000;
+	std::mt19937 random(1);
+	std::vector<Entry> entries(count);
+	for (Entry& entry : entries)
+	{
+		entry.mDrawOrder = static_cast<int>(random() % 16);
+		entry.mAdded = true;
+	}
+
+	SpriteRegistry registry;
+	EngineTests::Timer timer;
+	for (Entry& entry : entries)
+	{
+		entry.mHandle = registry.Add(ToSprite(entry), entry.mDrawOrder);
+	}
+	double add = timer.GetMilliseconds();
+	timer.Reset();
+	for (size_t i = 0; i < count; i += 2)
+	{
+		entries[i].mDrawOrder = static_cast<int>(random() % 16);
+		registry.SetDrawOrder(entries[i].mHandle, entries[i].mDrawOrder);
+	}
+	double reorder = timer.GetMilliseconds();
+	// Reads every sprite, as drawing would
+	long long drawOrders = 0;
+	double iterate = EngineTests::BestOf(5, [&registry, &drawOrders]()
+	{
+		drawOrders = 0;
+		registry.ForEach([&drawOrders](SpriteComponent* sprite) { drawOrders += ToEntry(sprite)->mDrawOrder; });
+	});
+	timer.Reset();
+	for (Entry& entry : entries)
+	{
+		registry.Remove(entry.mHandle);
+	}
+	double remove = timer.GetMilliseconds();
+	std::printf("  registry: add %.2f ms, reorder 50k %.2f ms, iterate %.3f ms, remove %.2f ms (draw orders add up to %lld)\n",
+		add, reorder, iterate, remove, drawOrders);
+
+	std::vector<Entry*> sorted;
+	timer.Reset();
+	for (Entry& entry : entries)
+	{
+		auto at = std::upper_bound(sorted.begin(), sorted.end(), &entry,
+			[](const Entry* a, const Entry* b) { return a->mDrawOrder < b->mDrawOrder; });
+		sorted.insert(at, &entry);
+	}
+	double sortedAdd = timer.GetMilliseconds();
+	timer.Reset();
+	for (Entry& entry : entries)
+	{
+		sorted.erase(std::find(sorted.begin(), sorted.end(), &entry));
+	}
+	double sortedRemove = timer.GetMilliseconds();
+	std::printf("  sorted list: add %.2f ms, remove %.2f ms\n", sortedAdd, sortedRemove);
+}
@@ -0,0 +1,101 @@
+#include"Test.h"
+#include"Std140Packer.h"
+#include"Game.h"
+#include"Renderer.h"
+#include<cstring>
+
+namespace
+{
+	float ReadFloat(const Std140Packer& packer, size_t offset)
+	{
+		float value = 0.0f;
+		std::memcpy(&value, packer.GetData() + offset, sizeof(float));
+		return value;
+	}
+
+	bool HasVec3(const Std140Packer& packer, size_t offset, const Vector3& value)
+	{
+		return offset + 12 <= packer.GetSize() && ReadFloat(packer, offset) == value.x &&
+			ReadFloat(packer, offset + 4) == value.y && ReadFloat(packer, offset + 8) == value.z;
+	}
+
+	// Rows as stored in Matrix4, for the row_major block
+	bool HasMat4(const Std140Packer& packer, size_t offset, const Matrix4& value)
+	{
+		return offset + 64 <= packer.GetSize() &&
+			std::memcmp(packer.GetData() + offset, value.GetAsFloatPtr(), 64) == 0;
+	}
+}
+
+TEST(Std140Packer_Alignment)
+{
+	Std140Packer packer;
+	packer.Float(1.0f);
+	// A vec3 starts on 16, a float after it fills the 4th component
+	packer.Vec3(Vector3(2.0f, 3.0f, 4.0f));
+	CHECK(HasVec3(packer, 16, Vector3(2.0f, 3.0f, 4.0f)));
+	packer.Float(5.0f);
+	CHECK(packer.GetOffset() == 32);
+	CHECK(ReadFloat(packer, 28) == 5.0f);
+	// A vec2 starts on 8
+	packer.Float(6.0f);
+	packer.Vec2(Vector2(7.0f, 8.0f));
+	CHECK(ReadFloat(packer, 40) == 7.0f && packer.GetOffset() == 48);
+
+	// Structs start and end on 16
+	packer.Float(9.0f);
+	packer.BeginStruct();
+	CHECK(packer.GetOffset() == 64);
+	packer.Float(10.0f);
+	packer.EndStruct();
+	CHECK(packer.GetOffset() == 80);
+	packer.Float(11.0f);
+	CHECK(ReadFloat(packer, 80) == 11.0f);
+	packer.End();
+	CHECK(packer.GetSize() == 96);
+	// Padding is zeroed
+	CHECK(ReadFloat(packer, 4) == 0.0f && ReadFloat(packer, 68) == 0.0f);
+
+	packer.Reset();
+	CHECK(packer.GetSize() == 0);
+	packer.Mat4(Matrix4::CreateTranslation(Vector3(1.0f, 2.0f, 3.0f)));
+	packer.End();
+	CHECK(packer.GetSize() == 64);
+	CHECK(HasMat4(packer, 0, Matrix4::CreateTranslation(Vector3(1.0f, 2.0f, 3.0f))));
+}
+
+TEST(Std140Packer_FrameDataLayout)
+{
+	// The block the Renderer uploads, against the offsets GL gives the
+	// FrameData block of the shaders. The renderer is never initialized.
+	Game game;
+	game.InitializeHeadless();
+	Renderer* renderer = game.GetRenderer();
+	Matrix4 view = Matrix4::CreateLookAt(Vector3(-100.0f, 0.0f, 50.0f), Vector3::Zero, Vector3::UnitZ);
+	renderer->SetViewMatrix(view);
+	renderer->SetAmbientLight(Vector3(0.1f, 0.2f, 0.3f));
+	DirectionalLight& light = renderer->GetDirectionalLight();
+	light.mDirection = Vector3(0.0f, -0.7f, -0.7f);
+	light.mDiffuseColor = Vector3(0.78f, 0.88f, 1.0f);
+	light.mSpecColor = Vector3(0.8f, 0.8f, 0.8f);
+	const Std140Packer& packer = renderer->PackFrameData();
+
+	Matrix4 invView = view;
+	invView.Invert();
+	// uView, uProjection, uViewProjection, uSpriteViewProj, then the
+	// camera position and ambient light. The projections stay identity
+	// without Initialize.
+	CHECK(HasMat4(packer, 0, view));
+	CHECK(HasMat4(packer, 64, Matrix4::Identity));
+	CHECK(HasMat4(packer, 128, view * Matrix4::Identity));
+	CHECK(HasMat4(packer, 192, Matrix4::Identity));
+	CHECK(HasVec3(packer, 256, invView.GetTranslation()));
+	CHECK(HasVec3(packer, 272, Vector3(0.1f, 0.2f, 0.3f)));
+	// uDirLight starts on 16, each member on its own vec4
+	CHECK(HasVec3(packer, 288, light.mDirection));
+	CHECK(HasVec3(packer, 304, light.mDiffuseColor));
+	CHECK(HasVec3(packer, 320, light.mSpecColor));
+	// GL_UNIFORM_BLOCK_DATA_SIZE, which BindUniformBlock checks
+	CHECK(packer.GetSize() == 336);
+	game.ShutDown();
+}
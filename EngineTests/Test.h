@@ -0,0 +1,79 @@
+#pragma once
+#include<chrono>
+#include<cmath>
+#include<cstdio>
+#include<vector>
+
+// Tiny test and benchmark registry of EngineTests.
+//
+// TEST(Name) { CHECK(...); } registers a test, a failed check is reported
+// and the test carries on. BENCH(Name) { ... } registers a benchmark,
+// which only runs with -bench and prints its own timings.
+namespace EngineTests
+{
+	typedef void (*TestFunction)();
+
+	struct TestCase
+	{
+		const char* mName;
+		TestFunction mFunction;
+		bool mIsBench;
+	};
+
+	std::vector<TestCase>& GetTestCases();
+	void ReportFailure(const char* file, int line, const char* expression);
+
+	struct Registrar
+	{
+		Registrar(const char* name, TestFunction function, bool isBench)
+		{
+			GetTestCases().emplace_back(TestCase{ name, function, isBench });
+		}
+	};
+
+	// Wall clock milliseconds since construction or Reset
+	class Timer
+	{
+	public:
+		Timer() { Reset(); }
+		void Reset() { mStart = std::chrono::steady_clock::now(); }
+		double GetMilliseconds() const
+		{
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - mStart).count();
+		}
+
+	private:
+		std::chrono::steady_clock::time_point mStart;
+	};
+
+	// Fastest of runs calls to function, in milliseconds
+	template<typename Function>
+	double BestOf(int runs, const Function& function)
+	{
+		double best = 0.0;
+		for (int i = 0; i < runs; i++)
+		{
+			Timer timer;
+			function();
+			double ms = timer.GetMilliseconds();
+			best = (i == 0 || ms < best) ? ms : best;
+		}
+		return best;
+	}
+}
+
+#define TEST(name) \
+	static void Test_##name(); \
+	static EngineTests::Registrar Register_##name(#name, &Test_##name, false); \
+	static void Test_##name()
+
+#define BENCH(name) \
+	static void Bench_##name(); \
+	static EngineTests::Registrar RegisterBench_##name(#name, &Bench_##name, true); \
+	static void Bench_##name()
+
+#define CHECK(condition) \
+	do { if (!(condition)) { EngineTests::ReportFailure(__FILE__, __LINE__, #condition); } } while (0)
+
+// |a - b| <= tolerance
+#define CHECK_NEAR(a, b, tolerance) CHECK(std::fabs((a) - (b)) <= (tolerance))
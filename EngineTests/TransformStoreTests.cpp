@@ -0,0 +1,260 @@
+#include"Test.h"
+#include"TransformStore.h"
+#include"JobSystem.h"
+#include<random>
+#include<thread>
+#include<vector>
+
+namespace
+{
+	struct Locals
+	{
+		std::vector<Vector3> mPositions;
+		std::vector<Quaternion> mRotations;
+		std::vector<float> mScales;
+		std::vector<Vector2> m2DPositions;
+		std::vector<float> m2DRotations;
+
+		Locals(size_t count, unsigned int seed)
+		{
+			std::mt19937 random(seed);
+			std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+			for (size_t i = 0; i < count; i++)
+			{
+				mPositions.emplace_back(Vector3(unit(random) * 1000.0f, unit(random) * 1000.0f, unit(random) * 1000.0f));
+				Vector3 axis(unit(random) - 0.5f, unit(random) - 0.5f, unit(random) + 0.1f);
+				axis.Normalize();
+				mRotations.emplace_back(Quaternion(axis, unit(random) * 6.0f));
+				mScales.emplace_back(unit(random) * 10.0f + 0.1f);
+				m2DPositions.emplace_back(Vector2(unit(random) * 100.0f, unit(random) * 100.0f));
+				m2DRotations.emplace_back(unit(random) * 6.0f);
+			}
+		}
+
+		void Set(TransformStore& store, TransformHandle handle, size_t i) const
+		{
+			store.SetPosition(handle, mPositions[i]);
+			store.SetRotation(handle, mRotations[i]);
+			store.SetScale(handle, mScales[i]);
+			store.Set2DRotation(handle, m2DRotations[i]);
+			store.Set2DPosition(handle, m2DPositions[i]);
+		}
+
+		// The local transform as each actor used to build it, one general
+		// matrix multiply per part
+		Matrix4 Multiply(size_t i) const
+		{
+			Matrix4 local = Matrix4::CreateScale(mScales[i]);
+			local *= Matrix4::CreateRotationZ(m2DRotations[i]);
+			local *= Matrix4::CreateTranslation(Vector3(m2DPositions[i].x, m2DPositions[i].y, 0.0f));
+			local *= Matrix4::CreateFromQuaternion(mRotations[i]);
+			local *= Matrix4::CreateTranslation(mPositions[i]);
+			return local;
+		}
+	};
+
+	// Largest difference relative to the magnitude of the entry
+	float RelativeError(const Matrix4& a, const Matrix4& b)
+	{
+		float error = 0.0f;
+		for (int row = 0; row < 4; row++)
+		{
+			for (int col = 0; col < 4; col++)
+			{
+				float diff = std::fabs(a.matrix[row][col] - b.matrix[row][col]) / (1.0f + std::fabs(b.matrix[row][col]));
+				error = diff > error ? diff : error;
+			}
+		}
+		return error;
+	}
+
+	// Owners are never dereferenced, they stand for node numbers here
+	class Actor* ToOwner(std::vector<char>& nodes, size_t i) { return reinterpret_cast<class Actor*>(&nodes[i]); }
+	size_t ToNode(const std::vector<char>& nodes, class Actor* owner) { return reinterpret_cast<const char*>(owner) - nodes.data(); }
+
+	// Nodes in [first, last) among the updated owners, and every updated
+	// owner in that range
+	bool UpdatedExactly(const std::vector<char>& nodes, const std::vector<class Actor*>& updated, size_t first, size_t last)
+	{
+		std::vector<int> visits(nodes.size(), 0);
+		for (class Actor* owner : updated)
+		{
+			visits[ToNode(nodes, owner)]++;
+		}
+		bool ok = updated.size() == last - first;
+		for (size_t i = 0; i < nodes.size(); i++)
+		{
+			ok = ok && visits[i] == (i >= first && i < last ? 1 : 0);
+		}
+		return ok;
+	}
+}
+
+TEST(TransformStore_ComposeMatchesMatrixProduct)
+{
+	const size_t count = 1000;
+	Locals locals(count, 3);
+	TransformStore store;
+	std::vector<TransformHandle> handles;
+	for (size_t i = 0; i < count; i++)
+	{
+		handles.emplace_back(store.Create(nullptr));
+	}
+	// Reused handles compose like fresh ones
+	for (size_t i = 0; i < count; i += 7)
+	{
+		store.Destroy(handles[i]);
+		handles[i] = store.Create(nullptr);
+	}
+	// Every tenth is the child of the one before
+	for (size_t i = 9; i < count; i += 10)
+	{
+		CHECK(store.SetParent(handles[i], handles[i - 1]));
+	}
+	for (size_t i = 0; i < count; i++)
+	{
+		locals.Set(store, handles[i], i);
+	}
+	CHECK(store.ComposeDirty().size() == count);
+
+	float error = 0.0f;
+	for (size_t i = 0; i < count; i++)
+	{
+		Matrix4 world = locals.Multiply(i);
+		if (i % 10 == 9)
+		{
+			world *= locals.Multiply(i - 1);
+		}
+		float diff = RelativeError(store.GetWorldTransform(handles[i]), world);
+		error = diff > error ? diff : error;
+	}
+	CHECK(error <= 1.0e-4f);
+	// Nothing changed since
+	CHECK(store.ComposeDirty().empty());
+
+	// Moving a parent recomposes its child
+	store.SetPosition(handles[8], Vector3::Zero);
+	CHECK(store.ComposeDirty().size() == 2);
+	CHECK(!store.IsDirty(handles[9]));
+}
+
+TEST(TransformStore_OnlyDirtySubtreesCompose)
+{
+	// A 10k deep chain, each node one unit along x from its parent, and a
+	// separate tree of 1000 that nothing moves
+	const size_t depth = 10000;
+	const size_t other = 1000;
+	std::vector<char> nodes(depth + other);
+	TransformStore store;
+	std::vector<TransformHandle> handles;
+	for (size_t i = 0; i < nodes.size(); i++)
+	{
+		handles.emplace_back(store.Create(ToOwner(nodes, i)));
+		store.SetPosition(handles[i], Vector3(1.0f, 0.0f, 0.0f));
+	}
+	bool linked = true;
+	for (size_t i = 1; i < depth; i++)
+	{
+		linked = linked && store.SetParent(handles[i], handles[i - 1]);
+	}
+	// Half a chain, half children of the other tree's root
+	for (size_t i = depth + 1; i < nodes.size(); i++)
+	{
+		linked = linked && store.SetParent(handles[i], handles[i < depth + other / 2 ? i - 1 : depth]);
+	}
+	CHECK(linked);
+	CHECK(store.GetDepth(handles[depth - 1]) == depth - 1);
+	CHECK(UpdatedExactly(nodes, store.ComposeDirty(), 0, nodes.size()));
+	CHECK(store.GetWorldTransform(handles[depth - 1]).GetTranslation().x == static_cast<float>(depth));
+
+	// The leaf alone, then the lower part of the chain, then all of it
+	store.SetPosition(handles[depth - 1], Vector3(2.0f, 0.0f, 0.0f));
+	CHECK(UpdatedExactly(nodes, store.ComposeDirty(), depth - 1, depth));
+	store.SetScale(handles[depth - 1000], 1.0f);
+	CHECK(UpdatedExactly(nodes, store.ComposeDirty(), depth - 1000, depth));
+	store.SetPosition(handles[0], Vector3(5.0f, 0.0f, 0.0f));
+	CHECK(UpdatedExactly(nodes, store.ComposeDirty(), 0, depth));
+	CHECK(store.GetWorldTransform(handles[depth - 1]).GetTranslation().x == static_cast<float>(depth + 5));
+	CHECK(store.ComposeDirty().empty());
+
+	// No cycles, and a refused parent changes nothing
+	CHECK(!store.SetParent(handles[0], handles[depth - 1]));
+	CHECK(!store.SetParent(handles[500], handles[500]));
+	CHECK(!store.SetParent(handles[depth], handles[nodes.size() - other / 2 - 1]));
+	CHECK(store.GetParent(handles[0]) == TransformStore::InvalidHandle);
+	CHECK(store.GetParent(handles[500]) == handles[499]);
+	CHECK(store.ComposeDirty().empty());
+
+	// Destroying the middle of the chain makes its child a root keeping
+	// its local transform, the rest of the chain moves with it
+	const size_t middle = depth / 2;
+	store.Destroy(handles[middle]);
+	CHECK(store.GetParent(handles[middle + 1]) == TransformStore::InvalidHandle);
+	CHECK(store.GetDepth(handles[middle + 1]) == 0);
+	CHECK(store.GetDepth(handles[depth - 1]) == depth - middle - 2);
+	CHECK(UpdatedExactly(nodes, store.ComposeDirty(), middle + 1, depth));
+	CHECK(store.GetWorldTransform(handles[middle + 1]).GetTranslation().x == 1.0f);
+	CHECK(store.GetWorldTransform(handles[depth - 1]).GetTranslation().x == static_cast<float>(depth - middle));
+	CHECK(store.GetWorldTransform(handles[middle - 1]).GetTranslation().x == static_cast<float>(middle + 4));
+}
+
+BENCH(TransformStore_100kTransforms)
+{
+	// Every transform moves each frame: the old per-actor matrix products
+	// against the store's setters and ComposeDirty
+	const size_t count = 100000;
+	Locals locals(count, 5);
+	std::vector<Matrix4> worlds(count);
+	double perActor = EngineTests::BestOf(5, [&locals, &worlds]()
+	{
+		for (size_t i = 0; i < worlds.size(); i++)
+		{
+			worlds[i] = locals.Multiply(i);
+		}
+	});
+	std::printf("  per actor matrix products: %.2f ms\n", perActor);
+
+	unsigned int workers = std::thread::hardware_concurrency();
+	workers = workers > 1 ? workers - 1 : 0;
+	JobSystem jobs(workers);
+	JobSystem* const jobSystems[] = { nullptr, &jobs };
+	// Without workers the second run would be the first one again
+	for (size_t run = 0; run < (workers > 0 ? 2u : 1u); run++)
+	{
+		JobSystem* jobSystem = jobSystems[run];
+		TransformStore store(jobSystem);
+		std::vector<TransformHandle> handles;
+		for (size_t i = 0; i < count; i++)
+		{
+			handles.emplace_back(store.Create(nullptr));
+		}
+		double setters = EngineTests::BestOf(5, [&locals, &store, &handles]()
+		{
+			for (size_t i = 0; i < handles.size(); i++)
+			{
+				locals.Set(store, handles[i], i);
+			}
+		});
+		// Only the compose is timed, the setters just mark everything dirty again
+		double compose = 0.0;
+		for (int i = 0; i < 5; i++)
+		{
+			for (size_t j = 0; j < handles.size(); j++)
+			{
+				locals.Set(store, handles[j], j);
+			}
+			EngineTests::Timer timer;
+			store.ComposeDirty();
+			double ms = timer.GetMilliseconds();
+			compose = (i == 0 || ms < compose) ? ms : compose;
+		}
+		float error = 0.0f;
+		for (size_t i = 0; i < count; i++)
+		{
+			float diff = RelativeError(store.GetWorldTransform(handles[i]), worlds[i]);
+			error = diff > error ? diff : error;
+		}
+		std::printf("  store, %u workers: %.2f ms setters + %.2f ms compose, max relative error %g\n",
+			jobSystem ? workers : 0, setters, compose, error);
+	}
+}
@@ -0,0 +1,136 @@
+#include<cstdio>
+#include<cstring>
+#include<string>
+#include<vector>
+#include"MeshData.h"
+#include"MeshFile.h"
+#include"MeshImporter.h"
+
+// Offline converter from source meshes (.gpmesh json, FBX) to the
+// cooked .gpbin format the game memory maps at load time.
+//
+// Usage:
+//   MeshCooker [-format <vertexformat>] ...
+//     Override the vertex format (PosNormTex, PosOctTex, QuantPosOctTex),
+//     gpmesh files otherwise use their "vertexformat" field
+//   MeshCooker <source> [output]
+//     Cook one file, the output defaults to the source name with .gpbin
+//   MeshCooker -cache <dir> <source>...
+//     Cook every source into the content hash keyed cache the game looks
+//     up before importing FBX files (the game uses MeshFile::CacheDirectory)
+
+namespace
+{
+	bool IsFBX(const std::string& fileName)
+	{
+		size_t dot = fileName.find_last_of('.');
+		if (dot == std::string::npos)
+		{
+			return false;
+		}
+		std::string ext = fileName.substr(dot);
+		return ext == ".fbx" || ext == ".FBX";
+	}
+
+	// Vertex format from -format (ECount keeps the source's own)
+	VertexFormat formatOverride = VertexFormat::ECount;
+
+	bool Cook(const std::string& source, const std::string& output)
+	{
+		MeshData data;
+		bool loaded = false;
+		if (IsFBX(source))
+		{
+			MeshImporter importer;
+			loaded = importer.LoadFBX(source, data);
+		}
+		else
+		{
+			loaded = MeshImporter::LoadGPMesh(source, data);
+		}
+
+		if (!loaded)
+		{
+			printf("Failed to load %s\n", source.c_str());
+			return false;
+		}
+
+		if (formatOverride != VertexFormat::ECount)
+		{
+			data.mVertexFormat = formatOverride;
+		}
+		if (data.mVertexFormat != VertexFormat::EPosNormTex)
+		{
+			std::vector<unsigned char> verts;
+			VertexQuantization quant;
+			VertexEncoder::Encode(data.mVertices.data(), data.GetNumVerts(), data.mVertexFormat, verts, quant);
+			VertexEncoder::LogError(source, data.mVertices.data(), data.GetNumVerts(),
+				data.mVertexFormat, verts.data(), quant);
+		}
+
+		if (!MeshFile::Write(data, output))
+		{
+			printf("Failed to write %s\n", output.c_str());
+			return false;
+		}
+
+		printf("%s -> %s: %zu sub meshes, %u vertices (%s), %zu indices, %zu textures\n",
+			source.c_str(), output.c_str(), data.mSubMeshes.size(), data.GetNumVerts(),
+			VertexEncoder::GetName(data.mVertexFormat), data.mIndices.size(), data.mTextures.size());
+		return true;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (argc > 2 && strcmp(argv[1], "-format") == 0)
+	{
+		if (!VertexEncoder::Parse(argv[2], formatOverride))
+		{
+			printf("Unknown vertex format %s\n", argv[2]);
+			return 1;
+		}
+		// Drop the option so the modes below see their usual arguments
+		argv[2] = argv[0];
+		argv += 2;
+		argc -= 2;
+	}
+
+	if (argc < 2)
+	{
+		printf("Usage: %s [-format <vertexformat>] <source.gpmesh|source.fbx> [output%s]\n", argv[0], MeshFile::Extension);
+		printf("       %s [-format <vertexformat>] -cache <dir> <source>...\n", argv[0]);
+		return 1;
+	}
+
+	if (strcmp(argv[1], "-cache") != 0)
+	{
+		std::string source = argv[1];
+		std::string output = argc > 2 ? argv[2] : MeshFile::GetCookedName(source);
+		return Cook(source, output) ? 0 : 1;
+	}
+
+	// Cache mode
+	if (argc < 4)
+	{
+		printf("Usage: %s -cache <dir> <source>...\n", argv[0]);
+		return 1;
+	}
+	std::string cacheDir = argv[2];
+	if (!MeshFile::MakeDirectory(cacheDir))
+	{
+		printf("Failed to create cache directory %s\n", cacheDir.c_str());
+		return 1;
+	}
+
+	int failed = 0;
+	for (int i = 3; i < argc; i++)
+	{
+		std::string output = MeshFile::GetCacheName(argv[i], cacheDir);
+		if (output.empty() || !Cook(argv[i], output))
+		{
+			failed++;
+		}
+	}
+	return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include"Math.h"
+
+// Axis aligned bounding box
+struct AABB
+{
+	Vector3 mMin;
+	Vector3 mMax;
+
+	AABB() {}
+	AABB(const Vector3& min, const Vector3& max)
+		:mMin(min)
+		, mMax(max)
+	{
+	}
+
+	static AABB FromSphere(const Vector3& center, float radius)
+	{
+		Vector3 extent(radius, radius, radius);
+		return AABB(center - extent, center + extent);
+	}
+
+	static AABB Union(const AABB& a, const AABB& b)
+	{
+		return AABB(Vector3(Math::Min(a.mMin.x, b.mMin.x), Math::Min(a.mMin.y, b.mMin.y), Math::Min(a.mMin.z, b.mMin.z)),
+			Vector3(Math::Max(a.mMax.x, b.mMax.x), Math::Max(a.mMax.y, b.mMax.y), Math::Max(a.mMax.z, b.mMax.z)));
+	}
+
+	// Grow by margin on every side
+	AABB Expanded(float margin) const
+	{
+		Vector3 extent(margin, margin, margin);
+		return AABB(mMin - extent, mMax + extent);
+	}
+
+	bool Contains(const AABB& other) const
+	{
+		return mMin.x <= other.mMin.x && mMin.y <= other.mMin.y && mMin.z <= other.mMin.z &&
+			mMax.x >= other.mMax.x && mMax.y >= other.mMax.y && mMax.z >= other.mMax.z;
+	}
+
+	bool Overlaps(const AABB& other) const
+	{
+		return mMin.x <= other.mMax.x && mMax.x >= other.mMin.x &&
+			mMin.y <= other.mMax.y && mMax.y >= other.mMin.y &&
+			mMin.z <= other.mMax.z && mMax.z >= other.mMin.z;
+	}
+
+	bool OverlapsSphere(const Vector3& center, float radius) const
+	{
+		// Closest point of the box to the center
+		Vector3 closest(Math::Clamp(center.x, mMin.x, mMax.x),
+			Math::Clamp(center.y, mMin.y, mMax.y),
+			Math::Clamp(center.z, mMin.z, mMax.z));
+		return (closest - center).LengthSq() <= radius * radius;
+	}
+
+	// Slab test of start + t * dir for t in [0, maxT], outT is the entry point
+	bool IntersectRay(const Vector3& start, const Vector3& invDir, float maxT, float& outT) const
+	{
+		float tMin = 0.0f;
+		float tMax = maxT;
+		const float* s = start.GetAsFloatPtr();
+		const float* inv = invDir.GetAsFloatPtr();
+		const float* lo = mMin.GetAsFloatPtr();
+		const float* hi = mMax.GetAsFloatPtr();
+		for (int i = 0; i < 3; i++)
+		{
+			float t1 = (lo[i] - s[i]) * inv[i];
+			float t2 = (hi[i] - s[i]) * inv[i];
+			if (t1 > t2)
+			{
+				float temp = t1;
+				t1 = t2;
+				t2 = temp;
+			}
+			tMin = Math::Max(tMin, t1);
+			tMax = Math::Min(tMax, t2);
+			if (tMin > tMax)
+			{
+				return false;
+			}
+		}
+		outT = tMin;
+		return true;
+	}
+
+	// Half the surface area, the insertion cost metric
+	float GetArea() const
+	{
+		Vector3 d = mMax - mMin;
+		return d.x * d.y + d.y * d.z + d.z * d.x;
+	}
+
+	Vector3 GetCenter() const
+	{
+		return (mMin + mMax) * 0.5f;
+	}
+};
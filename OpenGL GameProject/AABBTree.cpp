@@ -0,0 +1,260 @@
+#include"AABBTree.h"
+
+const int AABBTree::NullNode;
+
+AABBTree::AABBTree(float margin)
+	:mRoot(NullNode)
+	, mFreeList(NullNode)
+	, mProxyCount(0)
+	, mMargin(margin)
+{
+}
+
+int AABBTree::CreateProxy(const AABB& box, void* userData)
+{
+	int proxy = AllocateNode();
+	mNodes[proxy].mBox = box.Expanded(mMargin);
+	mNodes[proxy].mUserData = userData;
+	mNodes[proxy].mHeight = 0;
+	InsertLeaf(proxy);
+	mProxyCount++;
+	return proxy;
+}
+
+void AABBTree::DestroyProxy(int proxy)
+{
+	RemoveLeaf(proxy);
+	FreeNode(proxy);
+	mProxyCount--;
+}
+
+bool AABBTree::MoveProxy(int proxy, const AABB& box)
+{
+	if (mNodes[proxy].mBox.Contains(box))
+	{
+		return false;
+	}
+	RemoveLeaf(proxy);
+	mNodes[proxy].mBox = box.Expanded(mMargin);
+	InsertLeaf(proxy);
+	return true;
+}
+
+int AABBTree::AllocateNode()
+{
+	int node = mFreeList;
+	if (node == NullNode)
+	{
+		node = static_cast<int>(mNodes.size());
+		mNodes.emplace_back();
+	}
+	else
+	{
+		mFreeList = mNodes[node].mParent;
+	}
+	Node& n = mNodes[node];
+	n.mUserData = nullptr;
+	n.mParent = NullNode;
+	n.mChild1 = NullNode;
+	n.mChild2 = NullNode;
+	n.mHeight = 0;
+	return node;
+}
+
+void AABBTree::FreeNode(int node)
+{
+	mNodes[node].mParent = mFreeList;
+	mNodes[node].mHeight = -1;
+	mFreeList = node;
+}
+
+void AABBTree::InsertLeaf(int leaf)
+{
+	if (mRoot == NullNode)
+	{
+		mRoot = leaf;
+		mNodes[leaf].mParent = NullNode;
+		return;
+	}
+
+	// Descend towards the sibling that grows the total area the least
+	const AABB leafBox = mNodes[leaf].mBox;
+	int index = mRoot;
+	while (!mNodes[index].IsLeaf())
+	{
+		const Node& node = mNodes[index];
+		float area = node.mBox.GetArea();
+		float combinedArea = AABB::Union(node.mBox, leafBox).GetArea();
+
+		// Cost of making a new parent for this node and the leaf
+		float cost = 2.0f * combinedArea;
+		// Minimum cost of pushing the leaf further down
+		float inheritanceCost = 2.0f * (combinedArea - area);
+
+		float childCost[2];
+		int children[2] = { node.mChild1, node.mChild2 };
+		for (int i = 0; i < 2; i++)
+		{
+			const Node& child = mNodes[children[i]];
+			float newArea = AABB::Union(child.mBox, leafBox).GetArea();
+			if (child.IsLeaf())
+			{
+				childCost[i] = newArea + inheritanceCost;
+			}
+			else
+			{
+				childCost[i] = newArea - child.mBox.GetArea() + inheritanceCost;
+			}
+		}
+
+		if (cost < childCost[0] && cost < childCost[1])
+		{
+			break;
+		}
+		index = childCost[0] < childCost[1] ? children[0] : children[1];
+	}
+	int sibling = index;
+
+	// New parent holding the sibling and the leaf
+	int oldParent = mNodes[sibling].mParent;
+	int newParent = AllocateNode();
+	mNodes[newParent].mParent = oldParent;
+	mNodes[newParent].mBox = AABB::Union(leafBox, mNodes[sibling].mBox);
+	mNodes[newParent].mHeight = mNodes[sibling].mHeight + 1;
+	mNodes[newParent].mChild1 = sibling;
+	mNodes[newParent].mChild2 = leaf;
+	mNodes[sibling].mParent = newParent;
+	mNodes[leaf].mParent = newParent;
+
+	if (oldParent == NullNode)
+	{
+		mRoot = newParent;
+	}
+	else if (mNodes[oldParent].mChild1 == sibling)
+	{
+		mNodes[oldParent].mChild1 = newParent;
+	}
+	else
+	{
+		mNodes[oldParent].mChild2 = newParent;
+	}
+
+	Refit(mNodes[leaf].mParent);
+}
+
+void AABBTree::RemoveLeaf(int leaf)
+{
+	if (leaf == mRoot)
+	{
+		mRoot = NullNode;
+		return;
+	}
+
+	// The sibling takes the parent's place
+	int parent = mNodes[leaf].mParent;
+	int grandParent = mNodes[parent].mParent;
+	int sibling = mNodes[parent].mChild1 == leaf ? mNodes[parent].mChild2 : mNodes[parent].mChild1;
+
+	if (grandParent == NullNode)
+	{
+		mRoot = sibling;
+		mNodes[sibling].mParent = NullNode;
+		FreeNode(parent);
+		return;
+	}
+
+	if (mNodes[grandParent].mChild1 == parent)
+	{
+		mNodes[grandParent].mChild1 = sibling;
+	}
+	else
+	{
+		mNodes[grandParent].mChild2 = sibling;
+	}
+	mNodes[sibling].mParent = grandParent;
+	FreeNode(parent);
+
+	Refit(grandParent);
+}
+
+void AABBTree::Refit(int node)
+{
+	while (node != NullNode)
+	{
+		node = Balance(node);
+
+		Node& n = mNodes[node];
+		const Node& child1 = mNodes[n.mChild1];
+		const Node& child2 = mNodes[n.mChild2];
+		n.mHeight = 1 + Math::Max(child1.mHeight, child2.mHeight);
+		n.mBox = AABB::Union(child1.mBox, child2.mBox);
+
+		node = n.mParent;
+	}
+}
+
+int AABBTree::Balance(int a)
+{
+	// a has children b and c. If c is more than one level taller than b,
+	// c takes a's place with a and the taller of c's children below it,
+	// and the shorter one moves under a (mirrored when b is taller).
+	Node& A = mNodes[a];
+	if (A.IsLeaf() || A.mHeight < 2)
+	{
+		return a;
+	}
+
+	int b = A.mChild1;
+	int c = A.mChild2;
+	int balance = mNodes[c].mHeight - mNodes[b].mHeight;
+	if (balance >= -1 && balance <= 1)
+	{
+		return a;
+	}
+
+	// Rotate the taller child up
+	int up = balance > 1 ? c : b;
+	int other = balance > 1 ? b : c;
+	Node& U = mNodes[up];
+	int f = U.mChild1;
+	int g = U.mChild2;
+
+	// Swap a and up
+	U.mChild1 = a;
+	U.mParent = A.mParent;
+	A.mParent = up;
+
+	if (U.mParent == NullNode)
+	{
+		mRoot = up;
+	}
+	else if (mNodes[U.mParent].mChild1 == a)
+	{
+		mNodes[U.mParent].mChild1 = up;
+	}
+	else
+	{
+		mNodes[U.mParent].mChild2 = up;
+	}
+
+	// The taller grandchild stays under up, the other replaces up under a
+	int keep = mNodes[f].mHeight > mNodes[g].mHeight ? f : g;
+	int give = keep == f ? g : f;
+	U.mChild2 = keep;
+	if (balance > 1)
+	{
+		A.mChild2 = give;
+	}
+	else
+	{
+		A.mChild1 = give;
+	}
+	mNodes[give].mParent = a;
+
+	A.mBox = AABB::Union(mNodes[other].mBox, mNodes[give].mBox);
+	A.mHeight = 1 + Math::Max(mNodes[other].mHeight, mNodes[give].mHeight);
+	U.mBox = AABB::Union(A.mBox, mNodes[keep].mBox);
+	U.mHeight = 1 + Math::Max(A.mHeight, mNodes[keep].mHeight);
+
+	return up;
+}
@@ -0,0 +1,267 @@
+#pragma once
+#include<vector>
+#include"AABB.h"
+#include"Frustum.h"
+
+// Dynamic AABB tree: leaves hold a fattened box around each proxy so
+// small moves don't touch the tree, and inserts keep it balanced with
+// rotations so queries stay O(log n).
+//
+// Query callbacks take the proxy id and return false to stop the query.
+class AABBTree
+{
+public:
+	static const int NullNode = -1;
+
+	// margin: how far leaf boxes are fattened on every side
+	AABBTree(float margin = 5.0f);
+
+	// Add a proxy for box, returns its id
+	int CreateProxy(const AABB& box, void* userData);
+	void DestroyProxy(int proxy);
+	// Update the box of proxy. Returns true if it left its fat box and
+	// was reinserted.
+	bool MoveProxy(int proxy, const AABB& box);
+
+	void* GetUserData(int proxy) const { return mNodes[proxy].mUserData; }
+	const AABB& GetFatAABB(int proxy) const { return mNodes[proxy].mBox; }
+	size_t GetProxyCount() const { return mProxyCount; }
+	// Height of the root (0 for a single leaf, -1 when empty)
+	int GetHeight() const { return mRoot == NullNode ? -1 : mNodes[mRoot].mHeight; }
+
+	template<typename Callback>
+	void QueryAABB(const AABB& box, Callback callback) const;
+	template<typename Callback>
+	void QuerySphere(const Vector3& center, float radius, Callback callback) const;
+	// Proxies whose fat box touches the frustum
+	template<typename Callback>
+	void QueryFrustum(const Frustum& frustum, Callback callback) const;
+	// Cast the segment start -> end. callback(proxy, fraction) tests the
+	// proxy's own shape against the segment clipped to fraction and returns
+	// its hit fraction (< 0 for a miss). Returns the closest hit proxy, or
+	// NullNode, and its fraction in outFraction.
+	template<typename Callback>
+	int RayCast(const Vector3& start, const Vector3& end, Callback callback, float& outFraction) const;
+
+private:
+	struct Node
+	{
+		AABB mBox;
+		void* mUserData;
+		// Parent, or the next free node when on the free list
+		int mParent;
+		int mChild1;
+		int mChild2;
+		// Leaf is 0, free node is -1
+		int mHeight;
+
+		bool IsLeaf() const { return mChild1 == NullNode; }
+	};
+
+	// Traversal stack, only allocates for very deep trees
+	class Stack
+	{
+	public:
+		Stack() :mCount(0) {}
+		void Push(int node)
+		{
+			if (mCount < FixedSize)
+			{
+				mFixed[mCount] = node;
+			}
+			else
+			{
+				mOverflow.emplace_back(node);
+			}
+			mCount++;
+		}
+		int Pop()
+		{
+			mCount--;
+			if (mCount < FixedSize)
+			{
+				return mFixed[mCount];
+			}
+			int node = mOverflow.back();
+			mOverflow.pop_back();
+			return node;
+		}
+		bool Empty() const { return mCount == 0; }
+	private:
+		static const size_t FixedSize = 64;
+		int mFixed[FixedSize];
+		std::vector<int> mOverflow;
+		size_t mCount;
+	};
+
+	int AllocateNode();
+	void FreeNode(int node);
+	void InsertLeaf(int leaf);
+	void RemoveLeaf(int leaf);
+	// Rotate the subtree at node if it is out of balance, returns its new root
+	int Balance(int node);
+	// Walk from node to the root refitting boxes and heights
+	void Refit(int node);
+
+	std::vector<Node> mNodes;
+	int mRoot;
+	int mFreeList;
+	size_t mProxyCount;
+	float mMargin;
+};
+
+template<typename Callback>
+void AABBTree::QueryAABB(const AABB& box, Callback callback) const
+{
+	Stack stack;
+	if (mRoot != NullNode)
+	{
+		stack.Push(mRoot);
+	}
+	while (!stack.Empty())
+	{
+		const Node& node = mNodes[stack.Pop()];
+		if (!node.mBox.Overlaps(box))
+		{
+			continue;
+		}
+		if (node.IsLeaf())
+		{
+			if (!callback(static_cast<int>(&node - mNodes.data())))
+			{
+				return;
+			}
+		}
+		else
+		{
+			stack.Push(node.mChild1);
+			stack.Push(node.mChild2);
+		}
+	}
+}
+
+template<typename Callback>
+void AABBTree::QuerySphere(const Vector3& center, float radius, Callback callback) const
+{
+	Stack stack;
+	if (mRoot != NullNode)
+	{
+		stack.Push(mRoot);
+	}
+	while (!stack.Empty())
+	{
+		const Node& node = mNodes[stack.Pop()];
+		if (!node.mBox.OverlapsSphere(center, radius))
+		{
+			continue;
+		}
+		if (node.IsLeaf())
+		{
+			if (!callback(static_cast<int>(&node - mNodes.data())))
+			{
+				return;
+			}
+		}
+		else
+		{
+			stack.Push(node.mChild1);
+			stack.Push(node.mChild2);
+		}
+	}
+}
+
+template<typename Callback>
+void AABBTree::QueryFrustum(const Frustum& frustum, Callback callback) const
+{
+	// Nodes fully inside skip the plane tests for their whole subtree
+	Stack stack;
+	Stack inside;
+	if (mRoot != NullNode)
+	{
+		stack.Push(mRoot);
+	}
+	while (!stack.Empty())
+	{
+		int index = stack.Pop();
+		const Node& node = mNodes[index];
+		Frustum::Containment containment = frustum.ClassifyAABB(node.mBox);
+		if (containment == Frustum::Containment::EOutside)
+		{
+			continue;
+		}
+		if (node.IsLeaf())
+		{
+			if (!callback(index))
+			{
+				return;
+			}
+		}
+		else if (containment == Frustum::Containment::EInside)
+		{
+			inside.Push(index);
+			while (!inside.Empty())
+			{
+				const Node& child = mNodes[inside.Pop()];
+				if (child.IsLeaf())
+				{
+					if (!callback(static_cast<int>(&child - mNodes.data())))
+					{
+						return;
+					}
+				}
+				else
+				{
+					inside.Push(child.mChild1);
+					inside.Push(child.mChild2);
+				}
+			}
+		}
+		else
+		{
+			stack.Push(node.mChild1);
+			stack.Push(node.mChild2);
+		}
+	}
+}
+
+template<typename Callback>
+int AABBTree::RayCast(const Vector3& start, const Vector3& end, Callback callback, float& outFraction) const
+{
+	Vector3 dir = end - start;
+	Vector3 invDir(1.0f / dir.x, 1.0f / dir.y, 1.0f / dir.z);
+	float maxFraction = 1.0f;
+	int hit = NullNode;
+
+	Stack stack;
+	if (mRoot != NullNode)
+	{
+		stack.Push(mRoot);
+	}
+	while (!stack.Empty())
+	{
+		int index = stack.Pop();
+		const Node& node = mNodes[index];
+		float t;
+		if (!node.mBox.IntersectRay(start, invDir, maxFraction, t))
+		{
+			continue;
+		}
+		if (node.IsLeaf())
+		{
+			float fraction = callback(index, maxFraction);
+			if (fraction >= 0.0f && fraction <= maxFraction)
+			{
+				// Anything further than this hit can be skipped
+				maxFraction = fraction;
+				hit = index;
+			}
+		}
+		else
+		{
+			stack.Push(node.mChild1);
+			stack.Push(node.mChild2);
+		}
+	}
+	outFraction = maxFraction;
+	return hit;
+}
@@ -5,13 +5,11 @@
 
 Actor::Actor(Game* game)
 	:mState(State::EActive)
-	,m2Position(Vector2::Zero)
-	,mScale(1.0f)
-	,m2Rotation(0.0f)
+	,mTransforms(game->GetTransformStore())
 	,mGame(game)
-	,mRecomputeWorldTransform(false)
 {
-	mGame->AddActor(this);
+	mTransform = mTransforms->Create(this);
+	mHandle = mGame->AddActor(this);
 }
 
 Actor::~Actor()
@@ -23,16 +21,15 @@ Actor::~Actor()
 	{
 		delete mComponents.back();
 	}
+	mTransforms->Destroy(mTransform);
 }
 
 void Actor::Update(float deltaTime)
 {
 	if (mState == State::EActive)
 	{
-		ComputeWorldTransform();
 		UpdateComponents(deltaTime);
 		UpdateActor(deltaTime);
-		ComputeWorldTransform();
 	}
 }
 
@@ -43,7 +40,7 @@ void Actor::UpdateActor(float deltaTime)
 
 void Actor::UpdateComponents(float deltaTime)
 {
-	//First process input for components
+	// In update order, whatever their access
 	for (auto comp : mComponents)
 	{
 		comp->Update(deltaTime);
@@ -93,21 +90,31 @@ void Actor::RemoveComponent(Component* component)
 	}
 }
 
+bool Actor::SetParent(Actor* parent)
+{
+	return mTransforms->SetParent(mTransform,
+		parent ? parent->mTransform : TransformStore::InvalidHandle);
+}
+
+Actor* Actor::GetParent() const
+{
+	TransformHandle parent = mTransforms->GetParent(mTransform);
+	return parent != TransformStore::InvalidHandle ? mTransforms->GetOwner(parent) : nullptr;
+}
+
 void Actor::ComputeWorldTransform()
 {
-	if (mRecomputeWorldTransform)
+	if (mTransforms->Compose(mTransform))
 	{
-		mRecomputeWorldTransform = false;
-		//Scale, then rotate, then translate
-		mWorldTransform = Matrix4::CreateScale(mScale);
-		mWorldTransform *= Matrix4::CreateRotationZ(m2Rotation);
-		mWorldTransform *= Matrix4::CreateTranslation(Vector3(m2Position.x, m2Position.y, 0.0f));
-		mWorldTransform *= Matrix4::CreateFromQuaternion(m3Rotation);
-		mWorldTransform *= Matrix4::CreateTranslation(m3Position);
-		//Inform components world transform updated
-		for (auto comp : mComponents)
-		{
-			comp->OnUpdateWorldTransform();
-		}
+		OnWorldTransformUpdated();
+	}
+}
+
+void Actor::OnWorldTransformUpdated()
+{
+	//Inform components world transform updated
+	for (auto comp : mComponents)
+	{
+		comp->OnUpdateWorldTransform();
 	}
 }
\ No newline at end of file
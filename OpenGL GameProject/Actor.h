@@ -1,5 +1,8 @@
 #pragma once
 #include"Math.h"
+#include"TransformStore.h"
+#include"ObjectPool.h"
+#include"SlotMap.h"
 #include<vector>
 #include<cstdint>
 
@@ -16,8 +19,17 @@ public:
 
 	Actor(class Game* game);
 	virtual ~Actor();
-    void Update(float deltaTime);
+	// Actors of every type come from the ObjectPool
+	OBJECT_POOL_OPERATORS
+	// Update the components, then UpdateActor, all at once on the calling
+	// thread. Game doesn't call it: its ComponentScheduler runs the
+	// components of every actor in steps, in update order for each actor,
+	// and calls UpdateActor serially at the end of the last step updating
+	// one of the actor's components (after every step if none is).
+	// Other actors' components may run before or after UpdateActor.
+	void Update(float deltaTime);
 	void UpdateComponents(float deltaTime);
+	// Called once the actor's own components have updated
 	virtual void UpdateActor(float deltaTime);
 	void AddComponent(class Component* component);
 	void RemoveComponent(class Component* component);
@@ -29,43 +41,55 @@ public:
 	
 	// Getters/setters
 
-	void SetPosition(const Vector2& position) { m2Position = position; }
-	const Vector2& GetPosition() const { return m2Position; }
+	void SetPosition(const Vector2& position) { mTransforms->Set2DPosition(mTransform, position); }
+	const Vector2& GetPosition() const { return mTransforms->Get2DPosition(mTransform); }
 	
-	void SetScale(float scale) { mScale = scale; }
-	float GetScale() const { return mScale; }
+	void SetScale(float scale) { mTransforms->SetScale(mTransform, scale); }
+	float GetScale() const { return mTransforms->GetScale(mTransform); }
 
-	void SetRotation(float rotation) { m2Rotation = rotation; }
-	float GetRotation() const { return m2Rotation; }
+	void SetRotation(float rotation) { mTransforms->Set2DRotation(mTransform, rotation); }
+	float GetRotation() const { return mTransforms->Get2DRotation(mTransform); }
 
 	void SetState(State state) { mState = state; }
 	State GetState()const { return mState; }
 
 	//3D
-	void SetVec3Position(const Vector3& pos) { m3Position = pos; mRecomputeWorldTransform = true; }
-	const Vector3& GetVec3Position() const { return m3Position; }
-	Vector3 GetForward() const { return Vector3::Transform(Vector3::UnitX, m3Rotation); }
+	void SetVec3Position(const Vector3& pos) { mTransforms->SetPosition(mTransform, pos); }
+	const Vector3& GetVec3Position() const { return mTransforms->GetPosition(mTransform); }
+	Vector3 GetForward() const { return Vector3::Transform(Vector3::UnitX, GetQRotation()); }
 	
-	void SetQRotation(const Quaternion& rotation) { m3Rotation = rotation;  mRecomputeWorldTransform = true; }
-	const Quaternion& GetQRotation() const { return m3Rotation; }
+	void SetQRotation(const Quaternion& rotation) { mTransforms->SetRotation(mTransform, rotation); }
+	const Quaternion& GetQRotation() const { return mTransforms->GetRotation(mTransform); }
 
-	const Matrix4& GetWorldTransform() const { return mWorldTransform; }
+	// Attach to parent (nullptr detaches), world = local * parent world.
+	// Returns false if parent is this actor or one of its children.
+	bool SetParent(Actor* parent);
+	Actor* GetParent() const;
+
+	// This actor's entry in the game's TransformStore
+	TransformHandle GetTransformHandle() const { return mTransform; }
+
+	// World transforms are composed in batches by Game through the TransformStore
+	const Matrix4& GetWorldTransform() const { return mTransforms->GetWorldTransform(mTransform); }
+	// World transform blended between the last two simulation steps, for drawing
+	const Matrix4& GetRenderTransform() const { return mTransforms->GetRenderTransform(mTransform); }
+	// Compose this actor's world transform now if it is dirty
 	void ComputeWorldTransform();
+	// Inform components the world transform was recomputed
+	void OnWorldTransformUpdated();
 
 	class Game* GetGame(){ return mGame; }
+	// Game's handle for this actor, see Game::GetActor
+	SlotHandle GetHandle() const { return mHandle; }
+	// Sorted by update order
+	const std::vector<class Component*>& GetComponents() const { return mComponents; }
 
 private:
 	State mState;
-	//For 2D environment
-	Vector2 m2Position;
-	float mScale;
-	float m2Rotation;
-
-	//For 3D environment
-	Vector3 m3Position;
-	Quaternion m3Rotation;
-	Matrix4 mWorldTransform;
-	bool mRecomputeWorldTransform;
+	//Position/rotation/scale and world transform live in the game's store
+	class TransformStore* mTransforms;
+	TransformHandle mTransform;
+	SlotHandle mHandle;
 
 	std::vector<class Component*> mComponents;
 	class Game* mGame;
@@ -24,6 +24,16 @@ void AnimeSpriteComponent::SetAnimeTextures(const std::vector<SDL_Texture*>& tex
 	/////////////////////
 }
 
+void AnimeSpriteComponent::SetAnimeRegions(const std::vector<AtlasRegion>& regions)
+{
+	mAnimeRegions = regions;
+	if (mAnimeRegions.size() > 0)
+	{
+		mCurrentFrame = 0.0f;
+		SetRegion(mAnimeRegions[0]);
+	}
+}
+
 void AnimeSpriteComponent::Update(float deltaTime)
 {
 	SpriteComponent::Update(deltaTime);
@@ -39,4 +49,15 @@ void AnimeSpriteComponent::Update(float deltaTime)
 
 		SetSDLTexture(mAnimeTextures[static_cast<int>(mCurrentFrame)]);
 	}
+	else if (mAnimeRegions.size() > 0)
+	{
+		mCurrentFrame += mAnimeFPS * deltaTime;
+
+		while (mCurrentFrame >= mAnimeRegions.size())
+		{
+			mCurrentFrame -= mAnimeRegions.size();
+		}
+
+		SetRegion(mAnimeRegions[static_cast<int>(mCurrentFrame)]);
+	}
 }
\ No newline at end of file
@@ -9,10 +9,14 @@ public:
 	AnimeSpriteComponent(Actor* owner, int drawOrder = 100);
 	void Update(float deltaTime) override;
 	void SetAnimeTextures(const std::vector<SDL_Texture*>& textures);
+	// Frames as atlas regions (see Renderer::GetSpriteRegion), so every
+	// frame draws from the same pages
+	void SetAnimeRegions(const std::vector<AtlasRegion>& regions);
 	void SetAnimeFPS(float fps) { mAnimeFPS = fps; }
 	float GetAnimeFPS() const { return mAnimeFPS; }
 private:
 	std::vector<SDL_Texture*> mAnimeTextures;
+	std::vector<AtlasRegion> mAnimeRegions;
 	float mCurrentFrame;
 	float mAnimeFPS;
 };
@@ -0,0 +1,199 @@
+#include"AssetLoader.h"
+#include"Mesh.h"
+#include"Texture.h"
+#include"SDL.h"
+#include"SOIL.h"
+
+const size_t AssetLoader::UploadBudget;
+
+AssetLoader::AssetLoader(Renderer* renderer, unsigned int numThreads)
+	:mRenderer(renderer)
+	, mDecoding(0)
+	, mQuit(false)
+	, mPending(0)
+{
+	// Nothing would ever be decoded without a thread
+	numThreads = numThreads > 0 ? numThreads : 1;
+	for (unsigned int i = 0; i < numThreads; i++)
+	{
+		mThreads.emplace_back(&AssetLoader::WorkerLoop, this);
+	}
+}
+
+AssetLoader::~AssetLoader()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mQuit = true;
+	}
+	mWake.notify_all();
+	for (std::thread& thread : mThreads)
+	{
+		thread.join();
+	}
+	Clear();
+}
+
+void AssetLoader::LoadTexture(Texture* texture, const std::string& fileName)
+{
+	std::unique_ptr<Request> request(new Request());
+	request->mTexture = texture;
+	request->mFileName = fileName;
+	mPending++;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mToDecode.emplace_back(std::move(request));
+	}
+	mWake.notify_one();
+}
+
+void AssetLoader::LoadMesh(Mesh* mesh, const std::string& fileName, bool fbx)
+{
+	std::unique_ptr<Request> request(new Request());
+	request->mMesh = mesh;
+	request->mFileName = fileName;
+	request->mFBX = fbx;
+	mPending++;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mToDecode.emplace_back(std::move(request));
+	}
+	mWake.notify_one();
+}
+
+void AssetLoader::WorkerLoop()
+{
+	while (true)
+	{
+		std::unique_ptr<Request> request;
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mWake.wait(lock, [this]() { return mQuit || !mToDecode.empty(); });
+			if (mQuit)
+			{
+				return;
+			}
+			request = std::move(mToDecode.front());
+			mToDecode.pop_front();
+			mDecoding++;
+		}
+
+		Decode(*request);
+
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mToUpload.emplace_back(std::move(request));
+			mDecoding--;
+		}
+		mDecoded.notify_all();
+	}
+}
+
+void AssetLoader::Decode(Request& request)
+{
+	if (request.mTexture)
+	{
+		request.mPixels = SOIL_load_image(request.mFileName.c_str(), &request.mWidth, &request.mHeight,
+			&request.mChannels, SOIL_LOAD_AUTO);
+		if (request.mPixels == nullptr)
+		{
+			SDL_Log("SOIL failed to load image %s: %s", request.mFileName.c_str(), SOIL_last_result());
+		}
+		return;
+	}
+
+	request.mMeshSource.reset(new MeshSource());
+	bool decoded = request.mFBX ? Mesh::DecodeFBX(request.mFileName, *request.mMeshSource) :
+		Mesh::Decode(request.mFileName, *request.mMeshSource);
+	if (!decoded)
+	{
+		request.mMeshSource.reset();
+	}
+}
+
+size_t AssetLoader::Finish(Request& request, std::vector<Mesh*>& outMeshes)
+{
+	size_t bytes = 0;
+	if (request.mTexture && request.mPixels)
+	{
+		request.mTexture->SetImage(request.mWidth, request.mHeight, request.mChannels, request.mPixels);
+		bytes = static_cast<size_t>(request.mWidth) * request.mHeight * request.mChannels;
+		mStats.mTextures++;
+	}
+	else if (request.mMesh && request.mMeshSource &&
+		request.mMesh->Create(*request.mMeshSource, request.mFileName, mRenderer, true))
+	{
+		bytes = request.mMeshSource->GetUploadSize();
+		outMeshes.emplace_back(request.mMesh);
+		mStats.mMeshes++;
+	}
+	else
+	{
+		// The asset keeps its placeholder
+		SDL_Log("Failed to load %s", request.mFileName.c_str());
+		mStats.mFailed++;
+	}
+	mStats.mUploadedBytes += bytes;
+	return bytes;
+}
+
+void AssetLoader::Free(Request& request)
+{
+	if (request.mPixels)
+	{
+		SOIL_free_image_data(request.mPixels);
+		request.mPixels = nullptr;
+	}
+	request.mMeshSource.reset();
+}
+
+size_t AssetLoader::Upload(size_t maxBytes, std::vector<Mesh*>& outMeshes)
+{
+	size_t bytes = 0;
+	size_t finished = 0;
+	while (bytes < maxBytes)
+	{
+		std::unique_ptr<Request> request;
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			if (mToUpload.empty())
+			{
+				break;
+			}
+			request = std::move(mToUpload.front());
+			mToUpload.pop_front();
+		}
+		bytes += Finish(*request, outMeshes);
+		Free(*request);
+		mPending--;
+		finished++;
+	}
+	return finished;
+}
+
+void AssetLoader::Flush(std::vector<Mesh*>& outMeshes)
+{
+	// Uploaded meshes may queue their textures, keep going until those are done too
+	while (mPending.load() > 0)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mDecoded.wait(lock, [this]() { return !mToUpload.empty(); });
+		}
+		Upload(UploadBudget, outMeshes);
+	}
+}
+
+void AssetLoader::Clear()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	mToDecode.clear();
+	// Loads in progress write into their own request, let them finish
+	mDecoded.wait(lock, [this]() { return mDecoding == 0; });
+	for (std::unique_ptr<Request>& request : mToUpload)
+	{
+		Free(*request);
+	}
+	mToUpload.clear();
+	mPending = 0;
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include<atomic>
+#include<condition_variable>
+#include<cstddef>
+#include<deque>
+#include<memory>
+#include<mutex>
+#include<string>
+#include<thread>
+#include<vector>
+
+// Loads textures and meshes without stalling the caller. The renderer's
+// Get*Async hand the asset out right away with placeholder contents and
+// queue it here; loader threads read and decode the files, and the render
+// thread creates the GL objects of a bounded amount of them each frame in
+// Upload. Assets are only touched on the render thread.
+//
+// Decoding doesn't go through the JobSystem: a file can take longer than
+// a frame, and its job ring and Wait expect jobs finished within one.
+class AssetLoader
+{
+public:
+	// Decoded bytes uploaded per frame (at least one asset always is)
+	static const size_t UploadBudget = 8 * 1024 * 1024;
+
+	struct Stats
+	{
+		size_t mTextures = 0;
+		size_t mMeshes = 0;
+		size_t mFailed = 0;
+		size_t mUploadedBytes = 0;
+	};
+
+	// At least one loader thread is started
+	AssetLoader(class Renderer* renderer, unsigned int numThreads);
+	~AssetLoader();
+
+	// Decode fileName into texture, which shows a placeholder until then
+	void LoadTexture(class Texture* texture, const std::string& fileName);
+	// Decode fileName into mesh (through the FBX SDK if fbx), which has no
+	// vertex arrays until then
+	void LoadMesh(class Mesh* mesh, const std::string& fileName, bool fbx);
+
+	// Render thread: create the GL objects of decoded assets until maxBytes
+	// have been uploaded. Meshes that got their vertex arrays are added to
+	// outMeshes. Returns the number of assets finished.
+	size_t Upload(size_t maxBytes, std::vector<class Mesh*>& outMeshes);
+	// Render thread: wait for and upload everything queued
+	void Flush(std::vector<class Mesh*>& outMeshes);
+	// Drop every queued load, waiting for the ones being decoded (before
+	// the assets they load into are deleted)
+	void Clear();
+
+	// Loads queued, being decoded or waiting for Upload
+	size_t GetNumPending() const { return mPending.load(); }
+	const Stats& GetStats() const { return mStats; }
+
+private:
+	struct Request
+	{
+		class Texture* mTexture = nullptr;
+		class Mesh* mMesh = nullptr;
+		std::string mFileName;
+		bool mFBX = false;
+		// Decoded data (null pixels/source if decoding failed)
+		unsigned char* mPixels = nullptr;
+		int mWidth = 0;
+		int mHeight = 0;
+		int mChannels = 0;
+		std::unique_ptr<struct MeshSource> mMeshSource;
+	};
+
+	void WorkerLoop();
+	static void Decode(Request& request);
+	// Create the GL objects, returns the bytes uploaded
+	size_t Finish(Request& request, std::vector<class Mesh*>& outMeshes);
+	static void Free(Request& request);
+
+	class Renderer* mRenderer;
+	std::vector<std::thread> mThreads;
+
+	// Guards the queues, mDecoding and mQuit
+	std::mutex mMutex;
+	std::condition_variable mWake;
+	// Signalled when a decode finishes
+	std::condition_variable mDecoded;
+	std::deque<std::unique_ptr<Request>> mToDecode;
+	std::deque<std::unique_ptr<Request>> mToUpload;
+	size_t mDecoding;
+	bool mQuit;
+
+	std::atomic<size_t> mPending;
+	Stats mStats;
+};
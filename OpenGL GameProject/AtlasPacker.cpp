@@ -0,0 +1,150 @@
+#include"AtlasPacker.h"
+#include<algorithm>
+#include<climits>
+
+namespace
+{
+	bool Contains(const AtlasRect& outer, const AtlasRect& inner)
+	{
+		return inner.mX >= outer.mX && inner.mY >= outer.mY &&
+			inner.mX + inner.mWidth <= outer.mX + outer.mWidth &&
+			inner.mY + inner.mHeight <= outer.mY + outer.mHeight;
+	}
+
+	bool Overlaps(const AtlasRect& a, const AtlasRect& b)
+	{
+		return a.mX < b.mX + b.mWidth && b.mX < a.mX + a.mWidth &&
+			a.mY < b.mY + b.mHeight && b.mY < a.mY + a.mHeight;
+	}
+}
+
+AtlasPacker::AtlasPacker(int width, int height)
+	:mWidth(width)
+	, mHeight(height)
+	, mUsedArea(0)
+{
+	Reset();
+}
+
+void AtlasPacker::Reset()
+{
+	mFreeRects.clear();
+	mFreeRects.emplace_back(AtlasRect{ 0, 0, mWidth, mHeight });
+	mUsedArea = 0;
+}
+
+float AtlasPacker::GetOccupancy() const
+{
+	return static_cast<float>(static_cast<double>(mUsedArea) / (static_cast<double>(mWidth) * mHeight));
+}
+
+bool AtlasPacker::Insert(int width, int height, AtlasRect& outRect)
+{
+	if (width <= 0 || height <= 0)
+	{
+		return false;
+	}
+	// Best short side fit, ties go to the best long side fit
+	int bestShort = INT_MAX;
+	int bestLong = INT_MAX;
+	const AtlasRect* best = nullptr;
+	for (const AtlasRect& free : mFreeRects)
+	{
+		if (free.mWidth < width || free.mHeight < height)
+		{
+			continue;
+		}
+		int leftoverX = free.mWidth - width;
+		int leftoverY = free.mHeight - height;
+		int shortSide = std::min(leftoverX, leftoverY);
+		int longSide = std::max(leftoverX, leftoverY);
+		if (shortSide < bestShort || (shortSide == bestShort && longSide < bestLong))
+		{
+			bestShort = shortSide;
+			bestLong = longSide;
+			best = &free;
+		}
+	}
+	if (!best)
+	{
+		return false;
+	}
+
+	outRect = AtlasRect{ best->mX, best->mY, width, height };
+	SplitFreeRects(outRect);
+	PruneFreeRects();
+	mUsedArea += static_cast<int64_t>(width) * height;
+	return true;
+}
+
+void AtlasPacker::SplitFreeRects(const AtlasRect& placed)
+{
+	mNewRects.clear();
+	for (size_t i = 0; i < mFreeRects.size();)
+	{
+		AtlasRect free = mFreeRects[i];
+		if (!Overlaps(free, placed))
+		{
+			i++;
+			continue;
+		}
+		// Up to four maximal pieces of free around placed
+		if (placed.mX > free.mX)
+		{
+			mNewRects.emplace_back(AtlasRect{ free.mX, free.mY, placed.mX - free.mX, free.mHeight });
+		}
+		if (placed.mX + placed.mWidth < free.mX + free.mWidth)
+		{
+			int x = placed.mX + placed.mWidth;
+			mNewRects.emplace_back(AtlasRect{ x, free.mY, free.mX + free.mWidth - x, free.mHeight });
+		}
+		if (placed.mY > free.mY)
+		{
+			mNewRects.emplace_back(AtlasRect{ free.mX, free.mY, free.mWidth, placed.mY - free.mY });
+		}
+		if (placed.mY + placed.mHeight < free.mY + free.mHeight)
+		{
+			int y = placed.mY + placed.mHeight;
+			mNewRects.emplace_back(AtlasRect{ free.mX, y, free.mWidth, free.mY + free.mHeight - y });
+		}
+		// Order doesn't matter, swap with the last
+		mFreeRects[i] = mFreeRects.back();
+		mFreeRects.pop_back();
+	}
+}
+
+void AtlasPacker::PruneFreeRects()
+{
+	// The untouched free rectangles already don't contain each other, and
+	// can't be inside a piece (it is part of a rectangle that held them),
+	// so only the pieces need checking
+	for (size_t i = 0; i < mNewRects.size();)
+	{
+		const AtlasRect& piece = mNewRects[i];
+		bool contained = false;
+		for (const AtlasRect& free : mFreeRects)
+		{
+			if (Contains(free, piece))
+			{
+				contained = true;
+				break;
+			}
+		}
+		for (size_t j = 0; j < mNewRects.size() && !contained; j++)
+		{
+			// Of two equal pieces keep the first
+			contained = j != i && Contains(mNewRects[j], piece) &&
+				(j < i || !Contains(piece, mNewRects[j]));
+		}
+		if (contained)
+		{
+			mNewRects[i] = mNewRects.back();
+			mNewRects.pop_back();
+		}
+		else
+		{
+			i++;
+		}
+	}
+	mFreeRects.insert(mFreeRects.end(), mNewRects.begin(), mNewRects.end());
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include<cstddef>
+#include<cstdint>
+#include<vector>
+
+struct AtlasRect
+{
+	int mX;
+	int mY;
+	int mWidth;
+	int mHeight;
+};
+
+// Places rectangles in a fixed size page with MaxRects: the free space is
+// kept as the list of maximal free rectangles (they overlap), and each
+// rectangle goes where it leaves the shortest leftover side. Unlike rows
+// of shelves, small images fill the gaps next to big ones.
+// Works on rectangles only, the atlas copies the pixels.
+class AtlasPacker
+{
+public:
+	AtlasPacker(int width, int height);
+
+	// Find room for width x height, false if the page has none
+	bool Insert(int width, int height, AtlasRect& outRect);
+	// Make the whole page free again
+	void Reset();
+
+	int GetWidth() const { return mWidth; }
+	int GetHeight() const { return mHeight; }
+	// Pixels covered by inserted rectangles
+	int64_t GetUsedArea() const { return mUsedArea; }
+	// Fraction of the page covered, 0 to 1
+	float GetOccupancy() const;
+	size_t GetNumFreeRects() const { return mFreeRects.size(); }
+	// Maximal free rectangles, none inside another
+	const std::vector<AtlasRect>& GetFreeRects() const { return mFreeRects; }
+
+private:
+	// Cut placed out of every free rectangle it overlaps
+	void SplitFreeRects(const AtlasRect& placed);
+	// Drop free rectangles inside another one
+	void PruneFreeRects();
+
+	int mWidth;
+	int mHeight;
+	int64_t mUsedArea;
+	std::vector<AtlasRect> mFreeRects;
+	// Pieces cut by the last insert
+	std::vector<AtlasRect> mNewRects;
+};
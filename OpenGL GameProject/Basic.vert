@@ -1,8 +1,35 @@
 #version 330
 
+// Per frame camera/lighting data (Renderer::UploadFrameData)
+struct DirectionalLight
+{
+	// Direction of light
+	vec3 mDirection;
+	// Diffuse color
+	vec3 mDiffuseColor;
+	// Specular color
+	vec3 mSpecColor;
+};
+
+layout(std140, row_major) uniform FrameData
+{
+	mat4 uView;
+	mat4 uProjection;
+	mat4 uViewProjection;
+	// Screen space view-projection for sprites
+	mat4 uSpriteViewProj;
+	// Camera position (in world space)
+	vec3 uCameraPosition;
+	// Ambient light level
+	vec3 uAmbientLight;
+	// Directional Light
+	DirectionalLight uDirLight;
+};
+
+// World space position
 in vec3 inPosition;
 
 void main()
 {
-    gl_Position = vec4(inPosition, 1.0);
+    gl_Position = vec4(inPosition, 1.0) * uViewProjection;
 }
\ No newline at end of file
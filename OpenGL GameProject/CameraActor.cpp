@@ -10,13 +10,12 @@ CameraActor::CameraActor(Game* game)
 	mMoveComp = new MoveComponent(this);
 }
 
-void CameraActor::UpdateActor(float deltaTime)
+void CameraActor::UpdateView()
 {
-	Actor::UpdateActor(deltaTime);
-
-	// Compute new camera from this actor
-	Vector3 cameraPos = GetVec3Position();
-	Vector3 target = GetVec3Position() + GetForward() * 100.0f;
+	// Compute new camera from this actor, forward is the world x axis
+	const Matrix4& transform = GetRenderTransform();
+	Vector3 cameraPos = transform.GetTranslation();
+	Vector3 target = cameraPos + transform.GetXAxis() * 100.0f;
 	Vector3 up = Vector3::UnitZ;
 
 	Matrix4 view = Matrix4::CreateLookAt(cameraPos, target, up);
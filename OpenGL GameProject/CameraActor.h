@@ -6,8 +6,9 @@ class CameraActor : public Actor
 public:
 	CameraActor(class Game* game);
 
-	void UpdateActor(float deltaTime) override;
 	void ActorInput(const uint8_t* keys) override;
+	// Set the renderer's view from the interpolated transform, once per frame
+	void UpdateView();
 private:
 	class MoveComponent* mMoveComp;
 };
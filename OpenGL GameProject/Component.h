@@ -1,18 +1,59 @@
 #pragma once
 #include"Actor.h"
+#include"ObjectPool.h"
 #include<cstdint>
 
+// Kinds of actor data a component's Update can touch
+namespace ComponentData
+{
+	enum : uint32_t
+	{
+		// Position, rotation, scale and parent
+		ETransform = 1 << 0,
+		// Speeds driving MoveComponent
+		EMovement = 1 << 1,
+		// Sprite texture, animation frame and scrolling
+		ESprite = 1 << 2
+	};
+}
+
+// What Update reads and writes, so the ComponentScheduler knows which
+// components can run side by side on different actors
+struct ComponentAccess
+{
+	// ComponentData bits of the owning actor
+	uint32_t mReads;
+	uint32_t mWrites;
+	// ComponentData bits read from other actors
+	uint32_t mOtherReads;
+	// Touches anything not listed (the game, renderer, other actors' data,
+	// spawning actors), runs alone on the main thread
+	bool mExclusive;
+
+	static ComponentAccess Exclusive() { return ComponentAccess{ 0, 0, 0, true }; }
+	static ComponentAccess Owner(uint32_t reads, uint32_t writes) { return ComponentAccess{ reads, writes, 0, false }; }
+	// Update does nothing, the scheduler skips the component
+	static ComponentAccess None() { return ComponentAccess{ 0, 0, 0, false }; }
+
+	bool IsNone() const { return !mExclusive && (mReads | mWrites | mOtherReads) == 0; }
+};
+
 class Component
 {
 public:
 	Component(class Actor* owner, int updateOrder = 100);
 	virtual ~Component();
+	// Components of every type come from the ObjectPool
+	OBJECT_POOL_OPERATORS
 	virtual void Update(float deltaTime);
+	// Data touched by Update. Exclusive unless a component says otherwise.
+	virtual ComponentAccess GetAccess() const { return ComponentAccess::Exclusive(); }
 	virtual void ProcessInput(const uint8_t* keyState) {}
 	// Called when world transform changes
 	virtual void OnUpdateWorldTransform(){ }
 
 	int GetUpdateOrder()const { return mUpdateOrder; }
+	class Actor* GetOwner() const { return mOwner; }
 
 protected:
 	class Actor* mOwner;
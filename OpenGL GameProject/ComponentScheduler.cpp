@@ -0,0 +1,250 @@
+#include"ComponentScheduler.h"
+#include"Actor.h"
+#include"JobSystem.h"
+#include<algorithm>
+
+namespace
+{
+	// Actors per job in a parallel step
+	const size_t ActorGrain = 64;
+}
+
+ComponentScheduler::ComponentScheduler(JobSystem* jobs)
+	:mJobs(jobs)
+	, mNumParallelSteps(0)
+{
+}
+
+ComponentScheduler::GroupKind ComponentScheduler::GetKind(const ComponentAccess& access)
+{
+	if (access.mExclusive)
+	{
+		return GroupKind::EExclusive;
+	}
+	return access.mOtherReads ? GroupKind::EReadsOthers : GroupKind::EOwner;
+}
+
+size_t ComponentScheduler::FindGroup(int order, GroupKind kind) const
+{
+	auto iter = std::lower_bound(mGroups.begin(), mGroups.end(), std::make_pair(order, kind),
+		[](const Group& group, const std::pair<int, GroupKind>& key)
+	{
+		return group.mOrder != key.first ? group.mOrder < key.first : group.mKind < key.second;
+	});
+	return static_cast<size_t>(iter - mGroups.begin());
+}
+
+void ComponentScheduler::BuildGroups(const std::vector<Actor*>& actors)
+{
+	mGroups.clear();
+	for (Actor* actor : actors)
+	{
+		if (actor->GetState() != Actor::State::EActive)
+		{
+			continue;
+		}
+		for (Component* comp : actor->GetComponents())
+		{
+			ComponentAccess access = comp->GetAccess();
+			if (access.IsNone())
+			{
+				continue;
+			}
+			GroupKind kind = GetKind(access);
+			size_t index = FindGroup(comp->GetUpdateOrder(), kind);
+			if (index == mGroups.size() || mGroups[index].mOrder != comp->GetUpdateOrder() ||
+				mGroups[index].mKind != kind)
+			{
+				Group group{ comp->GetUpdateOrder(), kind, 0, 0 };
+				mGroups.insert(mGroups.begin() + index, group);
+			}
+			mGroups[index].mWrites |= access.mWrites;
+			mGroups[index].mOtherReads |= access.mOtherReads;
+		}
+	}
+}
+
+void ComponentScheduler::BuildSteps()
+{
+	mSteps.clear();
+	mNumParallelSteps = 0;
+	// Open parallel step and what it touches
+	bool open = false;
+	Step step{ 0, 0, true };
+	uint32_t writes = 0;
+	uint32_t otherReads = 0;
+	auto close = [&]()
+	{
+		if (open)
+		{
+			mSteps.emplace_back(step);
+			mNumParallelSteps++;
+			open = false;
+		}
+	};
+
+	for (size_t i = 0; i < mGroups.size(); i++)
+	{
+		const Group& group = mGroups[i];
+		if (!group.IsParallel())
+		{
+			close();
+			mSteps.emplace_back(Step{ i, i, false });
+			continue;
+		}
+		// Another actor may not be halfway through writing what we read
+		if ((group.mOtherReads & writes) || (group.mWrites & otherReads))
+		{
+			close();
+		}
+		if (!open)
+		{
+			step = Step{ i, i, true };
+			writes = 0;
+			otherReads = 0;
+			open = true;
+		}
+		step.mLast = i;
+		writes |= group.mWrites;
+		otherReads |= group.mOtherReads;
+	}
+	close();
+}
+
+void ComponentScheduler::FindLastSteps(const std::vector<Actor*>& actors)
+{
+	mGroupSteps.resize(mGroups.size());
+	for (size_t s = 0; s < mSteps.size(); s++)
+	{
+		for (size_t i = mSteps[s].mFirst; i <= mSteps[s].mLast; i++)
+		{
+			mGroupSteps[i] = s;
+		}
+	}
+	mLastSteps.assign(actors.size(), mSteps.size());
+	for (size_t i = 0; i < actors.size(); i++)
+	{
+		if (actors[i]->GetState() != Actor::State::EActive)
+		{
+			continue;
+		}
+		// Components are sorted by update order, so the last step is one
+		// of those updating the highest order
+		const std::vector<Component*>& comps = actors[i]->GetComponents();
+		int highestOrder = 0;
+		for (auto iter = comps.rbegin(); iter != comps.rend(); ++iter)
+		{
+			ComponentAccess access = (*iter)->GetAccess();
+			if (access.IsNone())
+			{
+				continue;
+			}
+			int order = (*iter)->GetUpdateOrder();
+			bool found = mLastSteps[i] != mSteps.size();
+			if (found && order < highestOrder)
+			{
+				break;
+			}
+			size_t step = mGroupSteps[FindGroup(order, GetKind(access))];
+			mLastSteps[i] = found ? std::max(mLastSteps[i], step) : step;
+			highestOrder = order;
+		}
+	}
+}
+
+void ComponentScheduler::RunStep(Actor* actor, const Step& step, float deltaTime) const
+{
+	if (actor->GetState() != Actor::State::EActive)
+	{
+		return;
+	}
+	int firstOrder = mGroups[step.mFirst].mOrder;
+	int lastOrder = mGroups[step.mLast].mOrder;
+	// Components are sorted by update order
+	for (Component* comp : actor->GetComponents())
+	{
+		int order = comp->GetUpdateOrder();
+		if (order < firstOrder)
+		{
+			continue;
+		}
+		if (order > lastOrder)
+		{
+			break;
+		}
+		ComponentAccess access = comp->GetAccess();
+		if (access.IsNone())
+		{
+			continue;
+		}
+		// A component added during this update may have no group yet
+		GroupKind kind = GetKind(access);
+		size_t group = FindGroup(order, kind);
+		if (group >= step.mFirst && group <= step.mLast &&
+			mGroups[group].mOrder == order && mGroups[group].mKind == kind)
+		{
+			comp->Update(deltaTime);
+		}
+	}
+}
+
+void ComponentScheduler::RunActors(const std::vector<Actor*>& actors, size_t count, size_t step, float deltaTime) const
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		if (mLastSteps[i] == step && actors[i]->GetState() == Actor::State::EActive)
+		{
+			actors[i]->UpdateActor(deltaTime);
+		}
+	}
+}
+
+void ComponentScheduler::Update(const std::vector<Actor*>& actors, float deltaTime)
+{
+	// Components come and go, so groups are found again every update
+	BuildGroups(actors);
+	BuildSteps();
+	FindLastSteps(actors);
+
+	// Actors spawned meanwhile are added at the end, leave them for the
+	// next update (spawning is exclusive, so never during a parallel step)
+	size_t count = actors.size();
+	for (size_t s = 0; s < mSteps.size(); s++)
+	{
+		const Step& step = mSteps[s];
+		if (step.mParallel)
+		{
+			if (mJobs)
+			{
+				mJobs->ParallelFor(0, count, ActorGrain, [&](size_t first, size_t last)
+				{
+					for (size_t i = first; i < last; i++)
+					{
+						RunStep(actors[i], step, deltaTime);
+					}
+				});
+			}
+			else
+			{
+				for (size_t i = 0; i < count; i++)
+				{
+					RunStep(actors[i], step, deltaTime);
+				}
+			}
+			RunActors(actors, count, s, deltaTime);
+		}
+		else
+		{
+			// Each actor right after its own components, as Actor::Update
+			for (size_t i = 0; i < count; i++)
+			{
+				RunStep(actors[i], step, deltaTime);
+				if (mLastSteps[i] == s && actors[i]->GetState() == Actor::State::EActive)
+				{
+					actors[i]->UpdateActor(deltaTime);
+				}
+			}
+		}
+	}
+	RunActors(actors, count, mSteps.size(), deltaTime);
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include<cstddef>
+#include<cstdint>
+#include<vector>
+#include"Component.h"
+
+// Runs the component updates of every actor in steps, using what each
+// component declares in GetAccess.
+//
+// Components are grouped by update order, and within one order into
+// those touching only their owner, those also reading other actors and
+// exclusive ones (in that order). Consecutive groups share a parallel
+// step, which splits the actors across jobs and runs each actor's
+// components in update order, until a group reads other actors' data
+// that the step writes (or the other way round). Exclusive groups and
+// groups reading what they write on other actors run alone on the
+// calling thread. Steps run one after the other, so update order holds
+// between every group. Components whose access is None are skipped.
+//
+// Each actor's UpdateActor runs on the calling thread at the end of the
+// last step updating one of its components: right after them in a serial
+// step, once the jobs are done in a parallel one. Actors with no
+// component to update run theirs after every step.
+class ComponentScheduler
+{
+public:
+	// jobs may be null to run everything on the calling thread
+	ComponentScheduler(class JobSystem* jobs);
+
+	// Update the components of every active actor and call UpdateActor
+	// on each (actor code can touch anything, so that is serial)
+	void Update(const std::vector<class Actor*>& actors, float deltaTime);
+
+	// Steps run by the last Update
+	size_t GetNumParallelSteps() const { return mNumParallelSteps; }
+	size_t GetNumSerialSteps() const { return mSteps.size() - mNumParallelSteps; }
+
+private:
+	enum class GroupKind
+	{
+		EOwner,
+		EReadsOthers,
+		EExclusive
+	};
+
+	struct Group
+	{
+		int mOrder;
+		GroupKind mKind;
+		// Union of the access of the group's components
+		uint32_t mWrites;
+		uint32_t mOtherReads;
+
+		bool IsParallel() const
+		{
+			return mKind != GroupKind::EExclusive && (mOtherReads & mWrites) == 0;
+		}
+	};
+
+	// Groups [mFirst, mLast]
+	struct Step
+	{
+		size_t mFirst;
+		size_t mLast;
+		bool mParallel;
+	};
+
+	static GroupKind GetKind(const ComponentAccess& access);
+	// Index in mGroups of component's group
+	size_t FindGroup(int order, GroupKind kind) const;
+	void BuildGroups(const std::vector<class Actor*>& actors);
+	void BuildSteps();
+	// Step after which each actor's UpdateActor runs
+	void FindLastSteps(const std::vector<class Actor*>& actors);
+	// Run the components of actor in the groups of step
+	void RunStep(class Actor* actor, const Step& step, float deltaTime) const;
+	// UpdateActor for the actors whose last step is step
+	void RunActors(const std::vector<class Actor*>& actors, size_t count, size_t step, float deltaTime) const;
+
+	class JobSystem* mJobs;
+	// Sorted by order then kind
+	std::vector<Group> mGroups;
+	std::vector<Step> mSteps;
+	// Step of each group
+	std::vector<size_t> mGroupSteps;
+	// Per actor, mSteps.size() for actors with nothing to update
+	std::vector<size_t> mLastSteps;
+	size_t mNumParallelSteps;
+};
@@ -0,0 +1,102 @@
+#include"Frustum.h"
+
+void SphereBatch::Clear()
+{
+	mX.clear();
+	mY.clear();
+	mZ.clear();
+	mRadius.clear();
+}
+
+void SphereBatch::Add(const Vector3& center, float radius)
+{
+	mX.emplace_back(center.x);
+	mY.emplace_back(center.y);
+	mZ.emplace_back(center.z);
+	mRadius.emplace_back(radius);
+}
+
+Frustum::Frustum()
+{
+	// No planes culling anything until SetFromViewProj
+	for (unsigned int p = 0; p < NumPlanes; p++)
+	{
+		mPlanes[p][0] = 0.0f;
+		mPlanes[p][1] = 0.0f;
+		mPlanes[p][2] = 0.0f;
+		mPlanes[p][3] = 1.0f;
+	}
+}
+
+void Frustum::SetFromViewProj(const Matrix4& viewProj)
+{
+	// With row vectors clip = v * M, so column i of M gives clip component i.
+	// Inside is -w <= x, y, z <= w: each plane is column 3 +/- column 0, 1, 2.
+	const float(*m)[4] = viewProj.matrix;
+	for (unsigned int p = 0; p < NumPlanes; p++)
+	{
+		unsigned int axis = p / 2;
+		float sign = (p % 2 == 0) ? 1.0f : -1.0f;
+		for (unsigned int c = 0; c < 4; c++)
+		{
+			mPlanes[p][c] = m[c][3] + sign * m[c][axis];
+		}
+
+		// Normalize so the plane distance compares against the radius
+		float length = Math::Sqrt(mPlanes[p][0] * mPlanes[p][0] +
+			mPlanes[p][1] * mPlanes[p][1] + mPlanes[p][2] * mPlanes[p][2]);
+		if (length > 0.0f)
+		{
+			for (unsigned int c = 0; c < 4; c++)
+			{
+				mPlanes[p][c] /= length;
+			}
+		}
+	}
+}
+
+bool Frustum::TestSphere(const Vector3& center, float radius) const
+{
+	for (unsigned int p = 0; p < NumPlanes; p++)
+	{
+		float dist = mPlanes[p][0] * center.x + mPlanes[p][1] * center.y +
+			mPlanes[p][2] * center.z + mPlanes[p][3];
+		if (dist < -radius)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+Frustum::Containment Frustum::ClassifyAABB(const AABB& box) const
+{
+	Containment result = Containment::EInside;
+	for (unsigned int p = 0; p < NumPlanes; p++)
+	{
+		// Corner furthest along the plane normal, and the one opposite it
+		const float* plane = mPlanes[p];
+		Vector3 positive(plane[0] >= 0.0f ? box.mMax.x : box.mMin.x,
+			plane[1] >= 0.0f ? box.mMax.y : box.mMin.y,
+			plane[2] >= 0.0f ? box.mMax.z : box.mMin.z);
+		Vector3 negative(plane[0] >= 0.0f ? box.mMin.x : box.mMax.x,
+			plane[1] >= 0.0f ? box.mMin.y : box.mMax.y,
+			plane[2] >= 0.0f ? box.mMin.z : box.mMax.z);
+		if (plane[0] * positive.x + plane[1] * positive.y + plane[2] * positive.z + plane[3] < 0.0f)
+		{
+			return Containment::EOutside;
+		}
+		if (plane[0] * negative.x + plane[1] * negative.y + plane[2] * negative.z + plane[3] < 0.0f)
+		{
+			result = Containment::EIntersect;
+		}
+	}
+	return result;
+}
+
+size_t Frustum::CullSpheres(const SphereBatch& spheres, std::vector<uint8_t>& outVisible) const
+{
+	outVisible.resize(spheres.Size());
+	return MathBatch::SpheresInsidePlanes(spheres.mX.data(), spheres.mY.data(), spheres.mZ.data(),
+		spheres.mRadius.data(), spheres.Size(), mPlanes, NumPlanes, outVisible.data());
+}
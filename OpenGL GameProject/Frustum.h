@@ -0,0 +1,51 @@
+#pragma once
+#include<cstddef>
+#include<cstdint>
+#include<vector>
+#include"Math.h"
+#include"AABB.h"
+#include"MathBatch.h"
+
+// World space bounding spheres packed one array per component, so
+// the frustum test can load several spheres per instruction
+struct SphereBatch
+{
+	MathBatch::FloatArray mX;
+	MathBatch::FloatArray mY;
+	MathBatch::FloatArray mZ;
+	MathBatch::FloatArray mRadius;
+
+	void Clear();
+	void Add(const Vector3& center, float radius);
+	size_t Size() const { return mX.size(); }
+};
+
+// The six planes of a view-projection, normals pointing inward
+class Frustum
+{
+public:
+	enum class Containment
+	{
+		EOutside,
+		EIntersect,
+		EInside
+	};
+
+	Frustum();
+
+	// Extract the planes of viewProj (row vectors, GL clip space)
+	void SetFromViewProj(const Matrix4& viewProj);
+
+	bool TestSphere(const Vector3& center, float radius) const;
+	// Whether box is outside, partly inside or fully inside the frustum
+	Containment ClassifyAABB(const AABB& box) const;
+	// Write 1 for each sphere touching the frustum and 0 for each outside it,
+	// returns the number of visible spheres
+	size_t CullSpheres(const SphereBatch& spheres, std::vector<uint8_t>& outVisible) const;
+
+	static const unsigned int NumPlanes = 6;
+
+private:
+	// a, b, c, d of each plane: a*x + b*y + c*z + d >= 0 is inside
+	float mPlanes[NumPlanes][4];
+};
@@ -7,17 +7,42 @@
 #include"SpriteComponent.h"
 #include"MeshComponent.h"
 #include"CameraActor.h"
-
+#include"AABBTree.h"
+#include"TransformStore.h"
+#include"JobSystem.h"
+#include"ComponentScheduler.h"
+#include"MovementSystem.h"
+#include"ObjectPool.h"
+
+namespace
+{
+	// Frames longer than this (loading, debugger) aren't caught up on
+	const double MaxFrameTime = 0.25;
+	// Longest single step in variable step mode
+	const float MaxVariableStep = 0.05f;
+}
 
 Game::Game()
 	:mSDLRenderer(nullptr),
-	mIsRunning(true),
-	mTicksCount(0),
-	mUpdatingActors(false),
 	mContent(nullptr),
-	mSpriteShader(nullptr),
+	mIsRunning(true),
+	mHeadless(false),
+	mFixedStep(1.0f / 60.0f),
+	mAccumulator(0.0),
+	mPooledComponents(true),
+	mStressActors(0),
+	mStatsFrames(0),
+	mStatsFrameTicks(0),
+	mStatsDrawTicks(0),
+	mStatsStart(0),
 	mSpriteVerts(nullptr),
+	mSpriteShader(nullptr),
 	mRenderer(nullptr),
+	mSpatialTree(nullptr),
+	mTransformStore(nullptr),
+	mJobSystem(nullptr),
+	mScheduler(nullptr),
+	mMovementSystem(nullptr),
 	mCameraActor(nullptr)
 {
 
@@ -94,19 +119,131 @@ bool Game::Initialize() {
 		return false;
 	}
 
-	mTicksCount = SDL_GetTicks();
-
+	CreateSystems();
 	LoadData();
 
 	return true;
 }
 
+void Game::InitializeHeadless()
+{
+	// The renderer is never initialized, it only keeps the lists of mesh
+	// and sprite components
+	mHeadless = true;
+	mRenderer = new Renderer(this);
+	CreateSystems();
+}
+
+void Game::CreateSystems()
+{
+	mJobSystem = new JobSystem(JobSystem::GetDefaultWorkers());
+	SDL_Log("Job system: %u worker threads", mJobSystem->GetNumWorkers());
+	mSpatialTree = new AABBTree();
+	mTransformStore = new TransformStore(mJobSystem);
+	mScheduler = new ComponentScheduler(mJobSystem);
+	if (mPooledComponents)
+	{
+		mMovementSystem = new MovementSystem(mTransformStore, mJobSystem);
+	}
+}
+
 void Game::RunLoop() {
+	const double frequency = static_cast<double>(SDL_GetPerformanceFrequency());
+	Uint64 frameStart = SDL_GetPerformanceCounter();
+	Uint64 lastTime = frameStart;
 	while (mIsRunning)
 	{
 		ProcessInput();
-		UpdateGame();
+
+		Uint64 now = SDL_GetPerformanceCounter();
+		double frameTime = Math::Min((now - lastTime) / frequency, MaxFrameTime);
+		lastTime = now;
+		if (mFixedStep > 0.0f)
+		{
+			// Run as many whole steps as the elapsed time covers, the rest
+			// carries over and says how far towards the next step to draw
+			mAccumulator += frameTime;
+			while (mAccumulator >= mFixedStep)
+			{
+				UpdateGame(mFixedStep);
+				mAccumulator -= mFixedStep;
+			}
+			mTransformStore->Interpolate(static_cast<float>(mAccumulator / mFixedStep));
+		}
+		else
+		{
+			UpdateGame(Math::Min(static_cast<float>(frameTime), MaxVariableStep));
+			mTransformStore->Interpolate(1.0f);
+		}
+
+		Uint64 drawStart = SDL_GetPerformanceCounter();
 		GenerateOutput();
+		Uint64 drawEnd = SDL_GetPerformanceCounter();
+		WaitForNextFrame(frameStart);
+		Uint64 frameEnd = SDL_GetPerformanceCounter();
+		if (mStressActors > 0)
+		{
+			ReportFrameStats(frameEnd - frameStart, drawEnd - drawStart);
+		}
+		frameStart = frameEnd;
+	}
+}
+
+void Game::WaitForNextFrame(Uint64 frameStart)
+{
+	// With vsync the swap already blocked until the display was ready
+	if (mRenderer->IsVSync())
+	{
+		return;
+	}
+	// Otherwise sleep off the rest of a display refresh
+	Uint64 frequency = SDL_GetPerformanceFrequency();
+	Uint64 frameTicks = frequency / mRenderer->GetRefreshRate();
+	Uint64 elapsed = SDL_GetPerformanceCounter() - frameStart;
+	if (elapsed < frameTicks)
+	{
+		Uint32 ms = static_cast<Uint32>((frameTicks - elapsed) * 1000 / frequency);
+		if (ms > 0)
+		{
+			SDL_Delay(ms);
+		}
+	}
+}
+
+void Game::ReportFrameStats(Uint64 frameTicks, Uint64 drawTicks)
+{
+	mStatsFrames++;
+	mStatsFrameTicks += frameTicks;
+	mStatsDrawTicks += drawTicks;
+
+	Uint64 now = SDL_GetPerformanceCounter();
+	Uint64 frequency = SDL_GetPerformanceFrequency();
+	if (mStatsStart == 0)
+	{
+		mStatsStart = now;
+	}
+	else if (now - mStatsStart >= frequency)
+	{
+		double msPerTick = 1000.0 / frequency;
+		const RenderQueue::Stats& stats = mRenderer->GetRenderStats();
+		SDL_Log("Stress %d actors: frame %.2f ms, draw CPU %.2f ms, %u visible %u culled, %u draw calls, "
+			"binds %u shader %u texture %u vao, %u skipped (instancing %s)",
+			mStressActors, mStatsFrameTicks * msPerTick / mStatsFrames,
+			mStatsDrawTicks * msPerTick / mStatsFrames,
+			mRenderer->GetVisibleMeshes(), mRenderer->GetCulledMeshes(), stats.mDrawCalls,
+			stats.mShaderBinds, stats.mTextureBinds, stats.mVertexArrayBinds, stats.mSkippedBinds,
+			mRenderer->IsInstancing() ? "on" : "off");
+		TextureAtlas::Stats atlas = mRenderer->GetSpriteAtlas().GetStats();
+		SDL_Log("Sprites: %zu in %zu draws, atlas %zu images on %zu pages (%.1f%% used)",
+			mRenderer->GetSprites().GetCount(), mRenderer->GetSpriteBatches(),
+			atlas.mImages, atlas.mPages, atlas.mEfficiency * 100.0f);
+		ObjectPool::Stats pool = ObjectPool::GetStats();
+		SDL_Log("Object pool: %zu live, %zu allocations %zu frees, %zu slabs, %zu on the heap",
+			pool.mLive, pool.mAllocations, pool.mFrees, pool.mSlabs, pool.mHeapAllocations);
+		mStatsFrames = 0;
+		mStatsFrameTicks = 0;
+		mStatsDrawTicks = 0;
+		mStatsStart = now;
 	}
 }
 
@@ -121,6 +258,13 @@ void Game::ProcessInput() {
 		    case SDL_QUIT:
 			   mIsRunning = false;
 			   break;
+			case SDL_KEYDOWN:
+				// I toggles instanced mesh drawing
+				if (event.key.keysym.sym == SDLK_i && !event.key.repeat)
+				{
+					mRenderer->SetInstancing(!mRenderer->IsInstancing());
+				}
+				break;
 		}
 	}
 	const Uint8* state = SDL_GetKeyboardState(NULL);
@@ -129,9 +273,11 @@ void Game::ProcessInput() {
 		mIsRunning = false;
 	}
 
-	for (auto actor : mActors)
+	// Index loop, input may spawn actors
+	size_t count = mActors.GetCount();
+	for (size_t i = 0; i < count; i++)
 	{
-		actor->ProcessInput(state);
+		mActors.GetValues()[i]->ProcessInput(state);
 	}
 
 }
@@ -149,13 +295,13 @@ void Game::LoadData()
 	q = Quaternion::Concatenate(q, Quaternion(Vector3::UnitZ, Math::Pi + Math::Pi / 4.0f));
 	actor->SetQRotation(q);
 	MeshComponent* mc = new MeshComponent(actor);
-	mc->SetMesh(mRenderer->GetMesh("Assets/Cube.gpmesh"));
+	mc->SetMesh(mRenderer->GetMeshAsync("Assets/Cube.gpmesh"));
 
 	actor = new Actor(this);
 	actor->SetVec3Position(Vector3(200.0f, -75.0f, 0.0f));
 	actor->SetScale(3.0f);
 	mc = new MeshComponent(actor);
-	mc->SetMesh(mRenderer->GetMesh("Assets/Sphere.gpmesh"));
+	mc->SetMesh(mRenderer->GetMeshAsync("Assets/Sphere.gpmesh"));
 
 	actor = new Actor(this);
 	actor->SetVec3Position(Vector3(500.0f, 75.0f, -80.0f));
@@ -164,7 +310,25 @@ void Game::LoadData()
 	qua = Quaternion::Concatenate(qua, Quaternion(Vector3::UnitZ, Math::Pi + Math::Pi / 4.0f));
 	actor->SetQRotation(qua);
 	mc = new MeshComponent(actor);
-	mc->SetMesh(mRenderer->GetFBXMesh("Assets/chara02.fbx"));
+	mc->SetMesh(mRenderer->GetFBXMeshAsync("Assets/chara02.fbx"));
+
+	// Stress test: a block of cubes in front of the camera
+	if (mStressActors > 0)
+	{
+		Mesh* cube = mRenderer->GetMeshAsync("Assets/Cube.gpmesh");
+		int side = static_cast<int>(ceilf(cbrtf(static_cast<float>(mStressActors))));
+		for (int i = 0; i < mStressActors; i++)
+		{
+			int x = i % side;
+			int y = (i / side) % side;
+			int z = i / (side * side);
+			actor = new Actor(this);
+			actor->SetVec3Position(Vector3(400.0f + x * 40.0f, (y - side / 2) * 40.0f, (z - side / 2) * 40.0f));
+			actor->SetScale(15.0f);
+			mc = new MeshComponent(actor);
+			mc->SetMesh(cube);
+		}
+	}
 
 	// Setup lights
 	mRenderer->SetAmbientLight(Vector3(0.2f, 0.2f, 0.2f));
@@ -180,9 +344,9 @@ void Game::LoadData()
 void Game::UnloadData()
 {
 	//Delete actors
-	while (!mActors.empty())
+	while (!mActors.IsEmpty())
 	{
-		delete mActors.back();
+		delete mActors.GetValues().back();
 	}
 
 	//Destroy textures
@@ -199,77 +363,64 @@ void Game::UnloadData()
 	}
 } 
 
-void Game::AddActor(Actor* actor)
+SlotHandle Game::AddActor(Actor* actor)
 {
-	if (mUpdatingActors) {
-		mPendingActors.emplace_back(actor);
-	}
-	else
-	{
-		mActors.emplace_back(actor);
-	}
+	// Update loops only go up to the count they started with, so actors
+	// added meanwhile wait for the next step
+	return mActors.Insert(actor);
 }
 
 void Game::RemoveActor(Actor* actor)
 {
-	auto iter = std::find(mPendingActors.begin(), mPendingActors.end(), actor);
-	if (iter != mPendingActors.end())
-	{
-		//Swap to end of vector and pop off (avoid erase copies)
-		std::iter_swap(iter, mPendingActors.end() - 1);
-		mPendingActors.pop_back();
-	}
-
-	iter = std::find(mActors.begin(), mActors.end(), actor);
-	if (iter != mActors.end())
-	{
-		//Swap to end of vector and pop off (avoid erase copies)
-		std::iter_swap(iter, mActors.end() - 1);
-		mActors.pop_back();
-	}
+	mActors.Remove(actor->GetHandle());
 }
 
-void Game::UpdateGame() {
-
-	while (!SDL_TICKS_PASSED(SDL_GetTicks(), mTicksCount + 16));
-
-	float deltatime = (SDL_GetTicks() - mTicksCount) / 1000.0f;
-
-	mTicksCount = SDL_GetTicks();
+Actor* Game::GetActor(SlotHandle handle) const
+{
+	Actor* const* actor = mActors.Get(handle);
+	return actor ? *actor : nullptr;
+}
 
-	if (deltatime > 0.05f) {
-		deltatime = 0.05f;
+void Game::UpdateTransforms()
+{
+	for (auto actor : mTransformStore->ComposeDirty())
+	{
+		actor->OnWorldTransformUpdated();
 	}
+}
 
-	mUpdatingActors = true; //Update all actors
+void Game::UpdateGame(float deltatime) {
 
-	for (auto actor : mActors)
-	{
-		actor->Update(deltatime);
-	}
-	mUpdatingActors = false;
+	// Transforms moved from here on are blended from where they are now
+	mTransformStore->BeginStep();
 
-	for (auto pending : mPendingActors)
+	// Components see current world transforms, then pick up this frame's moves
+	// Pooled components update first, then the rest in steps spread over
+	// the job system, each actor right after the last step updating it
+	UpdateTransforms();
+	if (mMovementSystem)
 	{
-		pending->ComputeWorldTransform();
-		mActors.emplace_back(pending);
+		mMovementSystem->Update(deltatime);
 	}
-	mPendingActors.clear();
-
-	std::vector<Actor*> deadActors;
+	mScheduler->Update(mActors.GetValues(), deltatime);
+	// Also composes actors spawned during the update
+	UpdateTransforms();
 
+	// Reused every step, so despawning doesn't allocate
+	mDeadActors.clear();
 	for (auto actor : mActors)
 	{
 		if (actor->GetState() == Actor::State::EDead)
 		{
-			deadActors.emplace_back(actor);
+			mDeadActors.emplace_back(actor);
 		}
 	}
 
-	for (auto actor : deadActors)
+	for (auto actor : mDeadActors)
 	{
 		delete actor;
 	}
+	mDeadActors.clear();
 }
 
 SDL_Texture* Game::LoadTexture(const char* fileName)
@@ -291,26 +442,6 @@ SDL_Texture* Game::LoadTexture(const char* fileName)
 	return text;
 }
 
-void Game::AddSprite(SpriteComponent* sprite)
-{
-	int myDrawOrder = sprite->GetDrawOrder();
-	auto iter = mSprites.begin();
-	for (; iter != mSprites.end(); iter++)
-	{
-		if (myDrawOrder < (*iter)->GetDrawOrder())
-		{
-			break;
-		}
-	}
-	mSprites.insert(iter, sprite);
-}
-
-void Game::RemoveSprite(SpriteComponent* sprite)
-{
-	auto iter = std::find(mSprites.begin(), mSprites.end(), sprite);
-	mSprites.erase(iter);
-}
-
 //Draw
 void Game::GenerateOutput() {
 
@@ -335,6 +466,7 @@ void Game::GenerateOutput() {
 	//// Swap front buffer and back buffer
 	//SDL_RenderPresent(mSDLRenderer);
 
+	mCameraActor->UpdateView();
 	mRenderer->Draw();
 }
 
@@ -343,10 +475,22 @@ void Game::ShutDown() {
 	IMG_Quit();
 	SDL_DestroyRenderer(mSDLRenderer);
 	UnloadData();
-	if (mRenderer)
+	if (mRenderer && !mHeadless)
 	{
 		mRenderer->Shutdown();
 	}
+	delete mRenderer;
+	mRenderer = nullptr;
+	delete mSpatialTree;
+	mSpatialTree = nullptr;
+	delete mTransformStore;
+	mTransformStore = nullptr;
+	delete mScheduler;
+	mScheduler = nullptr;
+	delete mMovementSystem;
+	mMovementSystem = nullptr;
+	delete mJobSystem;
+	mJobSystem = nullptr;
 	SDL_Quit();
 }
 
@@ -5,6 +5,7 @@
 #include<unordered_map>
 #include<string>
 #include"Math.h"
+#include"SlotMap.h"
 
 #include"VertexArray.h"
 
@@ -13,39 +14,89 @@ class Game
 public:
 	Game();
 	bool Initialize();
+	// Create the simulation systems only: no SDL, window, GL context or
+	// game data. Actors and components work as usual but nothing can be
+	// drawn or loaded. For EngineTests.
+	void InitializeHeadless();
 	void RunLoop();
 	void ShutDown();
-	void AddActor(class Actor* actor);
+	// Called by Actor, an actor added while updating is first updated
+	// in the next step
+	SlotHandle AddActor(class Actor* actor);
 	void RemoveActor(class Actor* actor);
+	// Null once the actor has been deleted
+	class Actor* GetActor(SlotHandle handle) const;
 
-	void AddSprite(class SpriteComponent* sprite);
-	void RemoveSprite(class SpriteComponent* sprite);
 	SDL_Texture* LoadTexture(const char* file);
 	class Renderer* GetRenderer() { return mRenderer; }
+	// Bounds of every actor with a mesh, for culling and spatial queries
+	class AABBTree* GetSpatialTree() { return mSpatialTree; }
+	// Transforms of every actor
+	class TransformStore* GetTransformStore() { return mTransformStore; }
+	// Worker threads shared by the engine's subsystems
+	class JobSystem* GetJobSystem() { return mJobSystem; }
+	// Pool of every MoveComponent's speeds, null when components update
+	// one at a time
+	class MovementSystem* GetMovementSystem() { return mMovementSystem; }
+	// Add a block of count cubes on load and log frame stats (-stress)
+	void SetStressActors(int count) { mStressActors = count; }
+	// Simulate in fixed steps of step seconds and draw transforms blended
+	// between the last two steps. 0 runs one variable step per frame.
+	void SetFixedStep(float step) { mFixedStep = step; }
+	// Keep component data in pools updated by systems (the default), or
+	// update every component through its own Update (-objects).
+	// Set before Initialize.
+	void SetPooledComponents(bool pooled) { mPooledComponents = pooled; }
+	// One simulation step: systems, components, actors, transforms and
+	// dead actors. RunLoop calls it, EngineTests steps headless games.
+	void UpdateGame(float deltaTime);
 
 private:
 	void ProcessInput();
-	void UpdateGame();
 	void GenerateOutput();
 	void LoadData();
 	void UnloadData();
+	// Job system, transform store, spatial tree and component systems
+	void CreateSystems();
+	// Compose dirty world transforms and inform their actors
+	void UpdateTransforms();
+	// Accumulate stress test timings, logged once a second
+	void ReportFrameStats(Uint64 frameTicks, Uint64 drawTicks);
+	// Sleep until the next frame is due when the swap doesn't wait for vsync
+	void WaitForNextFrame(Uint64 frameStart);
 
 	SDL_Renderer* mSDLRenderer;
 	SDL_GLContext mContent;
 	
 	bool mIsRunning;
-	bool mUpdatingActors;
-	Uint32 mTicksCount;
+	// Started by InitializeHeadless
+	bool mHeadless;
+	// Fixed step length in seconds (0 for variable steps) and the time
+	// not simulated yet
+	float mFixedStep;
+	double mAccumulator;
+	bool mPooledComponents;
+
+	// Stress test actors and the stats gathered since the last report
+	int mStressActors;
+	Uint32 mStatsFrames;
+	Uint64 mStatsFrameTicks;
+	Uint64 mStatsDrawTicks;
+	Uint64 mStatsStart;
 
 	VertexArray* mSpriteVerts;
     class Shader* mSpriteShader;
 	class Renderer* mRenderer;
+	class AABBTree* mSpatialTree;
+	class TransformStore* mTransformStore;
+	class JobSystem* mJobSystem;
+	class ComponentScheduler* mScheduler;
+	class MovementSystem* mMovementSystem;
 	class CameraActor* mCameraActor;
 
 	//All actors in the game
-	std::vector<Actor*> mActors;
-	//Any pending actors
-	std::vector<Actor*> mPendingActors;
-	std::vector<class SpriteComponent*> mSprites;
+	SlotMap<class Actor*> mActors;
+	// Actors found dead at the end of UpdateGame
+	std::vector<class Actor*> mDeadActors;
 	std::unordered_map<std::string, SDL_Texture*> mTextures;
 };
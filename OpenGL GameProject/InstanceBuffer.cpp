@@ -0,0 +1,28 @@
+#include"InstanceBuffer.h"
+#include"glew.h"
+
+static_assert(sizeof(Matrix4) == sizeof(float) * 16, "Instance attributes expect tightly packed matrices");
+
+InstanceBuffer::InstanceBuffer()
+	:mBuffer(0)
+	, mCapacity(0)
+{
+	glGenBuffers(1, &mBuffer);
+}
+
+InstanceBuffer::~InstanceBuffer()
+{
+	glDeleteBuffers(1, &mBuffer);
+}
+
+void InstanceBuffer::Upload(const Matrix4* transforms, size_t count)
+{
+	glBindBuffer(GL_ARRAY_BUFFER, mBuffer);
+	if (count > mCapacity)
+	{
+		// Grow with some slack so spawning actors doesn't reallocate every frame
+		mCapacity = count + count / 2;
+	}
+	glBufferData(GL_ARRAY_BUFFER, mCapacity * sizeof(Matrix4), nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(Matrix4), transforms);
+}
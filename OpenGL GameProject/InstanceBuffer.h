@@ -0,0 +1,21 @@
+#pragma once
+#include<cstddef>
+#include"Math.h"
+
+// Per instance world transforms, streamed every frame for instanced
+// draws. VertexArray::SetInstanceData points a mesh at a range of it.
+class InstanceBuffer
+{
+public:
+	InstanceBuffer();
+	~InstanceBuffer();
+
+	// Replace the contents (the previous storage is orphaned)
+	void Upload(const Matrix4* transforms, size_t count);
+	unsigned int GetBuffer() const { return mBuffer; }
+
+private:
+	unsigned int mBuffer;
+	// Matrices the GL storage can hold
+	size_t mCapacity;
+};
@@ -0,0 +1,218 @@
+#include"JobSystem.h"
+
+namespace
+{
+	// Set on worker threads, so Run and Wait use their own deque
+	thread_local const JobSystem* CurrentSystem = nullptr;
+	thread_local unsigned int CurrentIndex = 0;
+}
+
+JobSystem::JobSystem(unsigned int numWorkers)
+	:mJobs(new Job[MaxJobs])
+	, mNextJob(0)
+	, mQueuedJobs(0)
+	, mQuit(false)
+{
+	for (size_t i = 0; i < MaxJobs; i++)
+	{
+		mJobs[i].mUnfinished = 0;
+		mJobs[i].mBlockers = 0;
+	}
+	for (unsigned int i = 0; i <= numWorkers; i++)
+	{
+		mQueues.emplace_back(new Queue());
+	}
+	for (unsigned int i = 1; i <= numWorkers; i++)
+	{
+		mThreads.emplace_back(&JobSystem::WorkerLoop, this, i);
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(mWakeMutex);
+		mQuit = true;
+	}
+	mWake.notify_all();
+	for (auto& thread : mThreads)
+	{
+		thread.join();
+	}
+}
+
+unsigned int JobSystem::GetDefaultWorkers()
+{
+	unsigned int threads = std::thread::hardware_concurrency();
+	return threads > 1 ? threads - 1 : 0;
+}
+
+void JobSystem::WorkerLoop(unsigned int index)
+{
+	CurrentSystem = this;
+	CurrentIndex = index;
+	while (true)
+	{
+		JobHandle job = GetJob(index);
+		if (job)
+		{
+			Execute(job);
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(mWakeMutex);
+		mWake.wait(lock, [this]() { return mQuit || mQueuedJobs.load() > 0; });
+		if (mQuit)
+		{
+			return;
+		}
+	}
+}
+
+JobHandle JobSystem::Allocate(JobHandle parent)
+{
+	JobHandle job = &mJobs[mNextJob.fetch_add(1) % MaxJobs];
+	// Everything in flight at once must fit in the ring, if it doesn't
+	// help until the old job in this slot is done
+	Wait(job);
+	{
+		// The thread finishing the old job may still be in Finish
+		std::lock_guard<std::mutex> lock(job->mMutex);
+		job->mParent = parent;
+		job->mUnfinished = 1;
+		job->mBlockers = 1;
+		job->mDependents.clear();
+	}
+	if (parent)
+	{
+		parent->mUnfinished++;
+	}
+	return job;
+}
+
+unsigned int JobSystem::GetThreadIndex() const
+{
+	return CurrentSystem == this ? CurrentIndex : 0;
+}
+
+void JobSystem::AddDependency(JobHandle job, JobHandle dependency)
+{
+	std::lock_guard<std::mutex> lock(dependency->mMutex);
+	if (dependency->mUnfinished.load() == 0)
+	{
+		return;
+	}
+	job->mBlockers++;
+	dependency->mDependents.emplace_back(job);
+}
+
+void JobSystem::Run(JobHandle job)
+{
+	Unblock(job);
+}
+
+void JobSystem::Unblock(JobHandle job)
+{
+	if (--job->mBlockers == 0)
+	{
+		Push(job);
+	}
+}
+
+void JobSystem::Push(JobHandle job)
+{
+	Queue& queue = *mQueues[GetThreadIndex()];
+	{
+		std::lock_guard<std::mutex> lock(queue.mMutex);
+		queue.mJobs.emplace_back(job);
+	}
+	mQueuedJobs++;
+	if (!mThreads.empty())
+	{
+		// Taking the lock orders this against a worker about to sleep
+		{
+			std::lock_guard<std::mutex> lock(mWakeMutex);
+		}
+		mWake.notify_one();
+	}
+}
+
+JobHandle JobSystem::GetJob(unsigned int index)
+{
+	if (mQueuedJobs.load() == 0)
+	{
+		return nullptr;
+	}
+	// Newest from our own deque, it is likely still in cache
+	{
+		Queue& queue = *mQueues[index];
+		std::lock_guard<std::mutex> lock(queue.mMutex);
+		if (!queue.mJobs.empty())
+		{
+			JobHandle job = queue.mJobs.back();
+			queue.mJobs.pop_back();
+			mQueuedJobs--;
+			return job;
+		}
+	}
+	// Oldest from the others, starting with the next one along
+	size_t count = mQueues.size();
+	for (size_t i = 1; i < count; i++)
+	{
+		Queue& queue = *mQueues[(index + i) % count];
+		std::lock_guard<std::mutex> lock(queue.mMutex);
+		if (!queue.mJobs.empty())
+		{
+			JobHandle job = queue.mJobs.front();
+			queue.mJobs.pop_front();
+			mQueuedJobs--;
+			return job;
+		}
+	}
+	return nullptr;
+}
+
+void JobSystem::Execute(JobHandle job)
+{
+	job->mFunction(job->mData);
+	Finish(job);
+}
+
+void JobSystem::Finish(JobHandle job)
+{
+	// Once finished the slot can be reused, only locals are safe after the lock
+	JobHandle parent = job->mParent;
+	std::vector<JobHandle> dependents;
+	{
+		std::lock_guard<std::mutex> lock(job->mMutex);
+		if (--job->mUnfinished != 0)
+		{
+			return;
+		}
+		dependents.swap(job->mDependents);
+	}
+	for (JobHandle dependent : dependents)
+	{
+		Unblock(dependent);
+	}
+	if (parent)
+	{
+		Finish(parent);
+	}
+}
+
+void JobSystem::Wait(JobHandle job)
+{
+	unsigned int index = GetThreadIndex();
+	while (job->mUnfinished.load() != 0)
+	{
+		JobHandle next = GetJob(index);
+		if (next)
+		{
+			Execute(next);
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+}
@@ -0,0 +1,159 @@
+#pragma once
+#include<atomic>
+#include<condition_variable>
+#include<cstddef>
+#include<deque>
+#include<memory>
+#include<mutex>
+#include<new>
+#include<thread>
+#include<utility>
+#include<vector>
+#include"Math.h"
+
+// A unit of work. Jobs live in the JobSystem's pool, use them through
+// the JobSystem only.
+struct Job
+{
+	// Room for the callable's captures
+	static const size_t DataSize = 64;
+
+	void (*mFunction)(void* data);
+	alignas(16) unsigned char mData[DataSize];
+	struct Job* mParent;
+	// This job plus its unfinished children, finished at 0
+	std::atomic<int> mUnfinished;
+	// Unfinished dependencies, plus one until Run
+	std::atomic<int> mBlockers;
+	// Jobs waiting on this one, guarded by mMutex
+	std::mutex mMutex;
+	std::vector<struct Job*> mDependents;
+};
+
+typedef Job* JobHandle;
+
+// Work-stealing scheduler: every worker thread (and the thread that owns
+// the system) has its own deque. Threads push and pop their own deque at
+// the back and steal from the front of the others when it is empty, so
+// big split ranges are what gets stolen.
+//
+// A job runs once Run has been called and every dependency added with
+// AddDependency has finished. A job with a parent counts as part of it:
+// the parent only finishes once all its children have. Handles come from
+// a ring of MaxJobs and stay valid until that many more jobs have been
+// created, wait on them within the frame. No more than MaxJobs may be
+// unfinished at once.
+class JobSystem
+{
+public:
+	static const size_t MaxJobs = 4096;
+	// Most ranges one ParallelFor splits into, well within MaxJobs
+	static const size_t MaxRanges = 256;
+
+	// numWorkers threads besides the caller (0 runs everything in Wait)
+	explicit JobSystem(unsigned int numWorkers);
+	~JobSystem();
+
+	// A worker per hardware thread, minus the one running the game loop
+	static unsigned int GetDefaultWorkers();
+	unsigned int GetNumWorkers() const { return static_cast<unsigned int>(mThreads.size()); }
+
+	// Job calling callable(), which must fit in Job::DataSize
+	template<typename Callable>
+	JobHandle Create(Callable callable, JobHandle parent = nullptr);
+	// job won't start before dependency has finished (call before Run)
+	void AddDependency(JobHandle job, JobHandle dependency);
+	// Queue job on this thread's deque, once its dependencies are done
+	void Run(JobHandle job);
+	// Run queued jobs on this thread until job has finished
+	void Wait(JobHandle job);
+	bool IsFinished(JobHandle job) const { return job->mUnfinished.load() == 0; }
+
+	// function(first, last) over [begin, end) split into ranges of at
+	// most grain (larger if that would make over MaxRanges), returns when
+	// all of them are done
+	template<typename Function>
+	void ParallelFor(size_t begin, size_t end, size_t grain, const Function& function);
+
+private:
+	struct Queue
+	{
+		std::mutex mMutex;
+		std::deque<JobHandle> mJobs;
+	};
+
+	void WorkerLoop(unsigned int index);
+	// Next pool slot, with its counters reset
+	JobHandle Allocate(JobHandle parent);
+	// Deque of the calling thread (0 for threads that aren't workers)
+	unsigned int GetThreadIndex() const;
+	void Push(JobHandle job);
+	// Own deque first, then steal
+	JobHandle GetJob(unsigned int index);
+	void Execute(JobHandle job);
+	void Finish(JobHandle job);
+	// Run job if that was its last blocker
+	void Unblock(JobHandle job);
+
+	template<typename Function>
+	void SplitRange(JobHandle parent, size_t begin, size_t end, size_t grain, const Function* function);
+
+	std::unique_ptr<Job[]> mJobs;
+	std::atomic<size_t> mNextJob;
+
+	// mQueues[0] is the owning thread's, then one per worker
+	std::vector<std::unique_ptr<Queue>> mQueues;
+	std::vector<std::thread> mThreads;
+	// Jobs sitting in a deque, workers sleep while it is 0
+	std::atomic<int> mQueuedJobs;
+	std::mutex mWakeMutex;
+	std::condition_variable mWake;
+	bool mQuit;
+};
+
+template<typename Callable>
+JobHandle JobSystem::Create(Callable callable, JobHandle parent)
+{
+	static_assert(sizeof(Callable) <= Job::DataSize, "Job captures too large, capture a pointer instead");
+	static_assert(alignof(Callable) <= 16, "Job captures over-aligned");
+	JobHandle job = Allocate(parent);
+	new (job->mData) Callable(std::move(callable));
+	job->mFunction = [](void* data)
+	{
+		Callable* c = static_cast<Callable*>(data);
+		(*c)();
+		c->~Callable();
+	};
+	return job;
+}
+
+template<typename Function>
+void JobSystem::ParallelFor(size_t begin, size_t end, size_t grain, const Function& function)
+{
+	if (begin >= end)
+	{
+		return;
+	}
+	grain = Math::Max(grain, (end - begin + MaxRanges - 1) / MaxRanges);
+	JobHandle root = Create([]() {});
+	SplitRange(root, begin, end, grain, &function);
+	Run(root);
+	Wait(root);
+}
+
+template<typename Function>
+void JobSystem::SplitRange(JobHandle parent, size_t begin, size_t end, size_t grain, const Function* function)
+{
+	// Hand the top half to the deque and keep splitting the bottom one
+	while (end - begin > grain)
+	{
+		size_t mid = begin + (end - begin) / 2;
+		JobHandle half = Create([this, parent, mid, end, grain, function]()
+		{
+			SplitRange(parent, mid, end, grain, function);
+		}, parent);
+		Run(half);
+		end = mid;
+	}
+	(*function)(begin, end);
+}
@@ -1,8 +1,33 @@
 #include"Game.h"
+#include<cstring>
+#include<cstdlib>
 
 int main(int argc, char** argv)
 {
 	Game game;
+	// -stress [count]: add count cubes (default 10000) and log frame stats
+	// -variable: one variable length update per frame instead of fixed steps
+	// -objects: update every component on its own instead of through pools
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-stress") == 0)
+		{
+			int count = 10000;
+			if (i + 1 < argc && atoi(argv[i + 1]) > 0)
+			{
+				count = atoi(argv[++i]);
+			}
+			game.SetStressActors(count);
+		}
+		else if (strcmp(argv[i], "-variable") == 0)
+		{
+			game.SetFixedStep(0.0f);
+		}
+		else if (strcmp(argv[i], "-objects") == 0)
+		{
+			game.SetPooledComponents(false);
+		}
+	}
 	bool success = game.Initialize();
 	if (success)
 	{
@@ -0,0 +1,132 @@
+#include"MappedFile.h"
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include<windows.h>
+#else
+#include<fcntl.h>
+#include<unistd.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+#endif
+
+#ifdef _WIN32
+MappedFile::MappedFile()
+	:mData(nullptr)
+	, mSize(0)
+	, mFile(INVALID_HANDLE_VALUE)
+	, mMapping(nullptr)
+{
+}
+#else
+MappedFile::MappedFile()
+	:mData(nullptr)
+	, mSize(0)
+	, mFile(-1)
+{
+}
+#endif
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+#ifdef _WIN32
+bool MappedFile::Open(const std::string& fileName)
+{
+	Close();
+
+	mFile = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (mFile == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(mFile, &size) || size.QuadPart == 0)
+	{
+		Close();
+		return false;
+	}
+
+	mMapping = CreateFileMappingA(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mMapping == nullptr)
+	{
+		Close();
+		return false;
+	}
+
+	mData = static_cast<const unsigned char*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+	if (mData == nullptr)
+	{
+		Close();
+		return false;
+	}
+	mSize = static_cast<size_t>(size.QuadPart);
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (mData)
+	{
+		UnmapViewOfFile(mData);
+		mData = nullptr;
+	}
+	if (mMapping)
+	{
+		CloseHandle(mMapping);
+		mMapping = nullptr;
+	}
+	if (mFile != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(mFile);
+		mFile = INVALID_HANDLE_VALUE;
+	}
+	mSize = 0;
+}
+#else
+bool MappedFile::Open(const std::string& fileName)
+{
+	Close();
+
+	mFile = open(fileName.c_str(), O_RDONLY);
+	if (mFile < 0)
+	{
+		return false;
+	}
+
+	struct stat info;
+	if (fstat(mFile, &info) != 0 || info.st_size == 0)
+	{
+		Close();
+		return false;
+	}
+
+	void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, mFile, 0);
+	if (data == MAP_FAILED)
+	{
+		Close();
+		return false;
+	}
+	mData = static_cast<const unsigned char*>(data);
+	mSize = static_cast<size_t>(info.st_size);
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (mData)
+	{
+		munmap(const_cast<unsigned char*>(mData), mSize);
+		mData = nullptr;
+	}
+	if (mFile >= 0)
+	{
+		close(mFile);
+		mFile = -1;
+	}
+	mSize = 0;
+}
+#endif
@@ -0,0 +1,31 @@
+#pragma once
+#include<string>
+#include<cstddef>
+
+// Read-only memory mapping of a whole file
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	bool Open(const std::string& fileName);
+	void Close();
+
+	bool IsOpen() const { return mData != nullptr; }
+	const unsigned char* GetData() const { return mData; }
+	size_t GetSize() const { return mSize; }
+
+private:
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	const unsigned char* mData;
+	size_t mSize;
+#ifdef _WIN32
+	void* mFile;
+	void* mMapping;
+#else
+	int mFile;
+#endif
+};
@@ -36,6 +36,58 @@ const Matrix4 Matrix4::Identity(m4Ident);
 
 const Quaternion Quaternion::Identity(0.0f, 0.0f, 0.0f, 1.0f);
 
+namespace
+{
+	// (x, y, z, w) * mat, same order of operations on every path
+	void TransformVec4(float x, float y, float z, float w, const Matrix4& mat, float* out)
+	{
+#if defined(MATH_SSE)
+		__m128 r = _mm_mul_ps(_mm_set1_ps(x), _mm_loadu_ps(mat.matrix[0]));
+		r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(y), _mm_loadu_ps(mat.matrix[1])));
+		r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(z), _mm_loadu_ps(mat.matrix[2])));
+		r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(w), _mm_loadu_ps(mat.matrix[3])));
+		_mm_storeu_ps(out, r);
+#elif defined(MATH_NEON)
+		float32x4_t r = vmulq_n_f32(vld1q_f32(mat.matrix[0]), x);
+		r = vaddq_f32(r, vmulq_n_f32(vld1q_f32(mat.matrix[1]), y));
+		r = vaddq_f32(r, vmulq_n_f32(vld1q_f32(mat.matrix[2]), z));
+		r = vaddq_f32(r, vmulq_n_f32(vld1q_f32(mat.matrix[3]), w));
+		vst1q_f32(out, r);
+#else
+		for (int i = 0; i < 4; i++)
+		{
+			out[i] = x * mat.matrix[0][i] + y * mat.matrix[1][i] +
+				z * mat.matrix[2][i] + w * mat.matrix[3][i];
+		}
+#endif
+	}
+
+#if defined(MATH_SSE)
+	// Lanes (a[x], a[y], b[z], b[w])
+	#define MATH_SHUFFLE(a, b, x, y, z, w) _mm_shuffle_ps(a, b, _MM_SHUFFLE(w, z, y, x))
+
+	// 2x2 row major matrices held as (m00, m01, m10, m11)
+	// a * b
+	inline __m128 Mat2Mul(__m128 a, __m128 b)
+	{
+		return _mm_add_ps(_mm_mul_ps(a, MATH_SHUFFLE(b, b, 0, 3, 0, 3)),
+			_mm_mul_ps(MATH_SHUFFLE(a, a, 1, 0, 3, 2), MATH_SHUFFLE(b, b, 2, 1, 2, 1)));
+	}
+	// adjugate(a) * b
+	inline __m128 Mat2AdjMul(__m128 a, __m128 b)
+	{
+		return _mm_sub_ps(_mm_mul_ps(MATH_SHUFFLE(a, a, 3, 3, 0, 0), b),
+			_mm_mul_ps(MATH_SHUFFLE(a, a, 1, 1, 2, 2), MATH_SHUFFLE(b, b, 2, 3, 0, 1)));
+	}
+	// a * adjugate(b)
+	inline __m128 Mat2MulAdj(__m128 a, __m128 b)
+	{
+		return _mm_sub_ps(_mm_mul_ps(a, MATH_SHUFFLE(b, b, 3, 0, 3, 0)),
+			_mm_mul_ps(MATH_SHUFFLE(a, a, 1, 0, 3, 2), MATH_SHUFFLE(b, b, 2, 1, 2, 1)));
+	}
+#endif
+}
+
 Vector2 Vector2::Transform(const Vector2& vec, const Matrix3& mat, float w /*= 1.0f*/)
 {
 	Vector2 returnValue;
@@ -47,29 +99,19 @@ Vector2 Vector2::Transform(const Vector2& vec, const Matrix3& mat, float w /*= 1
 
 Vector3 Vector3::Transform(const Vector3& vec, const Matrix4& mat, float w /*= 1.0f*/)
 {
-	Vector3 returnValue;
-	returnValue.x = vec.x * mat.matrix[0][0] + vec.y * mat.matrix[1][0] +
-		vec.z * mat.matrix[2][0] + w * mat.matrix[3][0];
-	returnValue.y = vec.x * mat.matrix[0][1] + vec.y * mat.matrix[1][1] +
-		vec.z * mat.matrix[2][1] + w * mat.matrix[3][1];
-	returnValue.z = vec.x * mat.matrix[0][2] + vec.y * mat.matrix[1][2] +
-		vec.z * mat.matrix[2][2] + w * mat.matrix[3][2];
+	float result[4];
+	TransformVec4(vec.x, vec.y, vec.z, w, mat, result);
 	//ignore w since we aren't returning a new value for it...
-	return returnValue;
+	return Vector3(result[0], result[1], result[2]);
 }
 
 // This will transform the vector and renormalize the w component
 Vector3 Vector3::TransformWithPerspDiv(const Vector3& vec, const Matrix4& mat, float w /*= 1.0f*/)
 {
-	Vector3 returnValue;
-	returnValue.x = vec.x * mat.matrix[0][0] + vec.y * mat.matrix[1][0] +
-		vec.z * mat.matrix[2][0] + w * mat.matrix[3][0];
-	returnValue.y = vec.x * mat.matrix[0][1] + vec.y * mat.matrix[1][1] +
-		vec.z * mat.matrix[2][1] + w * mat.matrix[3][1];
-	returnValue.z = vec.x * mat.matrix[0][2] + vec.y * mat.matrix[1][2] +
-		vec.z * mat.matrix[2][2] + w * mat.matrix[3][2];
-	float transformedW = vec.x * mat.matrix[0][3] + vec.y * mat.matrix[1][3] +
-		vec.z * mat.matrix[2][3] + w * mat.matrix[3][3];
+	float result[4];
+	TransformVec4(vec.x, vec.y, vec.z, w, mat, result);
+	Vector3 returnValue(result[0], result[1], result[2]);
+	float transformedW = result[3];
 	if (!Math::NearZero(Math::Abs(transformedW)))
 	{
 		transformedW = 1.0f / transformedW;
@@ -90,6 +132,55 @@ Vector3 Vector3::Transform(const Vector3& v, const Quaternion& q)
 
 void Matrix4::Invert()
 {
+#if defined(MATH_SSE)
+	// Block inverse over the 2x2 sub matrices | A B |
+	//                                         | C D |
+	const __m128 r0 = _mm_loadu_ps(matrix[0]);
+	const __m128 r1 = _mm_loadu_ps(matrix[1]);
+	const __m128 r2 = _mm_loadu_ps(matrix[2]);
+	const __m128 r3 = _mm_loadu_ps(matrix[3]);
+	__m128 A = _mm_movelh_ps(r0, r1);
+	__m128 B = _mm_movehl_ps(r1, r0);
+	__m128 C = _mm_movelh_ps(r2, r3);
+	__m128 D = _mm_movehl_ps(r3, r2);
+
+	// (|A|, |B|, |C|, |D|)
+	__m128 detSub = _mm_sub_ps(
+		_mm_mul_ps(MATH_SHUFFLE(r0, r2, 0, 2, 0, 2), MATH_SHUFFLE(r1, r3, 1, 3, 1, 3)),
+		_mm_mul_ps(MATH_SHUFFLE(r0, r2, 1, 3, 1, 3), MATH_SHUFFLE(r1, r3, 0, 2, 0, 2)));
+	__m128 detA = MATH_SHUFFLE(detSub, detSub, 0, 0, 0, 0);
+	__m128 detB = MATH_SHUFFLE(detSub, detSub, 1, 1, 1, 1);
+	__m128 detC = MATH_SHUFFLE(detSub, detSub, 2, 2, 2, 2);
+	__m128 detD = MATH_SHUFFLE(detSub, detSub, 3, 3, 3, 3);
+
+	// Adjugates of the blocks of the inverse (X Y, Z W) times |M|
+	__m128 DC = Mat2AdjMul(D, C);
+	__m128 AB = Mat2AdjMul(A, B);
+	__m128 X = _mm_sub_ps(_mm_mul_ps(detD, A), Mat2Mul(B, DC));
+	__m128 W = _mm_sub_ps(_mm_mul_ps(detA, D), Mat2Mul(C, AB));
+	__m128 Y = _mm_sub_ps(_mm_mul_ps(detB, C), Mat2MulAdj(D, AB));
+	__m128 Z = _mm_sub_ps(_mm_mul_ps(detC, B), Mat2MulAdj(A, DC));
+
+	// |M| = |A||D| + |B||C| - tr((A#B)(D#C))
+	__m128 tr = _mm_mul_ps(AB, MATH_SHUFFLE(DC, DC, 0, 2, 1, 3));
+	tr = _mm_add_ps(tr, _mm_movehl_ps(tr, tr));
+	tr = _mm_add_ss(tr, MATH_SHUFFLE(tr, tr, 1, 1, 1, 1));
+	tr = MATH_SHUFFLE(tr, tr, 0, 0, 0, 0);
+	__m128 detM = _mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC));
+	detM = _mm_sub_ps(detM, tr);
+
+	// Undo the adjugate signs and divide by the determinant
+	__m128 invDet = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), detM);
+	X = _mm_mul_ps(X, invDet);
+	Y = _mm_mul_ps(Y, invDet);
+	Z = _mm_mul_ps(Z, invDet);
+	W = _mm_mul_ps(W, invDet);
+
+	_mm_storeu_ps(matrix[0], MATH_SHUFFLE(X, Y, 3, 1, 3, 1));
+	_mm_storeu_ps(matrix[1], MATH_SHUFFLE(X, Y, 2, 0, 2, 0));
+	_mm_storeu_ps(matrix[2], MATH_SHUFFLE(Z, W, 3, 1, 3, 1));
+	_mm_storeu_ps(matrix[3], MATH_SHUFFLE(Z, W, 2, 0, 2, 0));
+#else
 
 	float tmp[12];
 	float src[16];
@@ -199,6 +290,7 @@ void Matrix4::Invert()
 			matrix[i][j] = dst[i * 4 + j];
 		}
 	}
+#endif
 }
 
 Matrix4 Matrix4::CreateFromQuaternion(const class Quaternion& q)
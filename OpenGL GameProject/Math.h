@@ -3,6 +3,35 @@
 #include <memory.h>
 #include <limits>
 
+// SIMD paths are picked at compile time from the target's instruction
+// set (define MATH_NO_SIMD for the portable scalar code). Every path
+// keeps the scalar order of operations where it can, so results match.
+// EngineTests compares every path against a MATH_NO_SIMD build.
+#if !defined(MATH_NO_SIMD)
+#if defined(__AVX__)
+#define MATH_AVX 1
+#define MATH_SSE 1
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MATH_SSE 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define MATH_NEON 1
+#include <arm_neon.h>
+#endif
+#endif
+
+#if defined(MATH_AVX)
+namespace MathSIMD
+{
+	// (lo, lo, lo, lo, hi, hi, hi, hi)
+	inline __m256 Splat2(float lo, float hi)
+	{
+		return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(lo)), _mm_set1_ps(hi), 1);
+	}
+}
+#endif
+
 namespace Math
 {
 	const float Pi = 3.1415926535f;
@@ -123,6 +152,12 @@ public:
 	
 	}
 
+	//Cast to a const float pointer
+	const float* GetAsFloatPtr() const
+	{
+		return reinterpret_cast<const float*>(&x);
+	}
+
 	void Set(float inX, float inY)
 	{
 		x = inX;
@@ -565,6 +600,50 @@ public:
 	friend Matrix4 operator*(const Matrix4& a, const Matrix4& b)
 	{
 		Matrix4 returnValue;
+#if defined(MATH_AVX)
+		// Two rows of the result per step, row i = sum over k of a[i][k] * b row k
+		const __m256 b0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(b.matrix[0]));
+		const __m256 b1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(b.matrix[1]));
+		const __m256 b2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(b.matrix[2]));
+		const __m256 b3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(b.matrix[3]));
+		for (int i = 0; i < 4; i += 2)
+		{
+			__m256 r = _mm256_mul_ps(MathSIMD::Splat2(a.matrix[i][0], a.matrix[i + 1][0]), b0);
+			r = _mm256_add_ps(r, _mm256_mul_ps(MathSIMD::Splat2(a.matrix[i][1], a.matrix[i + 1][1]), b1));
+			r = _mm256_add_ps(r, _mm256_mul_ps(MathSIMD::Splat2(a.matrix[i][2], a.matrix[i + 1][2]), b2));
+			r = _mm256_add_ps(r, _mm256_mul_ps(MathSIMD::Splat2(a.matrix[i][3], a.matrix[i + 1][3]), b3));
+			_mm256_storeu_ps(returnValue.matrix[i], r);
+		}
+#elif defined(MATH_SSE)
+		// Row i of the result = sum over k of a[i][k] * b row k
+		const __m128 b0 = _mm_loadu_ps(b.matrix[0]);
+		const __m128 b1 = _mm_loadu_ps(b.matrix[1]);
+		const __m128 b2 = _mm_loadu_ps(b.matrix[2]);
+		const __m128 b3 = _mm_loadu_ps(b.matrix[3]);
+		for (int i = 0; i < 4; i++)
+		{
+			const __m128 row = _mm_loadu_ps(a.matrix[i]);
+			__m128 r = _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(0, 0, 0, 0)), b0);
+			r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(1, 1, 1, 1)), b1));
+			r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(2, 2, 2, 2)), b2));
+			r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(3, 3, 3, 3)), b3));
+			_mm_storeu_ps(returnValue.matrix[i], r);
+		}
+#elif defined(MATH_NEON)
+		const float32x4_t b0 = vld1q_f32(b.matrix[0]);
+		const float32x4_t b1 = vld1q_f32(b.matrix[1]);
+		const float32x4_t b2 = vld1q_f32(b.matrix[2]);
+		const float32x4_t b3 = vld1q_f32(b.matrix[3]);
+		for (int i = 0; i < 4; i++)
+		{
+			// Separate multiply and add, so results match the scalar code
+			float32x4_t r = vmulq_n_f32(b0, a.matrix[i][0]);
+			r = vaddq_f32(r, vmulq_n_f32(b1, a.matrix[i][1]));
+			r = vaddq_f32(r, vmulq_n_f32(b2, a.matrix[i][2]));
+			r = vaddq_f32(r, vmulq_n_f32(b3, a.matrix[i][3]));
+			vst1q_f32(returnValue.matrix[i], r);
+		}
+#else
 		//row0
 		returnValue.matrix[0][0] =
 			a.matrix[0][0] * b.matrix[0][0] +
@@ -665,6 +744,7 @@ public:
 			a.matrix[3][2] * b.matrix[2][3] +
 			a.matrix[3][3] * b.matrix[3][3];
 
+#endif
 		return returnValue;
 	}
 
@@ -977,7 +1057,18 @@ public:
 	static Quaternion Concatenate(const Quaternion& q, const Quaternion& p)
 	{
 		Quaternion returnValue;
-
+#if defined(MATH_SSE)
+		// Sum over the components of p of p.i times a signed shuffle of q
+		const __m128 qv = _mm_loadu_ps(&q.x);
+		__m128 r = _mm_mul_ps(_mm_set1_ps(p.w), qv);
+		r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(p.x),
+			_mm_mul_ps(_mm_shuffle_ps(qv, qv, _MM_SHUFFLE(0, 1, 2, 3)), _mm_setr_ps(1.0f, -1.0f, 1.0f, -1.0f))));
+		r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(p.y),
+			_mm_mul_ps(_mm_shuffle_ps(qv, qv, _MM_SHUFFLE(1, 0, 3, 2)), _mm_setr_ps(1.0f, 1.0f, -1.0f, -1.0f))));
+		r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(p.z),
+			_mm_mul_ps(_mm_shuffle_ps(qv, qv, _MM_SHUFFLE(2, 3, 0, 1)), _mm_setr_ps(-1.0f, 1.0f, 1.0f, -1.0f))));
+		_mm_storeu_ps(&returnValue.x, r);
+#else
 		//Vector component is:
 		//ps * qv + qs * pv + pv x qv
 		Vector3 qv(q.x, q.y, q.z);
@@ -990,6 +1081,7 @@ public:
 		//Scalar component is:
 		//ps * qs - pv . qv
 		returnValue.w = p.w * q.w - Vector3::Dot(pv, qv);
+#endif
 
 		return returnValue;
 	}
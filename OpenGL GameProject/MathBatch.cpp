@@ -0,0 +1,310 @@
+#include"MathBatch.h"
+
+void MathBatch::TransformPoints(const float* x, const float* y, const float* z, size_t count,
+	const Matrix4& mat, float* outX, float* outY, float* outZ)
+{
+	const float(*m)[4] = mat.matrix;
+	float* out[3] = { outX, outY, outZ };
+	size_t i = 0;
+#if defined(MATH_AVX)
+	__m256 cols[4][3];
+	for (int r = 0; r < 4; r++)
+	{
+		for (int c = 0; c < 3; c++)
+		{
+			cols[r][c] = _mm256_set1_ps(m[r][c]);
+		}
+	}
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 vx = _mm256_loadu_ps(x + i);
+		__m256 vy = _mm256_loadu_ps(y + i);
+		__m256 vz = _mm256_loadu_ps(z + i);
+		__m256 result[3];
+		for (int c = 0; c < 3; c++)
+		{
+			__m256 r = _mm256_mul_ps(vx, cols[0][c]);
+			r = _mm256_add_ps(r, _mm256_mul_ps(vy, cols[1][c]));
+			r = _mm256_add_ps(r, _mm256_mul_ps(vz, cols[2][c]));
+			result[c] = _mm256_add_ps(r, cols[3][c]);
+		}
+		// Stored after all three are computed, outputs may alias inputs
+		for (int c = 0; c < 3; c++)
+		{
+			_mm256_storeu_ps(out[c] + i, result[c]);
+		}
+	}
+#endif
+#if defined(MATH_SSE)
+	__m128 cols4[4][3];
+	for (int r = 0; r < 4; r++)
+	{
+		for (int c = 0; c < 3; c++)
+		{
+			cols4[r][c] = _mm_set1_ps(m[r][c]);
+		}
+	}
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 vx = _mm_loadu_ps(x + i);
+		__m128 vy = _mm_loadu_ps(y + i);
+		__m128 vz = _mm_loadu_ps(z + i);
+		__m128 result[3];
+		for (int c = 0; c < 3; c++)
+		{
+			__m128 r = _mm_mul_ps(vx, cols4[0][c]);
+			r = _mm_add_ps(r, _mm_mul_ps(vy, cols4[1][c]));
+			r = _mm_add_ps(r, _mm_mul_ps(vz, cols4[2][c]));
+			result[c] = _mm_add_ps(r, cols4[3][c]);
+		}
+		for (int c = 0; c < 3; c++)
+		{
+			_mm_storeu_ps(out[c] + i, result[c]);
+		}
+	}
+#elif defined(MATH_NEON)
+	for (; i + 4 <= count; i += 4)
+	{
+		float32x4_t vx = vld1q_f32(x + i);
+		float32x4_t vy = vld1q_f32(y + i);
+		float32x4_t vz = vld1q_f32(z + i);
+		float32x4_t result[3];
+		for (int c = 0; c < 3; c++)
+		{
+			float32x4_t r = vmulq_n_f32(vx, m[0][c]);
+			r = vaddq_f32(r, vmulq_n_f32(vy, m[1][c]));
+			r = vaddq_f32(r, vmulq_n_f32(vz, m[2][c]));
+			result[c] = vaddq_f32(r, vdupq_n_f32(m[3][c]));
+		}
+		for (int c = 0; c < 3; c++)
+		{
+			vst1q_f32(out[c] + i, result[c]);
+		}
+	}
+#endif
+	for (; i < count; i++)
+	{
+		float px = x[i];
+		float py = y[i];
+		float pz = z[i];
+		for (int c = 0; c < 3; c++)
+		{
+			out[c][i] = px * m[0][c] + py * m[1][c] + pz * m[2][c] + m[3][c];
+		}
+	}
+}
+
+void MathBatch::MultiplyMatrices(const Matrix4* a, size_t count, const Matrix4& b, Matrix4* out)
+{
+#if defined(MATH_AVX)
+	// b stays in registers, two rows of a per step as in operator*
+	const __m256 b0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(b.matrix[0]));
+	const __m256 b1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(b.matrix[1]));
+	const __m256 b2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(b.matrix[2]));
+	const __m256 b3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(b.matrix[3]));
+	for (size_t n = 0; n < count; n++)
+	{
+		const float(*am)[4] = a[n].matrix;
+		for (int i = 0; i < 4; i += 2)
+		{
+			__m256 r = _mm256_mul_ps(MathSIMD::Splat2(am[i][0], am[i + 1][0]), b0);
+			r = _mm256_add_ps(r, _mm256_mul_ps(MathSIMD::Splat2(am[i][1], am[i + 1][1]), b1));
+			r = _mm256_add_ps(r, _mm256_mul_ps(MathSIMD::Splat2(am[i][2], am[i + 1][2]), b2));
+			r = _mm256_add_ps(r, _mm256_mul_ps(MathSIMD::Splat2(am[i][3], am[i + 1][3]), b3));
+			_mm256_storeu_ps(out[n].matrix[i], r);
+		}
+	}
+#elif defined(MATH_SSE)
+	const __m128 b0 = _mm_loadu_ps(b.matrix[0]);
+	const __m128 b1 = _mm_loadu_ps(b.matrix[1]);
+	const __m128 b2 = _mm_loadu_ps(b.matrix[2]);
+	const __m128 b3 = _mm_loadu_ps(b.matrix[3]);
+	for (size_t n = 0; n < count; n++)
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			const __m128 row = _mm_loadu_ps(a[n].matrix[i]);
+			__m128 r = _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(0, 0, 0, 0)), b0);
+			r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(1, 1, 1, 1)), b1));
+			r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(2, 2, 2, 2)), b2));
+			r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(3, 3, 3, 3)), b3));
+			_mm_storeu_ps(out[n].matrix[i], r);
+		}
+	}
+#else
+	for (size_t n = 0; n < count; n++)
+	{
+		out[n] = a[n] * b;
+	}
+#endif
+}
+
+void MathBatch::QuaternionsToMatrices(const float* x, const float* y, const float* z, const float* w,
+	size_t count, Matrix4* out)
+{
+	size_t i = 0;
+#if defined(MATH_SSE)
+	// Rows for four matrices at once, one register per element, then
+	// transposed into each matrix's rows
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 two = _mm_set1_ps(2.0f);
+	const __m128 lastRow = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 qx = _mm_loadu_ps(x + i);
+		__m128 qy = _mm_loadu_ps(y + i);
+		__m128 qz = _mm_loadu_ps(z + i);
+		__m128 qw = _mm_loadu_ps(w + i);
+		__m128 tx = _mm_mul_ps(two, qx);
+		__m128 ty = _mm_mul_ps(two, qy);
+		__m128 tz = _mm_mul_ps(two, qz);
+		__m128 tw = _mm_mul_ps(two, qw);
+
+		__m128 rows[3][4];
+		rows[0][0] = _mm_sub_ps(_mm_sub_ps(one, _mm_mul_ps(ty, qy)), _mm_mul_ps(tz, qz));
+		rows[0][1] = _mm_add_ps(_mm_mul_ps(tx, qy), _mm_mul_ps(tw, qz));
+		rows[0][2] = _mm_sub_ps(_mm_mul_ps(tx, qz), _mm_mul_ps(tw, qy));
+		rows[1][0] = _mm_sub_ps(_mm_mul_ps(tx, qy), _mm_mul_ps(tw, qz));
+		rows[1][1] = _mm_sub_ps(_mm_sub_ps(one, _mm_mul_ps(tx, qx)), _mm_mul_ps(tz, qz));
+		rows[1][2] = _mm_add_ps(_mm_mul_ps(ty, qz), _mm_mul_ps(tw, qx));
+		rows[2][0] = _mm_add_ps(_mm_mul_ps(tx, qz), _mm_mul_ps(tw, qy));
+		rows[2][1] = _mm_sub_ps(_mm_mul_ps(ty, qz), _mm_mul_ps(tw, qx));
+		rows[2][2] = _mm_sub_ps(_mm_sub_ps(one, _mm_mul_ps(tx, qx)), _mm_mul_ps(ty, qy));
+		for (int r = 0; r < 3; r++)
+		{
+			rows[r][3] = _mm_setzero_ps();
+			_MM_TRANSPOSE4_PS(rows[r][0], rows[r][1], rows[r][2], rows[r][3]);
+		}
+		for (int j = 0; j < 4; j++)
+		{
+			float(*m)[4] = out[i + j].matrix;
+			_mm_storeu_ps(m[0], rows[0][j]);
+			_mm_storeu_ps(m[1], rows[1][j]);
+			_mm_storeu_ps(m[2], rows[2][j]);
+			_mm_storeu_ps(m[3], lastRow);
+		}
+	}
+#endif
+	for (; i < count; i++)
+	{
+		float qx = x[i];
+		float qy = y[i];
+		float qz = z[i];
+		float qw = w[i];
+		float(*m)[4] = out[i].matrix;
+		m[0][0] = 1.0f - 2.0f * qy * qy - 2.0f * qz * qz;
+		m[0][1] = 2.0f * qx * qy + 2.0f * qw * qz;
+		m[0][2] = 2.0f * qx * qz - 2.0f * qw * qy;
+		m[0][3] = 0.0f;
+		m[1][0] = 2.0f * qx * qy - 2.0f * qw * qz;
+		m[1][1] = 1.0f - 2.0f * qx * qx - 2.0f * qz * qz;
+		m[1][2] = 2.0f * qy * qz + 2.0f * qw * qx;
+		m[1][3] = 0.0f;
+		m[2][0] = 2.0f * qx * qz + 2.0f * qw * qy;
+		m[2][1] = 2.0f * qy * qz - 2.0f * qw * qx;
+		m[2][2] = 1.0f - 2.0f * qx * qx - 2.0f * qy * qy;
+		m[2][3] = 0.0f;
+		m[3][0] = 0.0f;
+		m[3][1] = 0.0f;
+		m[3][2] = 0.0f;
+		m[3][3] = 1.0f;
+	}
+}
+
+size_t MathBatch::SpheresInsidePlanes(const float* x, const float* y, const float* z, const float* radius,
+	size_t count, const float(*planes)[4], unsigned int numPlanes, uint8_t* outInside)
+{
+	size_t inside = 0;
+	size_t i = 0;
+#if defined(MATH_AVX)
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 vx = _mm256_loadu_ps(x + i);
+		__m256 vy = _mm256_loadu_ps(y + i);
+		__m256 vz = _mm256_loadu_ps(z + i);
+		__m256 negRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(radius + i));
+		__m256 mask = _mm256_cmp_ps(vx, vx, _CMP_EQ_OQ);
+		for (unsigned int p = 0; p < numPlanes; p++)
+		{
+			__m256 dist = _mm256_mul_ps(_mm256_set1_ps(planes[p][0]), vx);
+			dist = _mm256_add_ps(dist, _mm256_mul_ps(_mm256_set1_ps(planes[p][1]), vy));
+			dist = _mm256_add_ps(dist, _mm256_mul_ps(_mm256_set1_ps(planes[p][2]), vz));
+			dist = _mm256_add_ps(dist, _mm256_set1_ps(planes[p][3]));
+			mask = _mm256_and_ps(mask, _mm256_cmp_ps(dist, negRadius, _CMP_GE_OQ));
+		}
+		int bits = _mm256_movemask_ps(mask);
+		for (unsigned int j = 0; j < 8; j++)
+		{
+			uint8_t v = static_cast<uint8_t>((bits >> j) & 1);
+			outInside[i + j] = v;
+			inside += v;
+		}
+	}
+#endif
+#if defined(MATH_SSE)
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 vx = _mm_loadu_ps(x + i);
+		__m128 vy = _mm_loadu_ps(y + i);
+		__m128 vz = _mm_loadu_ps(z + i);
+		__m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(radius + i));
+		__m128 mask = _mm_cmpeq_ps(vx, vx);
+		for (unsigned int p = 0; p < numPlanes; p++)
+		{
+			__m128 dist = _mm_mul_ps(_mm_set1_ps(planes[p][0]), vx);
+			dist = _mm_add_ps(dist, _mm_mul_ps(_mm_set1_ps(planes[p][1]), vy));
+			dist = _mm_add_ps(dist, _mm_mul_ps(_mm_set1_ps(planes[p][2]), vz));
+			dist = _mm_add_ps(dist, _mm_set1_ps(planes[p][3]));
+			mask = _mm_and_ps(mask, _mm_cmpge_ps(dist, negRadius));
+		}
+		int bits = _mm_movemask_ps(mask);
+		for (unsigned int j = 0; j < 4; j++)
+		{
+			uint8_t v = static_cast<uint8_t>((bits >> j) & 1);
+			outInside[i + j] = v;
+			inside += v;
+		}
+	}
+#elif defined(MATH_NEON)
+	for (; i + 4 <= count; i += 4)
+	{
+		float32x4_t vx = vld1q_f32(x + i);
+		float32x4_t vy = vld1q_f32(y + i);
+		float32x4_t vz = vld1q_f32(z + i);
+		float32x4_t negRadius = vnegq_f32(vld1q_f32(radius + i));
+		uint32x4_t mask = vceqq_f32(vx, vx);
+		for (unsigned int p = 0; p < numPlanes; p++)
+		{
+			float32x4_t dist = vmulq_n_f32(vx, planes[p][0]);
+			dist = vaddq_f32(dist, vmulq_n_f32(vy, planes[p][1]));
+			dist = vaddq_f32(dist, vmulq_n_f32(vz, planes[p][2]));
+			dist = vaddq_f32(dist, vdupq_n_f32(planes[p][3]));
+			mask = vandq_u32(mask, vcgeq_f32(dist, negRadius));
+		}
+		uint32_t lanes[4];
+		vst1q_u32(lanes, mask);
+		for (unsigned int j = 0; j < 4; j++)
+		{
+			uint8_t v = lanes[j] ? 1 : 0;
+			outInside[i + j] = v;
+			inside += v;
+		}
+	}
+#endif
+	for (; i < count; i++)
+	{
+		uint8_t v = 1;
+		for (unsigned int p = 0; p < numPlanes; p++)
+		{
+			float dist = planes[p][0] * x[i] + planes[p][1] * y[i] + planes[p][2] * z[i] + planes[p][3];
+			if (dist < -radius[i])
+			{
+				v = 0;
+				break;
+			}
+		}
+		outInside[i] = v;
+		inside += v;
+	}
+	return inside;
+}
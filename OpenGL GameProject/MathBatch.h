@@ -0,0 +1,71 @@
+#pragma once
+#include<cstddef>
+#include<cstdint>
+#include<new>
+#include<vector>
+#include"Math.h"
+
+// Kernels over arrays of points, matrices and spheres. Inputs are one
+// array per component (structure of arrays) so the SIMD paths load four
+// (eight with AVX) elements per instruction. Every kernel gives the same
+// result as looping over the matching one-at-a-time function in Math.h.
+namespace MathBatch
+{
+	// Alignment of AlignedArray storage, one AVX register
+	const size_t Alignment = 32;
+
+	// Allocator for SoA arrays that start on an Alignment boundary.
+	// Kernels accept any pointer, aligned arrays just never split a load
+	// across cache lines.
+	template<typename T>
+	class AlignedAllocator
+	{
+	public:
+		typedef T value_type;
+
+		AlignedAllocator() {}
+		template<typename U>
+		AlignedAllocator(const AlignedAllocator<U>&) {}
+
+		T* allocate(size_t count)
+		{
+			// Room to align, plus the raw pointer just before the aligned one
+			void* raw = ::operator new(count * sizeof(T) + Alignment + sizeof(void*));
+			uintptr_t start = reinterpret_cast<uintptr_t>(raw) + sizeof(void*);
+			uintptr_t aligned = (start + Alignment - 1) & ~static_cast<uintptr_t>(Alignment - 1);
+			reinterpret_cast<void**>(aligned)[-1] = raw;
+			return reinterpret_cast<T*>(aligned);
+		}
+		void deallocate(T* ptr, size_t)
+		{
+			::operator delete(reinterpret_cast<void**>(ptr)[-1]);
+		}
+
+		template<typename U>
+		bool operator==(const AlignedAllocator<U>&) const { return true; }
+		template<typename U>
+		bool operator!=(const AlignedAllocator<U>&) const { return false; }
+	};
+
+	typedef std::vector<float, AlignedAllocator<float>> FloatArray;
+
+	// out = (x, y, z, 1) * mat for count points, as Vector3::Transform.
+	// Outputs may be the inputs.
+	void TransformPoints(const float* x, const float* y, const float* z, size_t count,
+		const Matrix4& mat, float* outX, float* outY, float* outZ);
+
+	// out[i] = a[i] * b, e.g. world transforms times the view-projection.
+	// out may be a.
+	void MultiplyMatrices(const Matrix4* a, size_t count, const Matrix4& b, Matrix4* out);
+
+	// Rotation matrices of count quaternions, as Matrix4::CreateFromQuaternion
+	void QuaternionsToMatrices(const float* x, const float* y, const float* z, const float* w,
+		size_t count, Matrix4* out);
+
+	// Test count spheres against numPlanes planes (a, b, c, d with unit
+	// normals, inside where a*x + b*y + c*z + d >= 0). Writes 1 for each
+	// sphere touching the inside of every plane and 0 otherwise, returns
+	// the number of 1s.
+	size_t SpheresInsidePlanes(const float* x, const float* y, const float* z, const float* radius,
+		size_t count, const float(*planes)[4], unsigned int numPlanes, uint8_t* outInside);
+}
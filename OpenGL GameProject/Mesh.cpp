@@ -1,26 +1,31 @@
-#include<fstream>
-#include<sstream>
-#include<stdio.h>
-#include<document.h>
 #include<SDL_log.h>
 #include"Mesh.h"
+#include"MeshData.h"
+#include"MeshFile.h"
+#include"MeshImporter.h"
 #include"Renderer.h"
 #include"Texture.h"
 #include"VertexArray.h"
 #include"Math.h"
+#include<mutex>
 
-namespace {
-	union Vertex
+namespace
+{
+	std::mutex FBXMutex;
+
+	bool HasExtension(const std::string& fileName, const char* ext)
 	{
-		float f;
-		Uint8 u[4];
-	};
+		std::string e(ext);
+		return fileName.size() >= e.size() &&
+			fileName.compare(fileName.size() - e.size(), e.size(), e) == 0;
+	}
 }
 
 Mesh::Mesh()
 	: mVertexArray(nullptr)
 	, mRadius(0.0f)
 	, mSpecPower(100.0f)
+	, mVertexFormat(VertexFormat::EPosNormTex)
 {
 }
 
@@ -28,470 +33,205 @@ Mesh::~Mesh()
 {
 }
 
-bool Mesh::Load(const std::string& fileName, Renderer* renderer)
+size_t MeshSource::GetUploadSize() const
 {
-	std::ifstream file(fileName);
-	if (!file.is_open())
+	if (mIsCooked)
 	{
-		SDL_Log("File not found: Mesh %s", fileName.c_str());
-		return false;
+		const MeshFile::Header& header = mCooked.GetHeader();
+		return static_cast<size_t>(header.mNumVerts) * header.mVertexStride +
+			static_cast<size_t>(header.mNumIndices) * sizeof(uint32_t);
 	}
+	return static_cast<size_t>(mData.GetNumVerts()) * VertexEncoder::GetStride(mData.mVertexFormat) +
+		mData.mIndices.size() * sizeof(unsigned int);
+}
 
-	std::stringstream fileStream;
-	fileStream << file.rdbuf();
-	std::string contents = fileStream.str();
-	rapidjson::StringStream jsonStr(contents.c_str());
-	rapidjson::Document doc;
-	doc.ParseStream(jsonStr);
-
-	if (!doc.IsObject())
+bool Mesh::Decode(const std::string& fileName, MeshSource& outSource)
+{
+	// Cooked files are mapped as they are
+	if (HasExtension(fileName, MeshFile::Extension))
 	{
-		SDL_Log("Mesh %s is not valid json", fileName.c_str());
-		return false;
+		outSource.mIsCooked = outSource.mCooked.Open(fileName);
+		return outSource.mIsCooked;
 	}
-
-	int ver = doc["version"].GetInt();
-
-	// Check the version
-	if (ver != 1)
+	// Prefer the cooked version of the mesh when it is current
+	std::string cooked = MeshFile::GetCookedName(fileName);
+	if (MeshFile::IsUpToDate(cooked, fileName) && outSource.mCooked.Open(cooked))
 	{
-		SDL_Log("Mesh %s not version 1", fileName.c_str());
-		return false;
+		outSource.mIsCooked = true;
+		return true;
 	}
+	return MeshImporter::LoadGPMesh(fileName, outSource.mData);
+}
 
-	mShaderName = doc["shader"].GetString();
-
-	// Skip the vertex format/shader for now
-	// (This is changed in a later chapter's code)
-	size_t vertSize = 8;
-
-	// Load textures
-	const rapidjson::Value& textures = doc["textures"];
-	if (!textures.IsArray() || textures.Size() < 1)
+bool Mesh::DecodeFBX(const std::string& fileName, MeshSource& outSource)
+{
+	// Cooked sibling written by MeshCooker
+	std::string cooked = MeshFile::GetCookedName(fileName);
+	if (MeshFile::IsUpToDate(cooked, fileName) && outSource.mCooked.Open(cooked))
 	{
-		SDL_Log("Mesh %s has no textures, there should be at least one", fileName.c_str());
-		return false;
+		outSource.mIsCooked = true;
+		return true;
 	}
-
-	mSpecPower = static_cast<float>(doc["specularPower"].GetDouble());
-
-	for (rapidjson::SizeType i = 0; i < textures.Size(); i++)
+	// Cache keyed by the source's content hash
+	std::string cached = MeshFile::GetCacheName(fileName, MeshFile::CacheDirectory);
+	if (!cached.empty() && MeshFile::FileExists(cached) && outSource.mCooked.Open(cached))
 	{
-		// Is this texture already loaded?
-		std::string texName = textures[i].GetString();
-		Texture* t = renderer->GetTexture(texName);
-		if (t == nullptr)
-		{
-			// Try loading the texture
-			t = renderer->GetTexture(texName);
-			if (t == nullptr)
-			{
-				// If it's still null, just use the default texture
-				t = renderer->GetTexture("Assets/Default.png");
-			}
-		}
-		mTextures.emplace_back(t);
+		outSource.mIsCooked = true;
+		return true;
 	}
-
-	// Load in the vertices
-	const rapidjson::Value& vertsJson = doc["vertices"];
-	if (!vertsJson.IsArray() || vertsJson.Size() < 1)
+	// Cache miss: import through the FBX SDK and cook for next time
+	if (!cached.empty() && !MeshFile::MakeDirectory(MeshFile::CacheDirectory))
 	{
-		SDL_Log("Mesh %s has no vertices", fileName.c_str());
-		return false;
+		cached.clear();
 	}
-
-	std::vector<float> vertices;
-	vertices.reserve(vertsJson.Size() * vertSize);
-	mRadius = 0.0f;
-	for (rapidjson::SizeType i = 0; i < vertsJson.Size(); i++)
 	{
-		// For now, just assume we have 8 elements
-		const rapidjson::Value& vert = vertsJson[i];
-		if (!vert.IsArray() || vert.Size() != 8)
+		// The FBX SDK isn't safe to use from several threads at once
+		std::lock_guard<std::mutex> lock(FBXMutex);
+		MeshImporter importer;
+		if (!importer.LoadFBX(fileName, outSource.mData))
 		{
-			SDL_Log("Unexpected vertex format for %s", fileName.c_str());
 			return false;
 		}
-
-		Vector3 pos(vert[0].GetDouble(), vert[1].GetDouble(), vert[2].GetDouble());
-		mRadius = Math::Max(mRadius, pos.LengthSq());
-
-		// Add the floats
-		for (rapidjson::SizeType i = 0; i < vert.Size(); i++)
-		{
-			vertices.emplace_back(static_cast<float>(vert[i].GetDouble()));
-		}
-	}
-
-	// We were computing length squared earlier
-	mRadius = Math::Sqrt(mRadius);
-
-	// Load in the indices
-	const rapidjson::Value& indJson = doc["indices"];
-	if (!indJson.IsArray() || indJson.Size() < 1)
-	{
-		SDL_Log("Mesh %s has no indices", fileName.c_str());
-		return false;
 	}
-
-	std::vector<unsigned int> indices;
-	indices.reserve(indJson.Size() * 3);
-	for (rapidjson::SizeType i = 0; i < indJson.Size(); i++)
+	if (!cached.empty())
 	{
-		const rapidjson::Value& ind = indJson[i];
-		if (!ind.IsArray() || ind.Size() != 3)
-		{
-			SDL_Log("Invalid indices for %s", fileName.c_str());
-			return false;
-		}
-
-		indices.emplace_back(ind[0].GetUint());
-		indices.emplace_back(ind[1].GetUint());
-		indices.emplace_back(ind[2].GetUint());
+		// A failed write only costs the next load another import
+		MeshFile::Write(outSource.mData, cached);
 	}
-
-	// Now create a vertex array
-	mVertexArray = new VertexArray(vertices.data(), static_cast<unsigned>(vertices.size()) / vertSize,
-		indices.data(), static_cast<unsigned>(indices.size()));
-	vertexArray.emplace_back(mVertexArray);//Put mVertexArray to new Array for loading FBX
 	return true;
 }
 
-bool Mesh::LoadFBX(const char* fileName, Renderer* renderer)
+bool Mesh::Create(const MeshSource& source, const std::string& name, Renderer* renderer, bool asyncTextures)
 {
-	//Initialize manager
-	fbxsdk::FbxManager* fbxManager = fbxsdk::FbxManager::Create();
-	FbxIOSettings* fbxIOS = FbxIOSettings::Create(fbxManager, IOSROOT);
-
-	//Initialize importer
-	FbxImporter* fbxImporter = FbxImporter::Create(fbxManager, "");
-	if (!fbxImporter->Initialize(fileName, -1, fbxManager->GetIOSettings()))
+	if (source.mIsCooked)
 	{
-		fbxManager->Destroy();
-		return false;
-	}
-
-	//Initialize scene
-	FbxScene* fbxScene = FbxScene::Create(fbxManager, "scene");
-	fbxImporter->Import(fbxScene);
-	fbxImporter->Destroy();
-
-	FbxGeometryConverter geometryConverter(fbxManager);
-	geometryConverter.Triangulate(fbxScene, true);
-
-	//Root Node
-	FbxNode* root = fbxScene->GetRootNode();
-
-	//Show
-	if (root != 0) PrintName(root, 0);
-	if (root)
-	{
-		int childCount = root->GetChildCount();
-		for (int i = 0; i < childCount; i++)
+		if (!CreateFromCooked(source.mCooked, name))
 		{
-			GetMesh(root->GetChild(i), renderer);
+			return false;
 		}
-	}
-	fbxManager->Destroy();
-
-	return true;
-}
-
-void Mesh::GetMesh(FbxNode* node, Renderer* renderer)
-{
-	FbxNodeAttribute* attribute = node->GetNodeAttribute();
-	if (attribute)
-	{
-		FbxNodeAttribute::EType type = attribute->GetAttributeType();
-		switch (type)
+		for (uint32_t i = 0; i < source.mCooked.GetHeader().mNumTextures; i++)
 		{
-		case FbxNodeAttribute::eMesh:
-
-			FbxMesh* mesh = node->GetMesh();
-			GetPosition(mesh);
-			GetNormal(mesh);
-			GetUV(mesh);
-			GetTexture(mesh, renderer);
-			break;
+			mTextures.emplace_back(LoadTexture(source.mCooked.GetTexture(i), renderer, asyncTextures));
 		}
+		return true;
 	}
 
-	for (int i = 0; i < indices.size(); i++)
+	if (!CreateFromData(source.mData, name))
 	{
-		//Position
-		Vertex vertex;
-		vertices.emplace_back(positions[indices[i]].x);
-		vertices.emplace_back(positions[indices[i]].y);
-		vertices.emplace_back(positions[indices[i]].z);
-
-		//Normal
-		vertices.emplace_back(normals[indices[i]].x);
-		vertices.emplace_back(normals[indices[i]].y);
-		vertices.emplace_back(normals[indices[i]].z);
-
-		//UV
-		if (uvs.size() == indices.size())
-		{
-			vertices.emplace_back(uvs[i].x);
-			vertices.emplace_back(uvs[i].y);
-		}
-		else
-		{
-			vertices.emplace_back(0.0f);
-			vertices.emplace_back(0.0f);
-		}
-
-		indices[i] = i;
+		return false;
 	}
-
-	if (vertices.size() == 0)
+	for (const auto& tex : source.mData.mTextures)
 	{
-		return;
+		mTextures.emplace_back(LoadTexture(tex, renderer, asyncTextures));
 	}
+	return true;
+}
 
-	if (mTextures.size() == 0)
+bool Mesh::CreateFromCooked(const MeshFile& file, const std::string& name)
+{
+	const MeshFile::Header& header = file.GetHeader();
+	if (header.mNumSubMeshes == 0 || header.mNumTextures == 0)
 	{
-		mTextures.emplace_back(renderer->GetTexture("Texture/none.png"));
+		SDL_Log("Cooked mesh %s is empty", name.c_str());
+		return false;
 	}
 
-	mVertexArray = new VertexArray(vertices.data(),
-		static_cast<unsigned>(vertices.size()) / 8.0f,
-		indices.data(), static_cast<unsigned>(indices.size()));
-	vertexArray.emplace_back(mVertexArray);
+	mShaderName = file.GetShaderName();
+	mRadius = header.mRadius;
+	mSpecPower = header.mSpecPower;
 
-	vertices.clear();
-	indices.clear();
-	positions.clear();
-	normals.clear();
-	uvs.clear();
-
-	int childCount = node->GetChildCount();
-	for (int i = 0; i < childCount; i++)
+	// The mapped blocks are uploaded as they are
+	mVertexFormat = file.GetVertexFormat();
+	mQuantization = file.GetQuantization();
+	for (uint32_t i = 0; i < header.mNumSubMeshes; i++)
 	{
-		GetMesh(node->GetChild(i), renderer);
+		const MeshFile::SubMesh& sm = file.GetSubMesh(i);
+		mVertexArray = new VertexArray(file.GetVertices() + sm.mVertexOffset * header.mVertexStride, sm.mNumVerts,
+			mVertexFormat, file.GetIndices() + sm.mIndexOffset, sm.mNumIndices);
+		vertexArray.emplace_back(mVertexArray);
+		mSubMeshTextures.emplace_back(sm.mTextureIndex);
 	}
+	return true;
 }
 
-void Mesh::GetPosition(FbxMesh* mesh)
+bool Mesh::CreateFromData(const MeshData& data, const std::string& name)
 {
-	for (int i = 0; i < mesh->GetPolygonCount() * 3; i++)
+	mShaderName = data.mShaderName;
+	mRadius = data.mRadius;
+	mSpecPower = data.mSpecPower;
+
+	// Encode once for the whole mesh so sub meshes share the quantization
+	mVertexFormat = data.mVertexFormat;
+	std::vector<unsigned char> verts;
+	VertexEncoder::Encode(data.mVertices.data(), data.GetNumVerts(), mVertexFormat, verts, mQuantization);
+	if (mVertexFormat != VertexFormat::EPosNormTex)
 	{
-		indices.emplace_back(mesh->GetPolygonVertices()[i]);
+		VertexEncoder::LogError(name, data.mVertices.data(), data.GetNumVerts(),
+			mVertexFormat, verts.data(), mQuantization);
 	}
 
-	FbxVector4* vertex = mesh->GetControlPoints();
-	for (int i = 0; i < mesh->GetControlPointsCount(); i++)
+	unsigned int stride = VertexEncoder::GetStride(mVertexFormat);
+	for (const auto& sm : data.mSubMeshes)
 	{
-		//position
-		Vector3 p;
-		p.x = (float)vertex[i][0];//X
-		p.y = (float)vertex[i][1];//Y
-		p.z = (float)vertex[i][2];//Z
-		positions.emplace_back(p);
-
-		mRadius = Math::Max(mRadius, p.LengthSq());
+		mVertexArray = new VertexArray(verts.data() + sm.mVertexOffset * stride, sm.mNumVerts,
+			mVertexFormat, data.mIndices.data() + sm.mIndexOffset, sm.mNumIndices);
+		vertexArray.emplace_back(mVertexArray);//Put mVertexArray to new Array for loading FBX
+		mSubMeshTextures.emplace_back(sm.mTextureIndex);
 	}
+	return !vertexArray.empty();
 }
 
-void Mesh::GetNormal(FbxMesh* _mesh)
+Texture* Mesh::LoadTexture(const std::string& fileName, Renderer* renderer, bool async)
 {
-	//Normals
-	for (int i = 0; i < _mesh->GetElementNormalCount(); i++)
+	// Asynchronous textures show a placeholder until they are decoded
+	if (async)
 	{
-		FbxGeometryElementNormal* normal = _mesh->GetElementNormal(i);
-
-		FbxGeometryElement::EMappingMode mapping_mode = normal->GetMappingMode();		//Mapping Mode
-		FbxGeometryElement::EReferenceMode reference_mode = normal->GetReferenceMode();	//References Mode
-
-		if (mapping_mode == FbxGeometryElement::eByControlPoint ||
-			mapping_mode == FbxGeometryElement::eByPolygonVertex)
-		{
-			if (reference_mode == FbxGeometryElement::eDirect)
-			{
-				for (int j = 0; j < normal->GetDirectArray().GetCount(); j++)
-				{
-					Vector3 n;
-					n.x = (float)normal->GetDirectArray().GetAt(j)[0];
-					n.y = (float)normal->GetDirectArray().GetAt(j)[1];
-					n.z = (float)normal->GetDirectArray().GetAt(j)[2];
-					normals.emplace_back(n);
-				}
-			}
-		}
-		/*else if(mapping_mode == FbxGeometryElement::eByControlPoint)
-		{
-			if (reference_mode == FbxGeometryElement::eDirect)
-			{
-				for (int j = 0; j < normal->GetDirectArray().GetCount(); j++)
-				{
-					Vertex v;
-					v.normal.x = (float)normal->GetDirectArray().GetAt(i)[0];
-					v.normal.y = (float)normal->GetDirectArray().GetAt(i)[1];
-					v.normal.z = (float)normal->GetDirectArray().GetAt(i)[2];
-					vertices.emplace_back(v);
-				}
-			}
-		}*/
-
+		return renderer->GetTextureAsync(fileName);
 	}
-}
-
-void Mesh::GetUV(FbxMesh* mesh)
-{
-	for (int i = 0; i < mesh->GetElementUVCount(); i++)
+	// Is this texture already loaded?
+	Texture* t = renderer->GetTexture(fileName);
+	if (t == nullptr)
 	{
-		FbxGeometryElementUV* uv = mesh->GetElementUV(i);
-
-		FbxGeometryElement::EMappingMode mappingMode = uv->GetMappingMode(); //Mapping Mode
-		FbxGeometryElement::EReferenceMode referenceMode = uv->GetReferenceMode();	//References Mode
-
-		uv->GetName();
-
-		if (mappingMode == FbxGeometryElement::eByPolygonVertex)
-		{
-			if (referenceMode == FbxGeometryElement::eDirect)
-			{
-				for (int j = 0; j < uv->GetDirectArray().GetCount(); j++)
-				{
-					Vector2 vec2UV;
-					vec2UV.x = (float)uv->GetDirectArray().GetAt(i)[0];
-					vec2UV.y = (float)uv->GetDirectArray().GetAt(i)[1];
-					uvs.emplace_back(vec2UV);
-				}
-			}
-			else if (referenceMode == FbxGeometryElement::eIndexToDirect)
-			{
-				for (int j = 0; j < uv->GetIndexArray().GetCount(); j++)
-				{
-					int index = uv->GetIndexArray().GetAt(i);
-
-					Vector2 vec2UV;
-					vec2UV.x = (float)uv->GetDirectArray().GetAt(index)[0];
-					vec2UV.y = (float)uv->GetDirectArray().GetAt(index)[1];
-					uvs.emplace_back(vec2UV);
-				}
-			}
-		}
+		// If it's still null, just use the default texture
+		t = renderer->GetTexture("Assets/Default.png");
 	}
+	return t;
 }
 
-void Mesh::GetTexture(FbxMesh* _mesh, Renderer* _renderer)
+void Mesh::Unload()
 {
-	FbxNode* node = _mesh->GetNode();
-
-	for (int i = 0; i < node->GetMaterialCount(); i++)
+	for (auto va : vertexArray)
 	{
-		FbxSurfaceMaterial* fbxMaterial = node->GetMaterial(i);//Material
-		FbxProperty fbxProperty = fbxMaterial->FindProperty(FbxSurfaceMaterial::sDiffuse);
-
-		for (int j = 0; j < fbxProperty.GetSrcObjectCount<FbxFileTexture>(); j++)
-		{
-			FbxFileTexture* texture = fbxProperty.GetSrcObject<FbxFileTexture>(j);
-			if (texture)
-			{
-				std::string textureName = texture->GetRelativeFileName();
-
-				std::string uvSetName = texture->UVSet.Get().Buffer();
-				if (uvName == uvSetName)
-				{
-					Texture* texture = _renderer->GetTexture(textureName);
-					if (texture == nullptr)
-					{
-						texture = _renderer->GetTexture("Texture/none.png");//Default
-					}
-					mTextures.emplace_back(texture);
-				}
-			}
-		}
+		delete va;
 	}
+	vertexArray.clear();
+	mSubMeshTextures.clear();
+	mVertexArray = nullptr;
 }
 
-void Mesh::PrintName(FbxNode* node, int indent)
+Texture* Mesh::GetTexture(size_t index)
 {
-	for (int i = 0; i < indent; i++)
-	{
-		printf("");
-	}
-
-	const char* eTypeNames[] =
-	{
-		"eUnknown",
-		"eNull",
-		"eMarker",
-		"eSkeleton",
-		"eMesh",
-		"eNurbs",
-		"ePatch",
-		"eCamera",
-		"eCameraStereo",
-		"eCameraSwitcher",
-		"eLight",
-		"eOpticalReference",
-		"eOpticalMarker",
-		"eNurbsCurve",
-		"eTrimNurbsSurface",
-		"eBoundary",
-		"eNurbsSurface",
-		"eShape",
-		"eLODGroup",
-		"eSubDiv",
-		"eCachedEffect",
-		"eLine"
-	};
-
-	const char* name = node->GetName();
-
-	int attributeCount = node->GetNodeAttributeCount();
-	if (attributeCount == 0)
+	if (index < mTextures.size())
 	{
-		printf("%s\n", name);
+		return mTextures[index];
 	}
 	else
 	{
-		printf("%s (", name);
-	}
-	for (int i = 0; i < attributeCount; ++i)
-	{
-		FbxNodeAttribute* attribute = node->GetNodeAttributeByIndex(i);
-		FbxNodeAttribute::EType type = attribute->GetAttributeType();
-
-		printf("%s", eTypeNames[type]);
-		if (i + 1 == attributeCount)
-		{
-			printf(")\n");
-		}
-		else
-		{
-			printf(", ");
-		}
-	}
-
-	int childCount = node->GetChildCount();
-	for (int i = 0; i < childCount; i++)
-	{
-		PrintName(node->GetChild(i), indent + 1);
+		return nullptr;
 	}
 }
 
-void Mesh::Unload()
+Texture* Mesh::GetSubMeshTexture(size_t subMesh)
 {
-	//delete mVertexArray;
-	//mVertexArray = nullptr;
-	while (!vertices.empty())
+	if (subMesh < mSubMeshTextures.size() && mSubMeshTextures[subMesh] >= 0)
 	{
-		delete vertexArray.back();
+		return GetTexture(static_cast<size_t>(mSubMeshTextures[subMesh]));
 	}
+	return nullptr;
 }
 
-Texture* Mesh::GetTexture(size_t index)
+Texture* Mesh::GetDrawTexture(size_t subMesh, size_t textureIndex)
 {
-	if (index < mTextures.size())
-	{
-		return mTextures[index];
-	}
-	else
-	{
-		return nullptr;
-	}
+	Texture* t = GetSubMeshTexture(subMesh);
+	return t ? t : GetTexture(textureIndex);
 }
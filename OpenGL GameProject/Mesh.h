@@ -1,45 +1,68 @@
 #pragma once
 #include<string>
 #include<vector>
-#include<fbxsdk.h>
 #include"Math.h"
+#include"MeshData.h"
+#include"MeshFile.h"
 #include"VertexArray.h"
 
+// CPU side of loading a mesh: a mapped cooked file, or imported data
+// still to encode. Decoded on any thread, Mesh::Create uploads it.
+struct MeshSource
+{
+	MeshFile mCooked;
+	MeshData mData;
+	bool mIsCooked = false;
+
+	// Vertex and index bytes Create uploads
+	size_t GetUploadSize() const;
+};
+
 class Mesh
 {
 public:
 	Mesh();
 	~Mesh();
-	//Load/Unload  Mesh
-	bool Load(const std::string& fileName, class Renderer* renderer);
-	bool LoadFBX(const char* fileName, class Renderer* renderer);
+	//Read a .gpmesh json or cooked .gpbin file, preferring the cooked
+	//sibling of a .gpmesh when it is current (no GL calls, any thread)
+	static bool Decode(const std::string& fileName, MeshSource& outSource);
+	//Same for an FBX file: cooked sibling, then the content hash cache,
+	//then an FBX SDK import that is cooked into the cache for next time
+	static bool DecodeFBX(const std::string& fileName, MeshSource& outSource);
+	//Create vertex arrays/textures from a decoded mesh (render thread).
+	//asyncTextures loads the textures through Renderer::GetTextureAsync
+	bool Create(const MeshSource& source, const std::string& name, class Renderer* renderer,
+		bool asyncTextures = false);
 	void Unload();
 	//
-	std::vector<VertexArray*> GetVertexArray() { return vertexArray; }
+	const std::vector<VertexArray*>& GetVertexArray() const { return vertexArray; }
 	//Get texture from index
 	class Texture* GetTexture(size_t index);
+	//Get texture bound to a sub mesh (nullptr if it has no material)
+	class Texture* GetSubMeshTexture(size_t subMesh);
+	//Get texture to draw a sub mesh with: its own material, otherwise textureIndex
+	class Texture* GetDrawTexture(size_t subMesh, size_t textureIndex);
 	//Get shader name
 	const std::string& GetShaderName() const { return mShaderName; }
 	//// Get object space bounding sphere radius
 	float GetRadius()const { return mRadius; }
 	// Get specular power of mesh
 	float GetSpecPower() const { return mSpecPower; }
+	// Get vertex encoding shared by all vertex arrays
+	VertexFormat GetVertexFormat() const { return mVertexFormat; }
+	// Get scale/offset mapping normalized vertex attributes back to mesh space
+	const VertexQuantization& GetQuantization() const { return mQuantization; }
 private:
-	void GetMesh(FbxNode* node, Renderer* renderer);
-	void GetPosition(FbxMesh* mesh);
-	void GetNormal(FbxMesh* mesh);
-	void GetUV(FbxMesh* mesh);
-	void GetTexture(FbxMesh* mesh, Renderer* renderer);
-
-	void PrintName(FbxNode* node, int indent);
+	//Upload a mapped cooked mesh's blocks without parsing
+	bool CreateFromCooked(const MeshFile& file, const std::string& name);
+	//Encode and upload imported data
+	bool CreateFromData(const MeshData& data, const std::string& name);
+	//Resolve a texture name, falling back to the default texture
+	class Texture* LoadTexture(const std::string& fileName, class Renderer* renderer, bool async);
 
 	std::vector<VertexArray*> vertexArray;
-	std::vector<float> vertices;
-	std::vector<unsigned int> indices;
-	std::vector<Vector3> positions;
-	std::vector<Vector3> normals;
-	std::vector<Vector2> uvs;
-	std::string uvName;
+	//Texture index bound to each vertex array (-1 for none)
+	std::vector<int> mSubMeshTextures;
 
 private:
 	//Group of Mesh Textures
@@ -52,5 +75,8 @@ private:
 	float mRadius;
 	// Specular power of surface
 	float mSpecPower;
+	// Vertex encoding and its dequantization
+	VertexFormat mVertexFormat;
+	VertexQuantization mQuantization;
 
 };
@@ -4,46 +4,98 @@
 #include"Actor.h"
 #include"Game.h"
 #include"Renderer.h"
-#include"Texture.h"
-#include"VertexArray.h"
-#include<vector>
+#include"AABBTree.h"
 
 MeshComponent::MeshComponent(Actor* owner)
 	:Component(owner)
 	, mMesh(nullptr)
 	, mTextureIndex(0)
+	, mProxy(AABBTree::NullNode)
 {
-	mOwner->GetGame()->GetRenderer()->AddMeshComp(this);
+	mRendererHandle = mOwner->GetGame()->GetRenderer()->AddMeshComp(this);
 }
 
 MeshComponent::~MeshComponent()
 {
-	mOwner->GetGame()->GetRenderer()->RemoveMeshComp(this);
+	if (mProxy != AABBTree::NullNode)
+	{
+		mOwner->GetGame()->GetSpatialTree()->DestroyProxy(mProxy);
+	}
+	mOwner->GetGame()->GetRenderer()->RemoveMeshComp(mRendererHandle);
+}
+
+void MeshComponent::SetMesh(Mesh* mesh)
+{
+	mMesh = mesh;
+	UpdateProxy();
+}
+
+bool MeshComponent::GetWorldSphere(Vector3& outCenter, float& outRadius) const
+{
+	if (!mMesh)
+	{
+		return false;
+	}
+	// Object space radius scaled by the largest axis of the world transform
+	const Matrix4& world = mOwner->GetWorldTransform();
+	Vector3 scale = world.GetScale();
+	outCenter = world.GetTranslation();
+	outRadius = mMesh->GetRadius() * Math::Max(scale.x, Math::Max(scale.y, scale.z));
+	return true;
+}
+
+void MeshComponent::OnUpdateWorldTransform()
+{
+	UpdateProxy();
 }
 
-void MeshComponent::Draw(Shader* shader)
+void MeshComponent::UpdateProxy()
 {
-	if (mMesh)
+	AABBTree* tree = mOwner->GetGame()->GetSpatialTree();
+	Vector3 center;
+	float radius;
+	if (!GetWorldSphere(center, radius))
 	{
-		// Set the world transform
-		shader->SetMatrixUniform("uWorldTransform",
-			mOwner->GetWorldTransform());
-		// Set specular power
-		shader->SetFloatUniform("uSpecPower", mMesh->GetSpecPower());
-		// Set the active texture
-		Texture* t = mMesh->GetTexture(mTextureIndex);
-		if (t)
+		if (mProxy != AABBTree::NullNode)
 		{
-			t->SetActive();
+			tree->DestroyProxy(mProxy);
+			mProxy = AABBTree::NullNode;
 		}
-		// Set the mesh's vertex array as active
-		std::vector<VertexArray*> va = mMesh->GetVertexArray();
-		for (auto v : va)
-		{
-			v->SetActive();
-			// Draw
-			glDrawElements(GL_TRIANGLES, v->GetNumIndices(), GL_UNSIGNED_INT, nullptr);
-		}		
-		
+		return;
+	}
+
+	AABB box = AABB::FromSphere(center, radius);
+	if (mProxy == AABBTree::NullNode)
+	{
+		mProxy = tree->CreateProxy(box, this);
 	}
-}
\ No newline at end of file
+	else
+	{
+		tree->MoveProxy(mProxy, box);
+	}
+}
+
+void MeshComponent::Uniforms::Resolve(Shader* shader)
+{
+	mWorldTransform = shader->GetUniform<Matrix4>("uWorldTransform");
+	mSpecPower = shader->GetUniform<float>("uSpecPower");
+	mPosScale = shader->GetUniform<Vector3>("uPosScale");
+	mPosOffset = shader->GetUniform<Vector3>("uPosOffset");
+	mUVScale = shader->GetUniform<Vector2>("uUVScale");
+	mUVOffset = shader->GetUniform<Vector2>("uUVOffset");
+	mOctNormals = shader->GetUniform<float>("uOctNormals");
+}
+
+void MeshComponent::SetMeshUniforms(Shader* shader, const Uniforms& uniforms, Mesh* mesh)
+{
+	// Set specular power
+	shader->SetUniform(uniforms.mSpecPower, mesh->GetSpecPower());
+	// Set how the vertex attributes are decoded
+	const VertexQuantization& quant = mesh->GetQuantization();
+	shader->SetUniform(uniforms.mPosScale, quant.mPosScale);
+	shader->SetUniform(uniforms.mPosOffset, quant.mPosOffset);
+	shader->SetUniform(uniforms.mUVScale, quant.mUVScale);
+	shader->SetUniform(uniforms.mUVOffset, quant.mUVOffset);
+	shader->SetUniform(uniforms.mOctNormals,
+		VertexEncoder::HasOctNormals(mesh->GetVertexFormat()) ? 1.0f : 0.0f);
+}
@@ -1,18 +1,52 @@
 #pragma once
 #include"Component.h"
 #include<cstddef>
+#include"Shader.h"
+#include"SlotMap.h"
 
 class MeshComponent : public Component
 {
 public:
 	MeshComponent(class Actor* owner);
 	~MeshComponent();
-	// Draw this mesh component
-	virtual void Draw(class Shader* shader);
+	// Uniforms set when drawing, resolved once per shader
+	struct Uniforms
+	{
+		UniformHandle<Matrix4> mWorldTransform;
+		UniformHandle<float> mSpecPower;
+		UniformHandle<Vector3> mPosScale;
+		UniformHandle<Vector3> mPosOffset;
+		UniformHandle<Vector2> mUVScale;
+		UniformHandle<Vector2> mUVOffset;
+		UniformHandle<float> mOctNormals;
+
+		void Resolve(Shader* shader);
+	};
+
+	// Set the uniforms shared by every component drawing mesh
+	// (all but the world transform)
+	static void SetMeshUniforms(Shader* shader, const Uniforms& uniforms, class Mesh* mesh);
+
 	// Set the mesh/texture index used by mesh component
-	virtual void SetMesh(class Mesh* mesh) { mMesh = mesh; }
+	// (registers the component with the game's spatial tree)
+	virtual void SetMesh(class Mesh* mesh);
 	void SetTextureIndex(size_t index) { mTextureIndex = index; }
+	class Mesh* GetMesh() const { return mMesh; }
+	size_t GetTextureIndex() const { return mTextureIndex; }
+
+	// World space bounding sphere of the mesh, false without a mesh
+	bool GetWorldSphere(Vector3& outCenter, float& outRadius) const;
+	// Refit the spatial tree proxy
+	void OnUpdateWorldTransform() override;
+	// Nothing to update
+	ComponentAccess GetAccess() const override { return ComponentAccess::None(); }
 protected:
+	void UpdateProxy();
+
 	class Mesh* mMesh;
 	size_t mTextureIndex;
+	// Proxy in the game's AABBTree (AABBTree::NullNode without a mesh)
+	int mProxy;
+	// Entry in the renderer's mesh components
+	SlotHandle mRendererHandle;
 };
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+#include<string>
+#include<vector>
+#include"VertexFormat.h"
+
+// Range of a mesh drawn with one vertex array
+struct SubMeshData
+{
+	// First vertex/index of this sub mesh inside MeshData
+	unsigned int mVertexOffset = 0;
+	unsigned int mNumVerts = 0;
+	unsigned int mIndexOffset = 0;
+	unsigned int mNumIndices = 0;
+	// Texture bound to this sub mesh (-1 uses the mesh component's texture)
+	int mTextureIndex = -1;
+};
+
+// CPU side description of a mesh, shared by the importers,
+// the cooked mesh writer and Mesh
+struct MeshData
+{
+	// Floats per vertex (position 3, normal 3, uv 2)
+	static const unsigned int VertexSize = 8;
+
+	std::string mShaderName;
+	// Encoding used for the vertex buffer (mVertices stay float)
+	VertexFormat mVertexFormat = VertexFormat::EPosNormTex;
+	std::vector<std::string> mTextures;
+	std::vector<SubMeshData> mSubMeshes;
+	// Indices are relative to the owning sub mesh's first vertex
+	std::vector<float> mVertices;
+	std::vector<unsigned int> mIndices;
+	float mRadius = 0.0f;
+	float mSpecPower = 100.0f;
+
+	unsigned int GetNumVerts() const { return static_cast<unsigned int>(mVertices.size() / VertexSize); }
+};
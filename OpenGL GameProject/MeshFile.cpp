@@ -0,0 +1,316 @@
+#include"MeshFile.h"
+#include"MeshData.h"
+#include<algorithm>
+#include<fstream>
+#include<vector>
+#include<cstring>
+#include<cstdio>
+#include<sys/stat.h>
+#ifdef _WIN32
+#include<direct.h>
+#endif
+#include<SDL_log.h>
+
+const char* MeshFile::Extension = ".gpbin";
+const char* MeshFile::CacheDirectory = "Cache";
+
+namespace
+{
+	const uint32_t BlockAlign = 16;
+
+	uint32_t AlignUp(uint32_t value)
+	{
+		return (value + BlockAlign - 1) & ~(BlockAlign - 1);
+	}
+
+	// Check that [offset, offset + size) lies inside the file
+	bool InFile(uint64_t offset, uint64_t size, size_t fileSize)
+	{
+		return offset % 4 == 0 && offset + size <= fileSize;
+	}
+}
+
+static_assert(sizeof(MeshFile::Header) % 16 == 0, "MeshFile header must keep blocks aligned");
+static_assert(sizeof(MeshFile::SubMesh) % 16 == 0, "MeshFile sub mesh must keep blocks aligned");
+
+MeshFile::MeshFile()
+	:mHeader(nullptr)
+	, mSubMeshes(nullptr)
+	, mTextures(nullptr)
+	, mVertices(nullptr)
+	, mIndices(nullptr)
+	, mStrings(nullptr)
+{
+}
+
+MeshFile::~MeshFile()
+{
+	Close();
+}
+
+bool MeshFile::Open(const std::string& fileName)
+{
+	Close();
+	if (!mFile.Open(fileName))
+	{
+		SDL_Log("File not found: Cooked mesh %s", fileName.c_str());
+		return false;
+	}
+
+	const unsigned char* data = mFile.GetData();
+	size_t size = mFile.GetSize();
+	if (size < sizeof(Header))
+	{
+		SDL_Log("Cooked mesh %s is truncated", fileName.c_str());
+		Close();
+		return false;
+	}
+
+	const Header* header = reinterpret_cast<const Header*>(data);
+	if (header->mMagic != Magic || header->mVersion != Version)
+	{
+		SDL_Log("Cooked mesh %s is not version %u", fileName.c_str(), Version);
+		Close();
+		return false;
+	}
+
+	if (header->mVertexFormat >= static_cast<uint32_t>(VertexFormat::ECount) ||
+		header->mVertexStride != VertexEncoder::GetStride(static_cast<VertexFormat>(header->mVertexFormat)) ||
+		!InFile(header->mSubMeshOffset, uint64_t(header->mNumSubMeshes) * sizeof(SubMesh), size) ||
+		!InFile(header->mTextureOffset, uint64_t(header->mNumTextures) * sizeof(String), size) ||
+		!InFile(header->mVertexOffset, uint64_t(header->mNumVerts) * header->mVertexStride, size) ||
+		!InFile(header->mIndexOffset, uint64_t(header->mNumIndices) * sizeof(uint32_t), size) ||
+		uint64_t(header->mStringOffset) + header->mStringSize > size)
+	{
+		SDL_Log("Cooked mesh %s has an invalid layout", fileName.c_str());
+		Close();
+		return false;
+	}
+
+	mHeader = header;
+	mSubMeshes = reinterpret_cast<const SubMesh*>(data + header->mSubMeshOffset);
+	mTextures = reinterpret_cast<const String*>(data + header->mTextureOffset);
+	mVertices = data + header->mVertexOffset;
+	mIndices = reinterpret_cast<const uint32_t*>(data + header->mIndexOffset);
+	mStrings = reinterpret_cast<const char*>(data + header->mStringOffset);
+
+	// Every sub mesh must reference data inside the blocks
+	for (uint32_t i = 0; i < header->mNumSubMeshes; i++)
+	{
+		const SubMesh& sm = mSubMeshes[i];
+		if (uint64_t(sm.mVertexOffset) + sm.mNumVerts > header->mNumVerts ||
+			uint64_t(sm.mIndexOffset) + sm.mNumIndices > header->mNumIndices ||
+			sm.mTextureIndex >= static_cast<int32_t>(header->mNumTextures))
+		{
+			SDL_Log("Cooked mesh %s has an invalid sub mesh", fileName.c_str());
+			Close();
+			return false;
+		}
+		// Indices are relative to the sub mesh's vertices, which is all
+		// the GPU gets
+		const uint32_t* indices = mIndices + sm.mIndexOffset;
+		if (std::any_of(indices, indices + sm.mNumIndices, [&sm](uint32_t index) { return index >= sm.mNumVerts; }))
+		{
+			SDL_Log("Cooked mesh %s has indices past its vertices", fileName.c_str());
+			Close();
+			return false;
+		}
+	}
+	return true;
+}
+
+void MeshFile::Close()
+{
+	mFile.Close();
+	mHeader = nullptr;
+	mSubMeshes = nullptr;
+	mTextures = nullptr;
+	mVertices = nullptr;
+	mIndices = nullptr;
+	mStrings = nullptr;
+}
+
+VertexQuantization MeshFile::GetQuantization() const
+{
+	VertexQuantization quant;
+	quant.mPosScale = Vector3(mHeader->mPosScale[0], mHeader->mPosScale[1], mHeader->mPosScale[2]);
+	quant.mPosOffset = Vector3(mHeader->mPosOffset[0], mHeader->mPosOffset[1], mHeader->mPosOffset[2]);
+	quant.mUVScale = Vector2(mHeader->mUVScale[0], mHeader->mUVScale[1]);
+	quant.mUVOffset = Vector2(mHeader->mUVOffset[0], mHeader->mUVOffset[1]);
+	return quant;
+}
+
+std::string MeshFile::GetString(const String& str) const
+{
+	if (uint64_t(str.mOffset) + str.mLength > mHeader->mStringSize)
+	{
+		return std::string();
+	}
+	return std::string(mStrings + str.mOffset, str.mLength);
+}
+
+bool MeshFile::Write(const MeshData& data, const std::string& fileName)
+{
+	// Gather strings
+	std::string strings;
+	auto addString = [&strings](const std::string& s)
+	{
+		String str;
+		str.mOffset = static_cast<uint32_t>(strings.size());
+		str.mLength = static_cast<uint32_t>(s.size());
+		strings += s;
+		strings.push_back('\0');
+		return str;
+	};
+
+	Header header;
+	memset(&header, 0, sizeof(header));
+	header.mMagic = Magic;
+	header.mVersion = Version;
+	header.mVertexFormat = static_cast<uint32_t>(data.mVertexFormat);
+	header.mVertexStride = VertexEncoder::GetStride(data.mVertexFormat);
+	header.mNumVerts = data.GetNumVerts();
+	header.mNumIndices = static_cast<uint32_t>(data.mIndices.size());
+	header.mNumSubMeshes = static_cast<uint32_t>(data.mSubMeshes.size());
+	header.mNumTextures = static_cast<uint32_t>(data.mTextures.size());
+	header.mRadius = data.mRadius;
+	header.mSpecPower = data.mSpecPower;
+	header.mShaderName = addString(data.mShaderName);
+
+	// Sub meshes share the quantization of the whole mesh
+	std::vector<unsigned char> vertices;
+	VertexQuantization quant;
+	VertexEncoder::Encode(data.mVertices.data(), data.GetNumVerts(), data.mVertexFormat, vertices, quant);
+	memcpy(header.mPosScale, quant.mPosScale.GetAsFloatPtr(), sizeof(header.mPosScale));
+	memcpy(header.mPosOffset, quant.mPosOffset.GetAsFloatPtr(), sizeof(header.mPosOffset));
+	memcpy(header.mUVScale, quant.mUVScale.GetAsFloatPtr(), sizeof(header.mUVScale));
+	memcpy(header.mUVOffset, quant.mUVOffset.GetAsFloatPtr(), sizeof(header.mUVOffset));
+
+	std::vector<String> textures;
+	for (const auto& tex : data.mTextures)
+	{
+		textures.emplace_back(addString(tex));
+	}
+
+	std::vector<SubMesh> subMeshes;
+	for (const auto& sm : data.mSubMeshes)
+	{
+		SubMesh out;
+		memset(&out, 0, sizeof(out));
+		out.mVertexOffset = sm.mVertexOffset;
+		out.mNumVerts = sm.mNumVerts;
+		out.mIndexOffset = sm.mIndexOffset;
+		out.mNumIndices = sm.mNumIndices;
+		out.mTextureIndex = sm.mTextureIndex;
+		subMeshes.emplace_back(out);
+	}
+
+	// Lay out the blocks
+	header.mSubMeshOffset = sizeof(Header);
+	header.mTextureOffset = AlignUp(header.mSubMeshOffset + header.mNumSubMeshes * sizeof(SubMesh));
+	header.mVertexOffset = AlignUp(header.mTextureOffset + header.mNumTextures * sizeof(String));
+	header.mIndexOffset = AlignUp(header.mVertexOffset + header.mNumVerts * header.mVertexStride);
+	header.mStringOffset = AlignUp(header.mIndexOffset + header.mNumIndices * sizeof(uint32_t));
+	header.mStringSize = static_cast<uint32_t>(strings.size());
+
+	std::ofstream file(fileName, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		SDL_Log("Failed to write cooked mesh %s", fileName.c_str());
+		return false;
+	}
+
+	const char zeros[BlockAlign] = {};
+	auto pad = [&file, &zeros](uint32_t offset)
+	{
+		uint32_t current = static_cast<uint32_t>(file.tellp());
+		file.write(zeros, offset - current);
+	};
+
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(subMeshes.data()), subMeshes.size() * sizeof(SubMesh));
+	pad(header.mTextureOffset);
+	file.write(reinterpret_cast<const char*>(textures.data()), textures.size() * sizeof(String));
+	pad(header.mVertexOffset);
+	file.write(reinterpret_cast<const char*>(vertices.data()), vertices.size());
+	pad(header.mIndexOffset);
+	file.write(reinterpret_cast<const char*>(data.mIndices.data()), data.mIndices.size() * sizeof(uint32_t));
+	pad(header.mStringOffset);
+	file.write(strings.data(), strings.size());
+
+	if (!file.good())
+	{
+		SDL_Log("Failed to write cooked mesh %s", fileName.c_str());
+		return false;
+	}
+	return true;
+}
+
+std::string MeshFile::GetCookedName(const std::string& sourceName)
+{
+	size_t dot = sourceName.find_last_of('.');
+	size_t slash = sourceName.find_last_of("/\\");
+	if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+	{
+		return sourceName + Extension;
+	}
+	return sourceName.substr(0, dot) + Extension;
+}
+
+bool MeshFile::IsUpToDate(const std::string& cookedName, const std::string& sourceName)
+{
+	struct stat cooked;
+	if (stat(cookedName.c_str(), &cooked) != 0)
+	{
+		return false;
+	}
+	struct stat source;
+	if (stat(sourceName.c_str(), &source) != 0)
+	{
+		// No source to compare against, the cooked file is all we have
+		return true;
+	}
+	return cooked.st_mtime >= source.st_mtime;
+}
+
+std::string MeshFile::GetCacheName(const std::string& sourceName, const std::string& cacheDir)
+{
+	MappedFile source;
+	if (!source.Open(sourceName))
+	{
+		return std::string();
+	}
+
+	// 64-bit FNV-1a over the source bytes, seeded with the format and
+	// cook versions so stale entries are never picked up
+	uint64_t hash = 14695981039346656037ull ^ (uint64_t(Version) << 32 | CookVersion);
+	const unsigned char* data = source.GetData();
+	for (size_t i = 0; i < source.GetSize(); i++)
+	{
+		hash ^= data[i];
+		hash *= 1099511628211ull;
+	}
+
+	char name[17];
+	snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(hash));
+	return cacheDir + "/" + name + Extension;
+}
+
+bool MeshFile::FileExists(const std::string& fileName)
+{
+	struct stat info;
+	return stat(fileName.c_str(), &info) == 0;
+}
+
+bool MeshFile::MakeDirectory(const std::string& dirName)
+{
+	if (FileExists(dirName))
+	{
+		return true;
+	}
+#ifdef _WIN32
+	return _mkdir(dirName.c_str()) == 0;
+#else
+	return mkdir(dirName.c_str(), 0755) == 0;
+#endif
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include<cstdint>
+#include<string>
+#include"MappedFile.h"
+#include"VertexFormat.h"
+
+// Cooked (binary) mesh file.
+// Written offline by MeshCooker and memory mapped at runtime, so the
+// vertex and index blocks go straight to VertexArray without parsing.
+//
+// Layout (little endian, every block 16 byte aligned):
+//   Header | SubMesh[numSubMeshes] | String[numTextures] |
+//   vertex block (Header::mVertexFormat) | index block (uint32) | string characters
+class MeshFile
+{
+public:
+	// "GPMB"
+	static const uint32_t Magic = 0x424D5047;
+	static const uint32_t Version = 2;
+	// Bumped whenever the importers change what they produce,
+	// so content hash keyed cache entries are rebuilt
+	static const uint32_t CookVersion = 3;
+	static const char* Extension;
+	// Directory holding cooked meshes keyed by source content hash
+	static const char* CacheDirectory;
+
+	// Offset/length into the string characters
+	struct String
+	{
+		uint32_t mOffset;
+		uint32_t mLength;
+	};
+
+	struct SubMesh
+	{
+		uint32_t mVertexOffset;
+		uint32_t mNumVerts;
+		uint32_t mIndexOffset;
+		uint32_t mNumIndices;
+		int32_t mTextureIndex;
+		uint32_t mPad[3];
+	};
+
+	struct Header
+	{
+		uint32_t mMagic;
+		uint32_t mVersion;
+		uint32_t mVertexFormat;
+		uint32_t mVertexStride;
+		uint32_t mNumVerts;
+		uint32_t mNumIndices;
+		uint32_t mNumSubMeshes;
+		uint32_t mNumTextures;
+		float mRadius;
+		float mSpecPower;
+		String mShaderName;
+		// Byte offsets from the start of the file
+		uint32_t mSubMeshOffset;
+		uint32_t mTextureOffset;
+		uint32_t mVertexOffset;
+		uint32_t mIndexOffset;
+		uint32_t mStringOffset;
+		uint32_t mStringSize;
+		// VertexQuantization of normalized positions/uvs
+		float mPosScale[3];
+		float mPosOffset[3];
+		float mUVScale[2];
+		float mUVOffset[2];
+	};
+
+	MeshFile();
+	~MeshFile();
+
+	// Map a cooked mesh and validate its header/blocks
+	bool Open(const std::string& fileName);
+	void Close();
+
+	// Write mesh data in the cooked format
+	static bool Write(const struct MeshData& data, const std::string& fileName);
+	// Name of the cooked file for a source asset (Assets/Cube.gpmesh -> Assets/Cube.gpbin)
+	static std::string GetCookedName(const std::string& sourceName);
+	// True if cookedName exists and is not older than sourceName
+	static bool IsUpToDate(const std::string& cookedName, const std::string& sourceName);
+	// Name of the cache entry keyed by the source file's content hash
+	// (empty if the source can't be read)
+	static std::string GetCacheName(const std::string& sourceName, const std::string& cacheDir);
+	static bool FileExists(const std::string& fileName);
+	static bool MakeDirectory(const std::string& dirName);
+
+	const Header& GetHeader() const { return *mHeader; }
+	const SubMesh& GetSubMesh(size_t index) const { return mSubMeshes[index]; }
+	const unsigned char* GetVertices() const { return mVertices; }
+	const uint32_t* GetIndices() const { return mIndices; }
+	VertexFormat GetVertexFormat() const { return static_cast<VertexFormat>(mHeader->mVertexFormat); }
+	VertexQuantization GetQuantization() const;
+	std::string GetShaderName() const { return GetString(mHeader->mShaderName); }
+	std::string GetTexture(size_t index) const { return GetString(mTextures[index]); }
+
+private:
+	std::string GetString(const String& str) const;
+
+	MappedFile mFile;
+	const Header* mHeader;
+	const SubMesh* mSubMeshes;
+	const String* mTextures;
+	const unsigned char* mVertices;
+	const uint32_t* mIndices;
+	const char* mStrings;
+};
@@ -0,0 +1,530 @@
+#include<fstream>
+#include<sstream>
+#include<stdio.h>
+#include<document.h>
+#include<SDL_log.h>
+#include<cstring>
+#include<unordered_map>
+#include"MeshImporter.h"
+#include"MeshOptimizer.h"
+
+namespace
+{
+	// Vertex used as a weld key (compared bit for bit)
+	struct VertexKey
+	{
+		float mData[MeshData::VertexSize];
+
+		void Set(int i, float value)
+		{
+			// Fold -0 into +0 so they weld together
+			mData[i] = value == 0.0f ? 0.0f : value;
+		}
+
+		bool operator==(const VertexKey& other) const
+		{
+			return memcmp(mData, other.mData, sizeof(mData)) == 0;
+		}
+	};
+
+	struct VertexKeyHash
+	{
+		size_t operator()(const VertexKey& key) const
+		{
+			// FNV-1a over the raw float bits
+			const unsigned char* bytes = reinterpret_cast<const unsigned char*>(key.mData);
+			size_t hash = 2166136261u;
+			for (size_t i = 0; i < sizeof(key.mData); i++)
+			{
+				hash ^= bytes[i];
+				hash *= 16777619u;
+			}
+			return hash;
+		}
+	};
+
+	// Index into an element's direct array for a polygon vertex,
+	// honoring its mapping and reference modes (-1 if unsupported)
+	template<typename T>
+	int GetElementIndex(T* element, int controlPoint, int polygonVertex)
+	{
+		int index = -1;
+		switch (element->GetMappingMode())
+		{
+		case FbxGeometryElement::eByControlPoint:
+			index = controlPoint;
+			break;
+		case FbxGeometryElement::eByPolygonVertex:
+			index = polygonVertex;
+			break;
+		default:
+			return -1;
+		}
+
+		switch (element->GetReferenceMode())
+		{
+		case FbxGeometryElement::eDirect:
+			break;
+		case FbxGeometryElement::eIndexToDirect:
+			if (index >= element->GetIndexArray().GetCount())
+			{
+				return -1;
+			}
+			index = element->GetIndexArray().GetAt(index);
+			break;
+		default:
+			return -1;
+		}
+		return index < element->GetDirectArray().GetCount() ? index : -1;
+	}
+}
+
+bool MeshImporter::LoadGPMesh(const std::string& fileName, MeshData& outData)
+{
+	std::ifstream file(fileName);
+	if (!file.is_open())
+	{
+		SDL_Log("File not found: Mesh %s", fileName.c_str());
+		return false;
+	}
+
+	std::stringstream fileStream;
+	fileStream << file.rdbuf();
+	std::string contents = fileStream.str();
+	rapidjson::StringStream jsonStr(contents.c_str());
+	rapidjson::Document doc;
+	doc.ParseStream(jsonStr);
+
+	if (!doc.IsObject())
+	{
+		SDL_Log("Mesh %s is not valid json", fileName.c_str());
+		return false;
+	}
+
+	int ver = doc["version"].GetInt();
+
+	// Check the version
+	if (ver != 1)
+	{
+		SDL_Log("Mesh %s not version 1", fileName.c_str());
+		return false;
+	}
+
+	outData.mShaderName = doc["shader"].GetString();
+
+	// The source vertices are always 8 floats, the format
+	// selects how they are encoded for the GPU
+	size_t vertSize = MeshData::VertexSize;
+	if (doc.HasMember("vertexformat"))
+	{
+		std::string format = doc["vertexformat"].GetString();
+		if (!VertexEncoder::Parse(format, outData.mVertexFormat))
+		{
+			SDL_Log("Unknown vertex format %s for %s, using %s", format.c_str(), fileName.c_str(),
+				VertexEncoder::GetName(outData.mVertexFormat));
+		}
+	}
+
+	// Load textures
+	const rapidjson::Value& textures = doc["textures"];
+	if (!textures.IsArray() || textures.Size() < 1)
+	{
+		SDL_Log("Mesh %s has no textures, there should be at least one", fileName.c_str());
+		return false;
+	}
+
+	outData.mSpecPower = static_cast<float>(doc["specularPower"].GetDouble());
+
+	for (rapidjson::SizeType i = 0; i < textures.Size(); i++)
+	{
+		outData.mTextures.emplace_back(textures[i].GetString());
+	}
+
+	// Load in the vertices
+	const rapidjson::Value& vertsJson = doc["vertices"];
+	if (!vertsJson.IsArray() || vertsJson.Size() < 1)
+	{
+		SDL_Log("Mesh %s has no vertices", fileName.c_str());
+		return false;
+	}
+
+	std::vector<float>& vertices = outData.mVertices;
+	vertices.reserve(vertsJson.Size() * vertSize);
+	float radius = 0.0f;
+	for (rapidjson::SizeType i = 0; i < vertsJson.Size(); i++)
+	{
+		// For now, just assume we have 8 elements
+		const rapidjson::Value& vert = vertsJson[i];
+		if (!vert.IsArray() || vert.Size() != 8)
+		{
+			SDL_Log("Unexpected vertex format for %s", fileName.c_str());
+			return false;
+		}
+
+		Vector3 pos(vert[0].GetDouble(), vert[1].GetDouble(), vert[2].GetDouble());
+		radius = Math::Max(radius, pos.LengthSq());
+
+		// Add the floats
+		for (rapidjson::SizeType i = 0; i < vert.Size(); i++)
+		{
+			vertices.emplace_back(static_cast<float>(vert[i].GetDouble()));
+		}
+	}
+
+	// We were computing length squared earlier
+	outData.mRadius = Math::Sqrt(radius);
+
+	// Load in the indices
+	const rapidjson::Value& indJson = doc["indices"];
+	if (!indJson.IsArray() || indJson.Size() < 1)
+	{
+		SDL_Log("Mesh %s has no indices", fileName.c_str());
+		return false;
+	}
+
+	std::vector<unsigned int>& indices = outData.mIndices;
+	indices.reserve(indJson.Size() * 3);
+	const unsigned int numVerts = outData.GetNumVerts();
+	for (rapidjson::SizeType i = 0; i < indJson.Size(); i++)
+	{
+		const rapidjson::Value& ind = indJson[i];
+		if (!ind.IsArray() || ind.Size() != 3)
+		{
+			SDL_Log("Invalid indices for %s", fileName.c_str());
+			return false;
+		}
+
+		for (rapidjson::SizeType k = 0; k < 3; k++)
+		{
+			// The optimizer and the GPU index straight into the vertices
+			if (!ind[k].IsUint() || ind[k].GetUint() >= numVerts)
+			{
+				SDL_Log("Invalid indices for %s", fileName.c_str());
+				return false;
+			}
+			indices.emplace_back(ind[k].GetUint());
+		}
+	}
+
+	// The whole file is a single sub mesh
+	SubMeshData subMesh;
+	subMesh.mNumVerts = outData.GetNumVerts();
+	subMesh.mNumIndices = static_cast<unsigned int>(indices.size());
+	outData.mSubMeshes.emplace_back(subMesh);
+
+	MeshOptimizer::Optimize(outData, fileName);
+	return true;
+}
+
+bool MeshImporter::LoadFBX(const std::string& fileName, MeshData& outData)
+{
+	//Initialize manager
+	fbxsdk::FbxManager* fbxManager = fbxsdk::FbxManager::Create();
+	FbxIOSettings* fbxIOS = FbxIOSettings::Create(fbxManager, IOSROOT);
+	fbxManager->SetIOSettings(fbxIOS);
+
+	//Initialize importer
+	FbxImporter* fbxImporter = FbxImporter::Create(fbxManager, "");
+	if (!fbxImporter->Initialize(fileName.c_str(), -1, fbxManager->GetIOSettings()))
+	{
+		SDL_Log("Failed to import FBX %s", fileName.c_str());
+		fbxManager->Destroy();
+		return false;
+	}
+
+	//Initialize scene
+	FbxScene* fbxScene = FbxScene::Create(fbxManager, "scene");
+	fbxImporter->Import(fbxScene);
+	fbxImporter->Destroy();
+
+	FbxGeometryConverter geometryConverter(fbxManager);
+	geometryConverter.Triangulate(fbxScene, true);
+
+	//Root Node
+	FbxNode* root = fbxScene->GetRootNode();
+
+	//Show
+	if (root != 0) PrintName(root, 0);
+	if (root)
+	{
+		int childCount = root->GetChildCount();
+		for (int i = 0; i < childCount; i++)
+		{
+			GetMesh(root->GetChild(i), outData);
+		}
+	}
+	fbxManager->Destroy();
+
+	// We were computing length squared while reading positions
+	outData.mRadius = Math::Sqrt(outData.mRadius);
+
+	if (outData.mTextures.size() == 0)
+	{
+		outData.mTextures.emplace_back("Texture/none.png");
+	}
+
+	MeshOptimizer::Optimize(outData, fileName);
+	return !outData.mSubMeshes.empty();
+}
+
+void MeshImporter::GetMesh(FbxNode* node, MeshData& outData)
+{
+	SubMeshData subMesh;
+	FbxNodeAttribute* attribute = node->GetNodeAttribute();
+	if (attribute)
+	{
+		FbxNodeAttribute::EType type = attribute->GetAttributeType();
+		switch (type)
+		{
+		case FbxNodeAttribute::eMesh:
+
+			FbxMesh* mesh = node->GetMesh();
+			GetPosition(mesh);
+			GetNormal(mesh);
+			GetUV(mesh);
+			GetTexture(mesh, outData, subMesh);
+			break;
+		}
+	}
+
+	// Control point radius
+	for (const auto& p : positions)
+	{
+		outData.mRadius = Math::Max(outData.mRadius, p.LengthSq());
+	}
+
+	// Weld the polygon vertices: identical (position, normal, uv)
+	// tuples become one vertex and the index buffer references it
+	subMesh.mVertexOffset = outData.GetNumVerts();
+	subMesh.mIndexOffset = static_cast<unsigned int>(outData.mIndices.size());
+	std::unordered_map<VertexKey, unsigned int, VertexKeyHash> unique;
+	unique.reserve(indices.size());
+	std::vector<float>& vertices = outData.mVertices;
+	for (size_t i = 0; i < indices.size(); i++)
+	{
+		VertexKey key;
+		//Position
+		key.Set(0, positions[indices[i]].x);
+		key.Set(1, positions[indices[i]].y);
+		key.Set(2, positions[indices[i]].z);
+
+		//Normal
+		Vector3 n = i < normals.size() ? normals[i] : Vector3::Zero;
+		key.Set(3, n.x);
+		key.Set(4, n.y);
+		key.Set(5, n.z);
+
+		//UV
+		Vector2 uv = i < uvs.size() ? uvs[i] : Vector2::Zero;
+		key.Set(6, uv.x);
+		key.Set(7, uv.y);
+
+		unsigned int next = outData.GetNumVerts() - subMesh.mVertexOffset;
+		auto iter = unique.emplace(key, next);
+		if (iter.second)
+		{
+			vertices.insert(vertices.end(), key.mData, key.mData + MeshData::VertexSize);
+		}
+		outData.mIndices.emplace_back(iter.first->second);
+	}
+	subMesh.mNumVerts = outData.GetNumVerts() - subMesh.mVertexOffset;
+	subMesh.mNumIndices = static_cast<unsigned int>(outData.mIndices.size()) - subMesh.mIndexOffset;
+
+	if (subMesh.mNumVerts > 0)
+	{
+		// Expanded layout had one vertex per index
+		const unsigned int vertBytes = sizeof(float) * MeshData::VertexSize;
+		SDL_Log("Mesh %s: %u indices, %u -> %u vertices, VBO %u -> %u bytes", node->GetName(),
+			subMesh.mNumIndices, subMesh.mNumIndices, subMesh.mNumVerts,
+			subMesh.mNumIndices * vertBytes, subMesh.mNumVerts * vertBytes);
+		outData.mSubMeshes.emplace_back(subMesh);
+	}
+
+	indices.clear();
+	positions.clear();
+	normals.clear();
+	uvs.clear();
+
+	int childCount = node->GetChildCount();
+	for (int i = 0; i < childCount; i++)
+	{
+		GetMesh(node->GetChild(i), outData);
+	}
+}
+
+void MeshImporter::GetPosition(FbxMesh* mesh)
+{
+	for (int i = 0; i < mesh->GetPolygonCount() * 3; i++)
+	{
+		indices.emplace_back(mesh->GetPolygonVertices()[i]);
+	}
+
+	FbxVector4* vertex = mesh->GetControlPoints();
+	for (int i = 0; i < mesh->GetControlPointsCount(); i++)
+	{
+		//position
+		Vector3 p;
+		p.x = (float)vertex[i][0];//X
+		p.y = (float)vertex[i][1];//Y
+		p.z = (float)vertex[i][2];//Z
+		positions.emplace_back(p);
+	}
+}
+
+void MeshImporter::GetNormal(FbxMesh* _mesh)
+{
+	//Normals (first layer), one per polygon vertex
+	if (_mesh->GetElementNormalCount() == 0)
+	{
+		return;
+	}
+	FbxGeometryElementNormal* normal = _mesh->GetElementNormal(0);
+	for (size_t i = 0; i < indices.size(); i++)
+	{
+		int index = GetElementIndex(normal, static_cast<int>(indices[i]), static_cast<int>(i));
+		if (index < 0)
+		{
+			normals.clear();
+			return;
+		}
+		Vector3 n;
+		n.x = (float)normal->GetDirectArray().GetAt(index)[0];
+		n.y = (float)normal->GetDirectArray().GetAt(index)[1];
+		n.z = (float)normal->GetDirectArray().GetAt(index)[2];
+		normals.emplace_back(n);
+	}
+}
+
+void MeshImporter::GetUV(FbxMesh* mesh)
+{
+	//UVs (first set), one per polygon vertex
+	if (mesh->GetElementUVCount() == 0)
+	{
+		return;
+	}
+	FbxGeometryElementUV* uv = mesh->GetElementUV(0);
+	uvName = uv->GetName();
+	for (size_t i = 0; i < indices.size(); i++)
+	{
+		int index = GetElementIndex(uv, static_cast<int>(indices[i]), static_cast<int>(i));
+		if (index < 0)
+		{
+			uvs.clear();
+			return;
+		}
+		Vector2 vec2UV;
+		vec2UV.x = (float)uv->GetDirectArray().GetAt(index)[0];
+		vec2UV.y = (float)uv->GetDirectArray().GetAt(index)[1];
+		uvs.emplace_back(vec2UV);
+	}
+}
+
+void MeshImporter::GetTexture(FbxMesh* _mesh, MeshData& outData, SubMeshData& subMesh)
+{
+	FbxNode* node = _mesh->GetNode();
+
+	for (int i = 0; i < node->GetMaterialCount(); i++)
+	{
+		FbxSurfaceMaterial* fbxMaterial = node->GetMaterial(i);//Material
+		FbxProperty fbxProperty = fbxMaterial->FindProperty(FbxSurfaceMaterial::sDiffuse);
+
+		for (int j = 0; j < fbxProperty.GetSrcObjectCount<FbxFileTexture>(); j++)
+		{
+			FbxFileTexture* texture = fbxProperty.GetSrcObject<FbxFileTexture>(j);
+			if (texture)
+			{
+				std::string textureName = texture->GetRelativeFileName();
+
+				std::string uvSetName = texture->UVSet.Get().Buffer();
+				if (uvName == uvSetName)
+				{
+					// Share texture slots between nodes
+					int index = 0;
+					for (; index < static_cast<int>(outData.mTextures.size()); index++)
+					{
+						if (outData.mTextures[index] == textureName)
+						{
+							break;
+						}
+					}
+					if (index == static_cast<int>(outData.mTextures.size()))
+					{
+						outData.mTextures.emplace_back(textureName);
+					}
+					// First diffuse texture of the node is its binding
+					if (subMesh.mTextureIndex < 0)
+					{
+						subMesh.mTextureIndex = index;
+					}
+				}
+			}
+		}
+	}
+}
+
+void MeshImporter::PrintName(FbxNode* node, int indent)
+{
+	for (int i = 0; i < indent; i++)
+	{
+		printf("  ");
+	}
+
+	const char* eTypeNames[] =
+	{
+		"eUnknown",
+		"eNull",
+		"eMarker",
+		"eSkeleton",
+		"eMesh",
+		"eNurbs",
+		"ePatch",
+		"eCamera",
+		"eCameraStereo",
+		"eCameraSwitcher",
+		"eLight",
+		"eOpticalReference",
+		"eOpticalMarker",
+		"eNurbsCurve",
+		"eTrimNurbsSurface",
+		"eBoundary",
+		"eNurbsSurface",
+		"eShape",
+		"eLODGroup",
+		"eSubDiv",
+		"eCachedEffect",
+		"eLine"
+	};
+
+	const char* name = node->GetName();
+
+	int attributeCount = node->GetNodeAttributeCount();
+	if (attributeCount == 0)
+	{
+		printf("%s\n", name);
+	}
+	else
+	{
+		printf("%s (", name);
+	}
+	for (int i = 0; i < attributeCount; ++i)
+	{
+		FbxNodeAttribute* attribute = node->GetNodeAttributeByIndex(i);
+		FbxNodeAttribute::EType type = attribute->GetAttributeType();
+
+		printf("%s", eTypeNames[type]);
+		if (i + 1 == attributeCount)
+		{
+			printf(")\n");
+		}
+		else
+		{
+			printf(", ");
+		}
+	}
+
+	int childCount = node->GetChildCount();
+	for (int i = 0; i < childCount; i++)
+	{
+		PrintName(node->GetChild(i), indent + 1);
+	}
+}
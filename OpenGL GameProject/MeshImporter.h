@@ -0,0 +1,32 @@
+#pragma once
+#include<string>
+#include<vector>
+#include<fbxsdk.h>
+#include"Math.h"
+#include"MeshData.h"
+
+// Reads source mesh assets (.gpmesh json, FBX) into MeshData.
+// Used by Mesh when no cooked file is available and by MeshCooker.
+class MeshImporter
+{
+public:
+	// Load a .gpmesh json file
+	static bool LoadGPMesh(const std::string& fileName, MeshData& outData);
+	// Import and triangulate an FBX scene, one sub mesh per mesh node
+	bool LoadFBX(const std::string& fileName, MeshData& outData);
+
+private:
+	void GetMesh(FbxNode* node, MeshData& outData);
+	void GetPosition(FbxMesh* mesh);
+	void GetNormal(FbxMesh* mesh);
+	void GetUV(FbxMesh* mesh);
+	void GetTexture(FbxMesh* mesh, MeshData& outData, SubMeshData& subMesh);
+
+	void PrintName(FbxNode* node, int indent);
+
+	std::vector<unsigned int> indices;
+	std::vector<Vector3> positions;
+	std::vector<Vector3> normals;
+	std::vector<Vector2> uvs;
+	std::string uvName;
+};
@@ -0,0 +1,457 @@
+#include"MeshOptimizer.h"
+#include"MeshData.h"
+#include"Math.h"
+#include<vector>
+#include<algorithm>
+#include<SDL_log.h>
+
+namespace
+{
+	// Forsyth scoring constants, tuned for a 32 entry LRU cache
+	const int ForsythCacheSize = 32;
+	const float CacheDecayPower = 1.5f;
+	const float LastTriScore = 0.75f;
+	const float ValenceBoostScale = 2.0f;
+	const float ValenceBoostPower = 0.5f;
+
+	float VertexScore(int cachePosition, unsigned int remainingTris)
+	{
+		if (remainingTris == 0)
+		{
+			// No triangle needs this vertex anymore
+			return -1.0f;
+		}
+
+		float score = 0.0f;
+		if (cachePosition >= 0)
+		{
+			if (cachePosition < 3)
+			{
+				// Used by the last triangle, fixed score so the
+				// same triangle isn't immediately preferred again
+				score = LastTriScore;
+			}
+			else
+			{
+				const float scaler = 1.0f / (ForsythCacheSize - 3);
+				score = 1.0f - (cachePosition - 3) * scaler;
+				score = powf(score, CacheDecayPower);
+			}
+		}
+
+		// Boost vertices with few triangles left so they get finished
+		score += ValenceBoostScale * powf(static_cast<float>(remainingTris), -ValenceBoostPower);
+		return score;
+	}
+
+	// Post-transform FIFO cache: a vertex is resident if fewer than
+	// cacheSize misses happened since it was last loaded
+	unsigned int CountMissesFIFO(const unsigned int* indices, size_t numIndices,
+		std::vector<unsigned int>& timestamps, unsigned int& time, unsigned int cacheSize)
+	{
+		unsigned int misses = 0;
+		for (size_t i = 0; i < numIndices; i++)
+		{
+			unsigned int v = indices[i];
+			if (time - timestamps[v] > cacheSize)
+			{
+				timestamps[v] = time++;
+				misses++;
+			}
+		}
+		return misses;
+	}
+
+	Vector3 GetPosition(const float* vertices, unsigned int index)
+	{
+		const float* v = vertices + index * MeshData::VertexSize;
+		return Vector3(v[0], v[1], v[2]);
+	}
+}
+
+MeshOptimizer::CacheStats MeshOptimizer::AnalyzeVertexCache(const unsigned int* indices, size_t numIndices,
+	unsigned int numVerts, unsigned int cacheSize, CachePolicy policy)
+{
+	CacheStats stats;
+	if (numIndices < 3 || numVerts == 0)
+	{
+		return stats;
+	}
+
+	std::vector<bool> referenced(numVerts, false);
+	unsigned int numReferenced = 0;
+	for (size_t i = 0; i < numIndices; i++)
+	{
+		if (!referenced[indices[i]])
+		{
+			referenced[indices[i]] = true;
+			numReferenced++;
+		}
+	}
+
+	if (policy == CachePolicy::EFIFO)
+	{
+		std::vector<unsigned int> timestamps(numVerts, 0);
+		unsigned int time = cacheSize + 1;
+		stats.mMisses = CountMissesFIFO(indices, numIndices, timestamps, time, cacheSize);
+	}
+	else
+	{
+		// Most recently used first
+		std::vector<unsigned int> cache;
+		cache.reserve(cacheSize + 1);
+		for (size_t i = 0; i < numIndices; i++)
+		{
+			unsigned int v = indices[i];
+			auto iter = std::find(cache.begin(), cache.end(), v);
+			if (iter != cache.end())
+			{
+				cache.erase(iter);
+			}
+			else
+			{
+				stats.mMisses++;
+			}
+			cache.insert(cache.begin(), v);
+			if (cache.size() > cacheSize)
+			{
+				cache.pop_back();
+			}
+		}
+	}
+
+	stats.mACMR = static_cast<float>(stats.mMisses) / static_cast<float>(numIndices / 3);
+	stats.mATVR = static_cast<float>(stats.mMisses) / static_cast<float>(numReferenced);
+	return stats;
+}
+
+void MeshOptimizer::OptimizeVertexCache(unsigned int* indices, size_t numIndices, unsigned int numVerts)
+{
+	const size_t numTris = numIndices / 3;
+	if (numTris == 0 || numVerts == 0)
+	{
+		return;
+	}
+
+	// Triangles using each vertex (only the first mRemaining are still to be drawn)
+	std::vector<unsigned int> triOffset(numVerts + 1, 0);
+	std::vector<unsigned int> remaining(numVerts, 0);
+	for (size_t i = 0; i < numTris * 3; i++)
+	{
+		remaining[indices[i]]++;
+	}
+	for (unsigned int v = 0; v < numVerts; v++)
+	{
+		triOffset[v + 1] = triOffset[v] + remaining[v];
+	}
+	std::vector<unsigned int> vertTris(triOffset[numVerts]);
+	std::vector<unsigned int> fill(triOffset.begin(), triOffset.end() - 1);
+	for (size_t t = 0; t < numTris; t++)
+	{
+		for (int k = 0; k < 3; k++)
+		{
+			vertTris[fill[indices[t * 3 + k]]++] = static_cast<unsigned int>(t);
+		}
+	}
+
+	std::vector<int> cachePosition(numVerts, -1);
+	std::vector<float> vertScore(numVerts);
+	for (unsigned int v = 0; v < numVerts; v++)
+	{
+		vertScore[v] = VertexScore(-1, remaining[v]);
+	}
+
+	std::vector<float> triScore(numTris);
+	std::vector<bool> triAdded(numTris, false);
+	int bestTri = -1;
+	float bestScore = -1.0f;
+	for (size_t t = 0; t < numTris; t++)
+	{
+		triScore[t] = vertScore[indices[t * 3]] + vertScore[indices[t * 3 + 1]] + vertScore[indices[t * 3 + 2]];
+		if (triScore[t] > bestScore)
+		{
+			bestScore = triScore[t];
+			bestTri = static_cast<int>(t);
+		}
+	}
+
+	std::vector<unsigned int> output;
+	output.reserve(numTris * 3);
+	std::vector<unsigned int> cache;
+	std::vector<unsigned int> newCache;
+	cache.reserve(ForsythCacheSize + 3);
+	newCache.reserve(ForsythCacheSize + 3);
+	size_t scan = 0;
+
+	for (size_t emitted = 0; emitted < numTris; emitted++)
+	{
+		if (bestTri < 0)
+		{
+			// Nothing in the cache is useful, continue with the next unused triangle
+			while (triAdded[scan])
+			{
+				scan++;
+			}
+			bestTri = static_cast<int>(scan);
+		}
+
+		const unsigned int* tri = indices + bestTri * 3;
+		triAdded[bestTri] = true;
+		output.insert(output.end(), tri, tri + 3);
+
+		// Remove the triangle from its vertices' remaining lists
+		newCache.clear();
+		for (int k = 0; k < 3; k++)
+		{
+			unsigned int v = tri[k];
+			unsigned int* begin = &vertTris[triOffset[v]];
+			unsigned int* end = begin + remaining[v];
+			unsigned int* pos = std::find(begin, end, static_cast<unsigned int>(bestTri));
+			std::swap(*pos, *(end - 1));
+			remaining[v]--;
+			newCache.emplace_back(v);
+		}
+		for (auto v : cache)
+		{
+			if (v != tri[0] && v != tri[1] && v != tri[2])
+			{
+				newCache.emplace_back(v);
+			}
+		}
+
+		// Rescore everything that was or is in the cache
+		for (size_t i = 0; i < newCache.size(); i++)
+		{
+			unsigned int v = newCache[i];
+			int position = i < ForsythCacheSize ? static_cast<int>(i) : -1;
+			cachePosition[v] = position;
+			float score = VertexScore(position, remaining[v]);
+			float delta = score - vertScore[v];
+			vertScore[v] = score;
+			for (unsigned int j = 0; j < remaining[v]; j++)
+			{
+				triScore[vertTris[triOffset[v] + j]] += delta;
+			}
+		}
+
+		// Best candidate among the triangles touching the cache
+		bestTri = -1;
+		bestScore = -1.0f;
+		size_t cached = std::min(newCache.size(), static_cast<size_t>(ForsythCacheSize));
+		for (size_t i = 0; i < cached; i++)
+		{
+			unsigned int v = newCache[i];
+			for (unsigned int j = 0; j < remaining[v]; j++)
+			{
+				unsigned int t = vertTris[triOffset[v] + j];
+				if (triScore[t] > bestScore)
+				{
+					bestScore = triScore[t];
+					bestTri = static_cast<int>(t);
+				}
+			}
+		}
+
+		newCache.resize(cached);
+		cache.swap(newCache);
+	}
+
+	std::copy(output.begin(), output.end(), indices);
+}
+
+void MeshOptimizer::OptimizeOverdraw(unsigned int* indices, size_t numIndices,
+	const float* vertices, unsigned int numVerts, float threshold)
+{
+	const size_t numTris = numIndices / 3;
+	if (numTris < 2 || numVerts == 0)
+	{
+		return;
+	}
+
+	// Hard boundaries: triangles where all three vertices miss the cache
+	std::vector<size_t> hard;
+	{
+		std::vector<unsigned int> timestamps(numVerts, 0);
+		unsigned int time = FIFOCacheSize + 1;
+		for (size_t t = 0; t < numTris; t++)
+		{
+			if (CountMissesFIFO(indices + t * 3, 3, timestamps, time, FIFOCacheSize) == 3)
+			{
+				hard.emplace_back(t);
+			}
+		}
+		if (hard.empty() || hard[0] != 0)
+		{
+			hard.insert(hard.begin(), 0);
+		}
+		hard.emplace_back(numTris);
+	}
+
+	// Soft boundaries: split hard clusters wherever the running ACMR
+	// already reached the cluster's ACMR scaled by threshold
+	std::vector<size_t> clusters;
+	for (size_t c = 0; c + 1 < hard.size(); c++)
+	{
+		size_t start = hard[c];
+		size_t end = hard[c + 1];
+
+		std::vector<unsigned int> timestamps(numVerts, 0);
+		unsigned int time = FIFOCacheSize + 1;
+		unsigned int clusterMisses = CountMissesFIFO(indices + start * 3, (end - start) * 3,
+			timestamps, time, FIFOCacheSize);
+		float clusterThreshold = threshold * static_cast<float>(clusterMisses) / static_cast<float>(end - start);
+
+		clusters.emplace_back(start);
+		std::fill(timestamps.begin(), timestamps.end(), 0);
+		time = FIFOCacheSize + 1;
+		unsigned int runningMisses = 0;
+		unsigned int runningTris = 0;
+		for (size_t t = start; t < end; t++)
+		{
+			runningMisses += CountMissesFIFO(indices + t * 3, 3, timestamps, time, FIFOCacheSize);
+			runningTris++;
+			if (t + 1 < end &&
+				static_cast<float>(runningMisses) / static_cast<float>(runningTris) <= clusterThreshold)
+			{
+				clusters.emplace_back(t + 1);
+				std::fill(timestamps.begin(), timestamps.end(), 0);
+				time = FIFOCacheSize + 1;
+				runningMisses = 0;
+				runningTris = 0;
+			}
+		}
+	}
+	clusters.emplace_back(numTris);
+
+	// Mesh centroid
+	Vector3 meshCenter;
+	for (size_t i = 0; i < numIndices; i++)
+	{
+		meshCenter += GetPosition(vertices, indices[i]);
+	}
+	meshCenter *= 1.0f / static_cast<float>(numIndices);
+
+	// Clusters facing away from the center occlude the rest, draw them first
+	struct Cluster
+	{
+		size_t mStart;
+		size_t mEnd;
+		float mSortKey;
+	};
+	std::vector<Cluster> sorted;
+	for (size_t c = 0; c + 1 < clusters.size(); c++)
+	{
+		Cluster cluster;
+		cluster.mStart = clusters[c];
+		cluster.mEnd = clusters[c + 1];
+
+		Vector3 center;
+		Vector3 normal;
+		float area = 0.0f;
+		for (size_t t = cluster.mStart; t < cluster.mEnd; t++)
+		{
+			Vector3 p0 = GetPosition(vertices, indices[t * 3]);
+			Vector3 p1 = GetPosition(vertices, indices[t * 3 + 1]);
+			Vector3 p2 = GetPosition(vertices, indices[t * 3 + 2]);
+			Vector3 n = Vector3::Cross(p1 - p0, p2 - p0);
+			float triArea = n.Length();
+			center += (p0 + p1 + p2) * (triArea / 3.0f);
+			normal += n;
+			area += triArea;
+		}
+		if (area > 0.0f)
+		{
+			center *= 1.0f / area;
+		}
+		if (normal.LengthSq() > 0.0f)
+		{
+			normal.Normalize();
+		}
+		cluster.mSortKey = Vector3::Dot(center - meshCenter, normal);
+		sorted.emplace_back(cluster);
+	}
+
+	std::stable_sort(sorted.begin(), sorted.end(), [](const Cluster& a, const Cluster& b)
+	{
+		return a.mSortKey > b.mSortKey;
+	});
+
+	std::vector<unsigned int> output;
+	output.reserve(numTris * 3);
+	for (const auto& cluster : sorted)
+	{
+		output.insert(output.end(), indices + cluster.mStart * 3, indices + cluster.mEnd * 3);
+	}
+	std::copy(output.begin(), output.end(), indices);
+}
+
+unsigned int MeshOptimizer::OptimizeVertexFetch(float* vertices, unsigned int* indices,
+	size_t numIndices, unsigned int numVerts)
+{
+	const unsigned int unused = ~0u;
+	std::vector<unsigned int> remap(numVerts, unused);
+	unsigned int next = 0;
+	for (size_t i = 0; i < numIndices; i++)
+	{
+		unsigned int& r = remap[indices[i]];
+		if (r == unused)
+		{
+			r = next++;
+		}
+		indices[i] = r;
+	}
+
+	std::vector<float> reordered(next * MeshData::VertexSize);
+	for (unsigned int v = 0; v < numVerts; v++)
+	{
+		if (remap[v] != unused)
+		{
+			std::copy(vertices + v * MeshData::VertexSize, vertices + (v + 1) * MeshData::VertexSize,
+				reordered.begin() + remap[v] * MeshData::VertexSize);
+		}
+	}
+	std::copy(reordered.begin(), reordered.end(), vertices);
+	return next;
+}
+
+void MeshOptimizer::Optimize(MeshData& data, const std::string& name)
+{
+	std::vector<float> vertices;
+	vertices.reserve(data.mVertices.size());
+	for (size_t i = 0; i < data.mSubMeshes.size(); i++)
+	{
+		SubMeshData& sm = data.mSubMeshes[i];
+		std::vector<float> local(data.mVertices.begin() + sm.mVertexOffset * MeshData::VertexSize,
+			data.mVertices.begin() + (sm.mVertexOffset + sm.mNumVerts) * MeshData::VertexSize);
+		unsigned int* idx = data.mIndices.data() + sm.mIndexOffset;
+		size_t numIndices = sm.mNumIndices;
+
+		// Every pass indexes per vertex arrays with the indices
+		bool inRange = std::all_of(idx, idx + numIndices, [&sm](unsigned int index) { return index < sm.mNumVerts; });
+		if (!inRange)
+		{
+			SDL_Log("Mesh %s[%u] has indices past its %u vertices, not optimized", name.c_str(),
+				static_cast<unsigned int>(i), sm.mNumVerts);
+		}
+		else if (numIndices >= 3 && numIndices % 3 == 0)
+		{
+			CacheStats fifoBefore = AnalyzeVertexCache(idx, numIndices, sm.mNumVerts, FIFOCacheSize, CachePolicy::EFIFO);
+			CacheStats lruBefore = AnalyzeVertexCache(idx, numIndices, sm.mNumVerts, LRUCacheSize, CachePolicy::ELRU);
+
+			OptimizeVertexCache(idx, numIndices, sm.mNumVerts);
+			OptimizeOverdraw(idx, numIndices, local.data(), sm.mNumVerts);
+			sm.mNumVerts = OptimizeVertexFetch(local.data(), idx, numIndices, sm.mNumVerts);
+
+			CacheStats fifoAfter = AnalyzeVertexCache(idx, numIndices, sm.mNumVerts, FIFOCacheSize, CachePolicy::EFIFO);
+			CacheStats lruAfter = AnalyzeVertexCache(idx, numIndices, sm.mNumVerts, LRUCacheSize, CachePolicy::ELRU);
+			SDL_Log("Mesh %s[%u]: FIFO%u ACMR %.3f -> %.3f ATVR %.3f -> %.3f, LRU%u ACMR %.3f -> %.3f ATVR %.3f -> %.3f",
+				name.c_str(), static_cast<unsigned int>(i),
+				FIFOCacheSize, fifoBefore.mACMR, fifoAfter.mACMR, fifoBefore.mATVR, fifoAfter.mATVR,
+				LRUCacheSize, lruBefore.mACMR, lruAfter.mACMR, lruBefore.mATVR, lruAfter.mATVR);
+		}
+
+		sm.mVertexOffset = static_cast<unsigned int>(vertices.size() / MeshData::VertexSize);
+		vertices.insert(vertices.end(), local.begin(), local.begin() + sm.mNumVerts * MeshData::VertexSize);
+	}
+	data.mVertices.swap(vertices);
+}
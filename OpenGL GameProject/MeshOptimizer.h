@@ -0,0 +1,50 @@
+#pragma once
+#include<cstddef>
+#include<string>
+
+// Index/vertex reordering applied to meshes at load and cook time.
+// All functions work on one sub mesh: indices are relative to the
+// first vertex and vertices are MeshData::VertexSize floats.
+class MeshOptimizer
+{
+public:
+	enum class CachePolicy
+	{
+		EFIFO,
+		ELRU
+	};
+
+	struct CacheStats
+	{
+		// Transformed vertices per triangle
+		float mACMR = 0.0f;
+		// Transformed vertices per referenced vertex (1.0 is ideal)
+		float mATVR = 0.0f;
+		unsigned int mMisses = 0;
+	};
+
+	// Simulate a post-transform cache of cacheSize entries
+	static CacheStats AnalyzeVertexCache(const unsigned int* indices, size_t numIndices,
+		unsigned int numVerts, unsigned int cacheSize, CachePolicy policy);
+
+	// Reorder triangles for the post-transform cache (Forsyth)
+	static void OptimizeVertexCache(unsigned int* indices, size_t numIndices, unsigned int numVerts);
+
+	// Reorder clusters of the cache-optimized triangles so outward facing
+	// ones draw first, allowing ACMR to grow by at most threshold
+	static void OptimizeOverdraw(unsigned int* indices, size_t numIndices,
+		const float* vertices, unsigned int numVerts, float threshold = 1.05f);
+
+	// Reorder vertices in first-use order and remap the indices.
+	// Unreferenced vertices are dropped, returns the new vertex count.
+	static unsigned int OptimizeVertexFetch(float* vertices, unsigned int* indices,
+		size_t numIndices, unsigned int numVerts);
+
+	// Run all passes on every sub mesh and log the cache stats. A sub mesh
+	// with indices past its vertices is logged and left as it is.
+	static void Optimize(struct MeshData& data, const std::string& name);
+
+	// Sizes used for the logged cache simulations
+	static const unsigned int FIFOCacheSize = 16;
+	static const unsigned int LRUCacheSize = 32;
+};
@@ -1,16 +1,59 @@
 #include "MoveComponent.h"
 #include "Actor.h"
+#include "Game.h"
 
 MoveComponent::MoveComponent(Actor* owner, int updateOrder)
 	:Component(owner, updateOrder)
+	, mSystem(owner->GetGame()->GetMovementSystem())
 	, mAngularSpeed(0.0f)
 	, mForwardSpeed(0.0f)
 {
+	if (mSystem)
+	{
+		mMovement = mSystem->Create(owner, owner->GetTransformHandle());
+	}
+}
+
+MoveComponent::~MoveComponent()
+{
+	if (mSystem)
+	{
+		mSystem->Destroy(mMovement);
+	}
+}
+
+void MoveComponent::SetAngularSpeed(float speed)
+{
+	if (mSystem)
+	{
+		mSystem->Get(mMovement).mAngularSpeed = speed;
+	}
+	else
+	{
+		mAngularSpeed = speed;
+	}
+}
 
+void MoveComponent::SetForwardSpeed(float speed)
+{
+	if (mSystem)
+	{
+		mSystem->Get(mMovement).mForwardSpeed = speed;
+	}
+	else
+	{
+		mForwardSpeed = speed;
+	}
 }
 
 void MoveComponent::Update(float deltaTime)
 {
+	// The MovementSystem moves pooled components
+	if (mSystem)
+	{
+		return;
+	}
+
 	if (!Math::NearZero(mAngularSpeed))
 	{
 		Quaternion rotation = mOwner->GetQRotation();
@@ -29,4 +72,4 @@ void MoveComponent::Update(float deltaTime)
 		position += mOwner->GetForward() * mForwardSpeed * deltaTime;
 		mOwner->SetVec3Position(position);
 	}
-}
\ No newline at end of file
+}
@@ -1,18 +1,36 @@
 #pragma once
 #include "Component.h"
+#include "MovementSystem.h"
 
+// Turns about the up axis and moves along the owner's forward.
+// When the game has a MovementSystem the speeds live in its pool and
+// the system moves every owner at once before the other components
+// update (update order then only matters against other MoveComponents
+// without a system). Otherwise Update moves the owner itself.
 class MoveComponent : public Component
 {
 public:
 	// Lower update order to update first
 	MoveComponent(Actor* owner, int updateOrder = 10);
+	~MoveComponent();
 	void Update(float deltaTime) override;
+	ComponentAccess GetAccess() const override
+	{
+		if (mSystem)
+		{
+			return ComponentAccess::None();
+		}
+		return ComponentAccess::Owner(ComponentData::ETransform | ComponentData::EMovement, ComponentData::ETransform);
+	}
 
-	float GetAngularSpeed() const { return mAngularSpeed; }
-	float GetForwardSpeed() const { return mForwardSpeed; }
-	void SetAngularSpeed(float speed) { mAngularSpeed = speed; }
-	void SetForwardSpeed(float speed) { mForwardSpeed = speed; }
+	float GetAngularSpeed() const { return mSystem ? mSystem->Get(mMovement).mAngularSpeed : mAngularSpeed; }
+	float GetForwardSpeed() const { return mSystem ? mSystem->Get(mMovement).mForwardSpeed : mForwardSpeed; }
+	void SetAngularSpeed(float speed);
+	void SetForwardSpeed(float speed);
 private:
+	// Null when the speeds are kept here
+	class MovementSystem* mSystem;
+	SlotHandle mMovement;
 	float mAngularSpeed;
 	float mForwardSpeed;
-};
\ No newline at end of file
+};
@@ -0,0 +1,64 @@
+#include"MovementSystem.h"
+#include"Actor.h"
+#include"JobSystem.h"
+
+namespace
+{
+	// Movements per job
+	const size_t MoveGrain = 1024;
+}
+
+MovementSystem::MovementSystem(TransformStore* transforms, JobSystem* jobs)
+	:mTransforms(transforms)
+	, mJobs(jobs)
+{
+}
+
+SlotHandle MovementSystem::Create(Actor* owner, TransformHandle transform)
+{
+	Movement movement{ owner, transform, 0.0f, 0.0f };
+	return mPool.Insert(movement);
+}
+
+void MovementSystem::Update(float deltaTime)
+{
+	const Movement* data = mPool.GetData();
+	size_t count = mPool.GetCount();
+	if (mJobs && count > MoveGrain)
+	{
+		// Each movement sets only its own transform
+		mJobs->ParallelFor(0, count, MoveGrain, [this, data, deltaTime](size_t first, size_t last)
+		{
+			UpdateRange(data + first, data + last, deltaTime);
+		});
+	}
+	else
+	{
+		UpdateRange(data, data + count, deltaTime);
+	}
+}
+
+void MovementSystem::UpdateRange(const Movement* first, const Movement* last, float deltaTime)
+{
+	for (const Movement* move = first; move != last; move++)
+	{
+		if (move->mOwner->GetState() != Actor::State::EActive)
+		{
+			continue;
+		}
+		if (!Math::NearZero(move->mAngularSpeed))
+		{
+			// Rotate about up axis
+			Quaternion increment(Vector3::UnitZ, move->mAngularSpeed * deltaTime);
+			mTransforms->SetRotation(move->mTransform,
+				Quaternion::Concatenate(mTransforms->GetRotation(move->mTransform), increment));
+		}
+		if (!Math::NearZero(move->mForwardSpeed))
+		{
+			Vector3 forward = Vector3::Transform(Vector3::UnitX, mTransforms->GetRotation(move->mTransform));
+			Vector3 position = mTransforms->GetPosition(move->mTransform);
+			position += forward * move->mForwardSpeed * deltaTime;
+			mTransforms->SetPosition(move->mTransform, position);
+		}
+	}
+}
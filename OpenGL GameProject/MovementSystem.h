@@ -0,0 +1,39 @@
+#pragma once
+#include<cstddef>
+#include"SlotMap.h"
+#include"TransformStore.h"
+
+// Speeds of every MoveComponent in one dense pool, applied to the
+// TransformStore in a single loop (split across jobs when large)
+// instead of a virtual Update per component.
+class MovementSystem
+{
+public:
+	struct Movement
+	{
+		class Actor* mOwner;
+		TransformHandle mTransform;
+		float mAngularSpeed;
+		float mForwardSpeed;
+	};
+
+	// jobs may be null
+	MovementSystem(class TransformStore* transforms, class JobSystem* jobs);
+
+	SlotHandle Create(class Actor* owner, TransformHandle transform);
+	void Destroy(SlotHandle handle) { mPool.Remove(handle); }
+	Movement& Get(SlotHandle handle) { return *mPool.Get(handle); }
+	const Movement& Get(SlotHandle handle) const { return *mPool.Get(handle); }
+	size_t GetCount() const { return mPool.GetCount(); }
+
+	// Turn and move the transform of every active owner, as
+	// MoveComponent::Update does one at a time
+	void Update(float deltaTime);
+
+private:
+	void UpdateRange(const Movement* first, const Movement* last, float deltaTime);
+
+	SlotMap<Movement> mPool;
+	class TransformStore* mTransforms;
+	class JobSystem* mJobs;
+};
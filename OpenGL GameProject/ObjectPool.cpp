@@ -0,0 +1,191 @@
+#include"ObjectPool.h"
+#include<atomic>
+#include<mutex>
+#include<new>
+#include<vector>
+
+namespace
+{
+	const size_t NumClasses = ObjectPool::MaxSize / ObjectPool::Granularity;
+	// Free blocks a thread keeps per size, half move at a time
+	const unsigned int CacheSize = 32;
+
+	struct FreeBlock
+	{
+		FreeBlock* mNext;
+	};
+
+	struct SizeClass
+	{
+		std::mutex mMutex;
+		FreeBlock* mFree = nullptr;
+		std::vector<void*> mSlabs;
+	};
+
+	struct Pool
+	{
+		SizeClass mClasses[NumClasses];
+		std::atomic<size_t> mAllocations{ 0 };
+		std::atomic<size_t> mFrees{ 0 };
+		std::atomic<size_t> mSlabs{ 0 };
+		std::atomic<size_t> mHeapAllocations{ 0 };
+
+		~Pool()
+		{
+			for (SizeClass& sizeClass : mClasses)
+			{
+				for (void* slab : sizeClass.mSlabs)
+				{
+					::operator delete(slab);
+				}
+			}
+		}
+	};
+
+	Pool& GetPool()
+	{
+		static Pool pool;
+		return pool;
+	}
+
+	size_t GetClass(size_t size)
+	{
+		return (size + ObjectPool::Granularity - 1) / ObjectPool::Granularity - 1;
+	}
+
+	// Take up to count blocks off the shared list of index, carving a new
+	// slab if it is empty. Returns them linked, sets outCount.
+	FreeBlock* TakeBlocks(size_t index, unsigned int count, unsigned int& outCount)
+	{
+		Pool& pool = GetPool();
+		SizeClass& sizeClass = pool.mClasses[index];
+		std::lock_guard<std::mutex> lock(sizeClass.mMutex);
+		if (!sizeClass.mFree)
+		{
+			size_t blockSize = (index + 1) * ObjectPool::Granularity;
+			char* slab = static_cast<char*>(::operator new(ObjectPool::SlabSize));
+			sizeClass.mSlabs.emplace_back(slab);
+			pool.mSlabs++;
+			size_t numBlocks = ObjectPool::SlabSize / blockSize;
+			for (size_t i = numBlocks; i-- > 0;)
+			{
+				FreeBlock* block = reinterpret_cast<FreeBlock*>(slab + i * blockSize);
+				block->mNext = sizeClass.mFree;
+				sizeClass.mFree = block;
+			}
+		}
+		FreeBlock* first = sizeClass.mFree;
+		FreeBlock* last = first;
+		outCount = 1;
+		while (outCount < count && last->mNext)
+		{
+			last = last->mNext;
+			outCount++;
+		}
+		sizeClass.mFree = last->mNext;
+		last->mNext = nullptr;
+		return first;
+	}
+
+	// Put the linked blocks first..last back on the shared list of index
+	void ReturnBlocks(size_t index, FreeBlock* first, FreeBlock* last)
+	{
+		SizeClass& sizeClass = GetPool().mClasses[index];
+		std::lock_guard<std::mutex> lock(sizeClass.mMutex);
+		last->mNext = sizeClass.mFree;
+		sizeClass.mFree = first;
+	}
+
+	struct ThreadCache
+	{
+		FreeBlock* mBlocks[NumClasses] = {};
+		unsigned int mCounts[NumClasses] = {};
+
+		// Hand everything back when the thread exits
+		~ThreadCache()
+		{
+			for (size_t i = 0; i < NumClasses; i++)
+			{
+				if (mBlocks[i])
+				{
+					FreeBlock* last = mBlocks[i];
+					while (last->mNext)
+					{
+						last = last->mNext;
+					}
+					ReturnBlocks(i, mBlocks[i], last);
+				}
+			}
+		}
+	};
+
+	thread_local ThreadCache Cache;
+}
+
+void* ObjectPool::Allocate(size_t size)
+{
+	if (size > MaxSize)
+	{
+		GetPool().mHeapAllocations++;
+		return ::operator new(size);
+	}
+	size_t index = GetClass(size);
+	if (!Cache.mBlocks[index])
+	{
+		Cache.mBlocks[index] = TakeBlocks(index, CacheSize / 2, Cache.mCounts[index]);
+	}
+	FreeBlock* block = Cache.mBlocks[index];
+	Cache.mBlocks[index] = block->mNext;
+	Cache.mCounts[index]--;
+	GetPool().mAllocations.fetch_add(1, std::memory_order_relaxed);
+	return block;
+}
+
+void ObjectPool::Free(void* ptr, size_t size)
+{
+	if (!ptr)
+	{
+		return;
+	}
+	if (size > MaxSize)
+	{
+		::operator delete(ptr);
+		return;
+	}
+	size_t index = GetClass(size);
+	FreeBlock* block = static_cast<FreeBlock*>(ptr);
+	block->mNext = Cache.mBlocks[index];
+	Cache.mBlocks[index] = block;
+	Cache.mCounts[index]++;
+	GetPool().mFrees.fetch_add(1, std::memory_order_relaxed);
+	// Too many cached, keep the recently freed half and give the rest back
+	if (Cache.mCounts[index] > CacheSize)
+	{
+		FreeBlock* keep = block;
+		for (unsigned int i = 1; i < CacheSize / 2; i++)
+		{
+			keep = keep->mNext;
+		}
+		FreeBlock* first = keep->mNext;
+		FreeBlock* last = first;
+		while (last->mNext)
+		{
+			last = last->mNext;
+		}
+		keep->mNext = nullptr;
+		Cache.mCounts[index] = CacheSize / 2;
+		ReturnBlocks(index, first, last);
+	}
+}
+
+ObjectPool::Stats ObjectPool::GetStats()
+{
+	Pool& pool = GetPool();
+	Stats stats;
+	stats.mAllocations = pool.mAllocations.load();
+	stats.mFrees = pool.mFrees.load();
+	stats.mLive = stats.mAllocations - stats.mFrees;
+	stats.mSlabs = pool.mSlabs.load();
+	stats.mHeapAllocations = pool.mHeapAllocations.load();
+	return stats;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include<cstddef>
+
+// Slab allocator behind Actor's and Component's operator new/delete.
+// Objects are rounded up to a multiple of Granularity and taken from a
+// free list per size, filled a SlabSize block at a time, so spawning
+// and despawning reuses the same memory instead of going to the heap.
+// Each thread keeps a few free blocks of every size to skip the lock.
+// Blocks are never given back to the heap. Larger objects and builds
+// with NO_OBJECT_POOL use plain new/delete.
+namespace ObjectPool
+{
+	const size_t Granularity = 16;
+	const size_t MaxSize = 512;
+	const size_t SlabSize = 64 * 1024;
+
+	void* Allocate(size_t size);
+	// size must be the one passed to Allocate
+	void Free(void* ptr, size_t size);
+
+	struct Stats
+	{
+		// Objects allocated from and freed to the pool in total
+		size_t mAllocations;
+		size_t mFrees;
+		// Pooled objects alive now
+		size_t mLive;
+		// Slabs taken from the heap
+		size_t mSlabs;
+		// Objects over MaxSize, sent to the heap
+		size_t mHeapAllocations;
+	};
+	Stats GetStats();
+}
+
+// Route a class hierarchy's new/delete through the pool (the base needs
+// a virtual destructor so delete gets the derived size)
+#ifdef NO_OBJECT_POOL
+#define OBJECT_POOL_OPERATORS
+#else
+#define OBJECT_POOL_OPERATORS \
+	static void* operator new(size_t size) { return ObjectPool::Allocate(size); } \
+	static void operator delete(void* ptr, size_t size) { ObjectPool::Free(ptr, size); }
+#endif
@@ -10,7 +10,7 @@ out vec4 outColor;
 
 uniform sampler2D uTexture;
 
-// Create a struct for directional light
+// Per frame camera/lighting data (Renderer::UploadFrameData)
 struct DirectionalLight
 {
 	// Direction of light
@@ -21,16 +21,23 @@ struct DirectionalLight
 	vec3 mSpecColor;
 };
 
-// Uniforms for lighting
-// Camera position (in world space)
-uniform vec3 uCameraPosition;
+layout(std140, row_major) uniform FrameData
+{
+	mat4 uView;
+	mat4 uProjection;
+	mat4 uViewProjection;
+	// Screen space view-projection for sprites
+	mat4 uSpriteViewProj;
+	// Camera position (in world space)
+	vec3 uCameraPosition;
+	// Ambient light level
+	vec3 uAmbientLight;
+	// Directional Light
+	DirectionalLight uDirLight;
+};
+
 // Specular power for this surface
 uniform float uSpecPower;
-// Ambient light level
-uniform vec3 uAmbientLight;
-
-// Directional Light
-uniform DirectionalLight uDirLight;
 
 void main()
 {
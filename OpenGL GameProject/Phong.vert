@@ -1,8 +1,42 @@
 #version 330
 
-// Uniforms for world transform and view-proj
+// Per frame camera/lighting data (Renderer::UploadFrameData)
+struct DirectionalLight
+{
+	// Direction of light
+	vec3 mDirection;
+	// Diffuse color
+	vec3 mDiffuseColor;
+	// Specular color
+	vec3 mSpecColor;
+};
+
+layout(std140, row_major) uniform FrameData
+{
+	mat4 uView;
+	mat4 uProjection;
+	mat4 uViewProjection;
+	// Screen space view-projection for sprites
+	mat4 uSpriteViewProj;
+	// Camera position (in world space)
+	vec3 uCameraPosition;
+	// Ambient light level
+	vec3 uAmbientLight;
+	// Directional Light
+	DirectionalLight uDirLight;
+};
+
+// Uniform for world transform
 uniform mat4 uWorldTransform;
-uniform mat4 uViewProjection;
+
+// Vertex decoding (see VertexFormat.h), normalized positions
+// and uvs are rescaled to mesh space
+uniform vec3 uPosScale;
+uniform vec3 uPosOffset;
+uniform vec2 uUVScale;
+uniform vec2 uUVOffset;
+// 1 if inNormal.xy is an octahedral encoded normal
+uniform float uOctNormals;
 
 // Attribute 0 is position, 1 is normal, 2 is tex coords.
 layout(location = 0) in vec3 inPosition;
@@ -18,10 +52,18 @@ out vec3 fragNormal;
 // Position (in world space)
 out vec3 fragWorldPos;
 
+vec3 OctDecode(vec2 oct)
+{
+	vec3 n = vec3(oct, 1.0 - abs(oct.x) - abs(oct.y));
+	float t = max(-n.z, 0.0);
+	n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+	return normalize(n);
+}
+
 void main()
 {
 	//Convert position
-	vec4 position = vec4(inPosition, 1.0);
+	vec4 position = vec4(inPosition * uPosScale + uPosOffset, 1.0);
 
 	//Transform position to world space
 	position = position * uWorldTransform;
@@ -33,8 +75,9 @@ void main()
 	gl_Position = position * uViewProjection;
 
 	//Transform normal into world space (w = 0)
-	fragNormal = (vec4(inNormal, 0.0f) * uWorldTransform).xyz;
+	vec3 normal = uOctNormals > 0.5 ? OctDecode(inNormal.xy) : inNormal;
+	fragNormal = (vec4(normal, 0.0f) * uWorldTransform).xyz;
 
 	//Pass along the texture coordinate to frag shader
-	fragTexCoord = inTexCoord;
+	fragTexCoord = inTexCoord * uUVScale + uUVOffset;
 }
\ No newline at end of file
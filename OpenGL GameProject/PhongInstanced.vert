@@ -0,0 +1,91 @@
+#version 330
+
+// Phong.vert with the world transform read per instance
+
+// Per frame camera/lighting data (Renderer::UploadFrameData)
+struct DirectionalLight
+{
+	// Direction of light
+	vec3 mDirection;
+	// Diffuse color
+	vec3 mDiffuseColor;
+	// Specular color
+	vec3 mSpecColor;
+};
+
+layout(std140, row_major) uniform FrameData
+{
+	mat4 uView;
+	mat4 uProjection;
+	mat4 uViewProjection;
+	// Screen space view-projection for sprites
+	mat4 uSpriteViewProj;
+	// Camera position (in world space)
+	vec3 uCameraPosition;
+	// Ambient light level
+	vec3 uAmbientLight;
+	// Directional Light
+	DirectionalLight uDirLight;
+};
+
+
+// Vertex decoding (see VertexFormat.h), normalized positions
+// and uvs are rescaled to mesh space
+uniform vec3 uPosScale;
+uniform vec3 uPosOffset;
+uniform vec2 uUVScale;
+uniform vec2 uUVOffset;
+// 1 if inNormal.xy is an octahedral encoded normal
+uniform float uOctNormals;
+
+// Attribute 0 is position, 1 is normal, 2 is tex coords.
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inNormal;
+layout(location = 2) in vec2 inTexCoord;
+// Attributes 3-6 are the rows of the per instance world transform
+layout(location = 3) in vec4 inWorldRow0;
+layout(location = 4) in vec4 inWorldRow1;
+layout(location = 5) in vec4 inWorldRow2;
+layout(location = 6) in vec4 inWorldRow3;
+
+// Any vertex outputs (other than position)
+out vec2 fragTexCoord;
+
+// Normal (in world space)
+out vec3 fragNormal;
+
+// Position (in world space)
+out vec3 fragWorldPos;
+
+vec3 OctDecode(vec2 oct)
+{
+	vec3 n = vec3(oct, 1.0 - abs(oct.x) - abs(oct.y));
+	float t = max(-n.z, 0.0);
+	n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+	return normalize(n);
+}
+
+void main()
+{
+	// mat4() takes columns, transpose to get the same matrix as uWorldTransform
+	mat4 world = transpose(mat4(inWorldRow0, inWorldRow1, inWorldRow2, inWorldRow3));
+
+	//Convert position
+	vec4 position = vec4(inPosition * uPosScale + uPosOffset, 1.0);
+
+	//Transform position to world space
+	position = position * world;
+
+	//Save world position
+	fragWorldPos = position.xyz;
+
+	//Transform to clip space
+	gl_Position = position * uViewProjection;
+
+	//Transform normal into world space (w = 0)
+	vec3 normal = uOctNormals > 0.5 ? OctDecode(inNormal.xy) : inNormal;
+	fragNormal = (vec4(normal, 0.0f) * world).xyz;
+
+	//Pass along the texture coordinate to frag shader
+	fragTexCoord = inTexCoord * uUVScale + uUVOffset;
+}
\ No newline at end of file
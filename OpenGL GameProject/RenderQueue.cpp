@@ -0,0 +1,228 @@
+#include"RenderQueue.h"
+#include<glew.h>
+#include"Shader.h"
+#include"Texture.h"
+#include"VertexArray.h"
+#include"Mesh.h"
+
+namespace
+{
+	const unsigned int PassBits = 4;
+	const unsigned int ShaderBits = 8;
+	const unsigned int TextureBits = 16;
+	const unsigned int VertexArrayBits = 16;
+	const unsigned int DepthBits = 20;
+	const unsigned int OrderBits = 16;
+
+	uint64_t Field(uint64_t value, unsigned int bits)
+	{
+		return value & ((uint64_t(1) << bits) - 1);
+	}
+
+	// GL names are small, the low bits are enough to group draws
+	// (execution compares the objects themselves)
+	uint64_t StateBits(const RenderQueue::Command& command)
+	{
+		uint64_t shader = command.mShader ? command.mShader->GetProgram() : 0;
+		uint64_t texture = command.mTexture ? command.mTexture->GetTextureID() : 0;
+		uint64_t va = command.mVertexArray ? command.mVertexArray->GetID() : 0;
+		return (Field(shader, ShaderBits) << (TextureBits + VertexArrayBits)) |
+			(Field(texture, TextureBits) << VertexArrayBits) |
+			Field(va, VertexArrayBits);
+	}
+
+	const unsigned int StateBitCount = ShaderBits + TextureBits + VertexArrayBits;
+	static_assert(PassBits + StateBitCount + DepthBits <= 64, "Opaque key overflows 64 bits");
+	static_assert(PassBits + OrderBits + StateBitCount <= 64, "Sprite key overflows 64 bits");
+
+	uint64_t PassField(RenderQueue::Pass pass)
+	{
+		return Field(static_cast<uint64_t>(pass), PassBits) << (64 - PassBits);
+	}
+}
+
+RenderQueue::RenderQueue()
+{
+}
+
+void RenderQueue::Clear()
+{
+	mEntries.clear();
+	mCommands.clear();
+	mTransforms.clear();
+}
+
+unsigned int RenderQueue::AddTransform(const Matrix4& transform)
+{
+	mTransforms.emplace_back(transform);
+	return static_cast<unsigned int>(mTransforms.size() - 1);
+}
+
+void RenderQueue::Submit(uint64_t key, const Command& command)
+{
+	Entry entry;
+	entry.mKey = key;
+	entry.mCommand = static_cast<uint32_t>(mCommands.size());
+	mEntries.emplace_back(entry);
+	mCommands.emplace_back(command);
+}
+
+uint64_t RenderQueue::MakeOpaqueKey(const Command& command, float depth)
+{
+	uint64_t maxDepth = (uint64_t(1) << DepthBits) - 1;
+	uint64_t d = static_cast<uint64_t>(Math::Clamp(depth, 0.0f, 1.0f) * maxDepth);
+	return PassField(Pass::EOpaque) | (StateBits(command) << DepthBits) | d;
+}
+
+uint64_t RenderQueue::MakeSpriteKey(const Command& command, int drawOrder)
+{
+	// Bias so negative draw orders still sort first
+	int order = Math::Clamp(drawOrder + 32768, 0, 65535);
+	return PassField(Pass::ESprite) |
+		(Field(static_cast<uint64_t>(order), OrderBits) << StateBitCount) |
+		StateBits(command);
+}
+
+void RenderQueue::Sort()
+{
+	// LSD radix sort, one byte per pass. Stable, so equal keys keep
+	// their submission order.
+	mScratch.resize(mEntries.size());
+	for (unsigned int shift = 0; shift < 64; shift += 8)
+	{
+		size_t counts[256] = {};
+		for (const Entry& e : mEntries)
+		{
+			counts[(e.mKey >> shift) & 0xFF]++;
+		}
+		// Every key shares this byte, nothing to move
+		if (counts[(mEntries.empty() ? 0 : mEntries[0].mKey >> shift) & 0xFF] == mEntries.size())
+		{
+			continue;
+		}
+
+		size_t offset = 0;
+		for (size_t& count : counts)
+		{
+			size_t c = count;
+			count = offset;
+			offset += c;
+		}
+		for (const Entry& e : mEntries)
+		{
+			mScratch[counts[(e.mKey >> shift) & 0xFF]++] = e;
+		}
+		mEntries.swap(mScratch);
+	}
+}
+
+void RenderQueue::SetPassState(Pass pass)
+{
+	switch (pass)
+	{
+	case Pass::EOpaque:
+		// Enable depth buffering/disable alpha blend
+		glEnable(GL_DEPTH_TEST);
+		glDisable(GL_BLEND);
+		break;
+	case Pass::ESprite:
+		// Disable depth buffering/enable alpha blending on the color buffer
+		glDisable(GL_DEPTH_TEST);
+		glEnable(GL_BLEND);
+		glBlendEquationSeparate(GL_FUNC_ADD, GL_FUNC_ADD);
+		glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ZERO);
+		break;
+	}
+}
+
+void RenderQueue::Execute(unsigned int instanceBuffer)
+{
+	mStats = Stats();
+
+	bool havePass = false;
+	uint64_t pass = 0;
+	Shader* shader = nullptr;
+	Texture* texture = nullptr;
+	VertexArray* va = nullptr;
+	Mesh* mesh = nullptr;
+	for (const Entry& e : mEntries)
+	{
+		const Command& cmd = mCommands[e.mCommand];
+
+		uint64_t entryPass = e.mKey >> (64 - PassBits);
+		if (!havePass || entryPass != pass)
+		{
+			SetPassState(static_cast<Pass>(entryPass));
+			havePass = true;
+			pass = entryPass;
+		}
+
+		if (cmd.mShader != shader)
+		{
+			cmd.mShader->SetActive();
+			shader = cmd.mShader;
+			// Mesh uniforms belong to the previous program
+			mesh = nullptr;
+			mStats.mShaderBinds++;
+		}
+		else
+		{
+			mStats.mSkippedBinds++;
+		}
+
+		if (cmd.mTexture)
+		{
+			if (cmd.mTexture != texture)
+			{
+				cmd.mTexture->SetActive();
+				texture = cmd.mTexture;
+				mStats.mTextureBinds++;
+			}
+			else
+			{
+				mStats.mSkippedBinds++;
+			}
+		}
+
+		if (cmd.mVertexArray != va)
+		{
+			cmd.mVertexArray->SetActive();
+			va = cmd.mVertexArray;
+			mStats.mVertexArrayBinds++;
+		}
+		else
+		{
+			mStats.mSkippedBinds++;
+		}
+
+		if (cmd.mMesh && cmd.mMeshUniforms)
+		{
+			if (cmd.mMesh != mesh)
+			{
+				MeshComponent::SetMeshUniforms(shader, *cmd.mMeshUniforms, cmd.mMesh);
+				mesh = cmd.mMesh;
+				mStats.mMeshBinds++;
+			}
+			else
+			{
+				mStats.mSkippedBinds++;
+			}
+		}
+
+		if (cmd.mInstanceCount > 0)
+		{
+			// No base instance in GL 3.3, point the attributes at this range instead
+			va->SetInstanceData(instanceBuffer, cmd.mInstanceStart * sizeof(Matrix4));
+			glDrawElementsInstanced(GL_TRIANGLES, va->GetNumIndices(), GL_UNSIGNED_INT, nullptr,
+				static_cast<GLsizei>(cmd.mInstanceCount));
+		}
+		else
+		{
+			shader->SetUniform(cmd.mWorldUniform, mTransforms[cmd.mTransform]);
+			GLsizei count = static_cast<GLsizei>(cmd.mIndexCount > 0 ? cmd.mIndexCount : va->GetNumIndices());
+			glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT,
+				reinterpret_cast<void*>(cmd.mIndexStart * sizeof(unsigned int)));
+		}
+		mStats.mDrawCalls++;
+	}
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include<cstdint>
+#include<vector>
+#include"Math.h"
+#include"MeshComponent.h"
+
+// Every draw of a frame as a 64-bit sort key plus a command. The queue
+// is radix sorted and executed with redundant state changes skipped.
+//
+// Key layout (high to low bits):
+//   opaque: pass 4 | shader 8 | texture 16 | vertex array 16 | depth 20
+//   sprite: pass 4 | draw order 16 | shader 8 | texture 16 | vertex array 16
+// Opaque draws group by state and go front to back within a state,
+// sprites keep their draw order for blending.
+class RenderQueue
+{
+public:
+	enum class Pass
+	{
+		EOpaque = 0,
+		ESprite = 1
+	};
+
+	struct Command
+	{
+		class Shader* mShader = nullptr;
+		// nullptr keeps whatever texture is bound
+		class Texture* mTexture = nullptr;
+		class VertexArray* mVertexArray = nullptr;
+		// Per mesh uniforms, set when the mesh changes (nullptr for sprites)
+		class Mesh* mMesh = nullptr;
+		const MeshComponent::Uniforms* mMeshUniforms = nullptr;
+		// Plain draws: world transform set from AddTransform's index
+		UniformHandle<Matrix4> mWorldUniform;
+		unsigned int mTransform = 0;
+		// Instanced draws: range of the instance buffer (count 0 for plain draws)
+		unsigned int mInstanceStart = 0;
+		unsigned int mInstanceCount = 0;
+		// Plain draws: range of the index buffer (count 0 draws all of it)
+		unsigned int mIndexStart = 0;
+		unsigned int mIndexCount = 0;
+	};
+
+	struct Stats
+	{
+		unsigned int mDrawCalls = 0;
+		unsigned int mShaderBinds = 0;
+		unsigned int mTextureBinds = 0;
+		unsigned int mVertexArrayBinds = 0;
+		unsigned int mMeshBinds = 0;
+		// Binds that were already current and not issued
+		unsigned int mSkippedBinds = 0;
+	};
+
+	RenderQueue();
+
+	void Clear();
+	// Store a world transform for Command::mTransform, returns its index
+	unsigned int AddTransform(const Matrix4& transform);
+	void Submit(uint64_t key, const Command& command);
+	// depth is the normalized distance from the camera (0 nearest)
+	static uint64_t MakeOpaqueKey(const Command& command, float depth);
+	static uint64_t MakeSpriteKey(const Command& command, int drawOrder);
+
+	// Radix sort the submitted keys
+	void Sort();
+	// Issue the draws in key order, instanced draws read instanceBuffer
+	void Execute(unsigned int instanceBuffer);
+
+	size_t GetNumCommands() const { return mEntries.size(); }
+	const Stats& GetStats() const { return mStats; }
+
+private:
+	struct Entry
+	{
+		uint64_t mKey;
+		uint32_t mCommand;
+	};
+
+	// Depth/blend state of a pass
+	static void SetPassState(Pass pass);
+
+	std::vector<Entry> mEntries;
+	std::vector<Entry> mScratch;
+	std::vector<Command> mCommands;
+	std::vector<Matrix4> mTransforms;
+	Stats mStats;
+};
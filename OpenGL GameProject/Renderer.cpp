@@ -1,23 +1,49 @@
 #include<algorithm>
+#include<functional>
 #include<glew.h>
 #include"Renderer.h"
 #include"Texture.h"
 #include"Mesh.h"
+#include"MeshFile.h"
 #include"Shader.h"
+#include"UniformBuffer.h"
+#include"InstanceBuffer.h"
+#include"Actor.h"
 #include"VertexArray.h"
 #include"SpriteComponent.h"
+#include"SpriteBatch.h"
 #include"MeshComponent.h"
+#include"AABBTree.h"
+#include"Game.h"
+#include"AssetLoader.h"
 
+namespace
+{
+	const float NearPlane = 25.0f;
+	const float FarPlane = 10000.0f;
+	// Decoding is mostly file reads, a couple of threads keep the disk busy
+	const unsigned int LoaderThreads = 2;
+}
 
 Renderer::Renderer(Game* game)
-	:mGame(game)
+	:mAssetLoader(nullptr)
+	, mGame(game)
 	, mSpriteShader(nullptr)
+	, mSpriteBatch(nullptr)
 	, mMeshShader(nullptr)
-	, mContext(nullptr)
-	, mSpriteVerts(nullptr)
-	, mWindow(nullptr)
+	, mInstancedShader(nullptr)
+	, mInstanceBuffer(nullptr)
+	, mInstancing(true)
+	, mVisibleMeshes(0)
+	, mCulledMeshes(0)
+	, mUniformLookups(0)
+	, mFrameBuffer(nullptr)
 	, mScreenWidth(0)
 	, mScreenHeight(0)
+	, mVSync(false)
+	, mRefreshRate(60)
+	, mWindow(nullptr)
+	, mContext(nullptr)
 {
 }
 
@@ -70,6 +96,14 @@ bool Renderer::Initialize(float screenWidth, float screenHeight)
 	// so clear it
 	glGetError();
 
+	// Let the swap wait for the display instead of the game loop spinning
+	mVSync = SDL_GL_SetSwapInterval(1) == 0;
+	SDL_DisplayMode mode;
+	if (SDL_GetCurrentDisplayMode(SDL_GetWindowDisplayIndex(mWindow), &mode) == 0 && mode.refresh_rate > 0)
+	{
+		mRefreshRate = mode.refresh_rate;
+	}
+
 	// Make sure we can create/compile shaders
 	if (!LoadShaders())
 	{
@@ -77,25 +111,37 @@ bool Renderer::Initialize(float screenWidth, float screenHeight)
 		return false;
 	}
 
-	// Create quad for drawing sprites
-	CreateSpriteVerts();
+	mSpriteBatch = new SpriteBatch();
+	mAssetLoader = new AssetLoader(this, LoaderThreads);
 
 	return true;
 }
 
 void Renderer::Shutdown()
 {
-	delete mSpriteVerts;
+	delete mAssetLoader;
+	mAssetLoader = nullptr;
+	delete mSpriteBatch;
 	mSpriteShader->Unload();
 	delete mSpriteShader;
 	mMeshShader->Unload();
 	delete mMeshShader;
+	mInstancedShader->Unload();
+	delete mInstancedShader;
+	delete mInstanceBuffer;
+	delete mFrameBuffer;
 	SDL_GL_DeleteContext(mContext);
 	SDL_DestroyWindow(mWindow);
 }
 
 void Renderer::UnloadData()
 {
+	// Nothing may still be loading into the assets deleted below
+	if (mAssetLoader)
+	{
+		mAssetLoader->Clear();
+	}
+
 	// Destroy textures
 	for (auto i : mTextures)
 	{
@@ -111,6 +157,9 @@ void Renderer::UnloadData()
 		delete i.second;
 	}
 	mMeshes.clear();
+
+	// Sprite atlas pages
+	mSpriteAtlas.Unload();
 }
 
 void Renderer::Draw()
@@ -120,77 +169,50 @@ void Renderer::Draw()
 	// Clear the color buffer
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-	// Draw mesh components
-	// Enable depth buffering/disable alpha blend
-	glEnable(GL_DEPTH_TEST);
-	glDisable(GL_BLEND);
-	
-	// Set the mesh shader active
-	mMeshShader->SetActive();
-	// Update view-projection matrix
-	mMeshShader->SetMatrixUniform("uViewProjection", mView * mProjection);
-	// Update lighting uniforms
-	SetLightUniforms(mMeshShader);
-	for (auto mc : mMeshComps)
-	{
-		mc->Draw(mMeshShader);
-	}
+	// Per frame uniforms only go through pre-resolved handles
+	Shader::ResetNumLookups();
 
-	// Draw all sprite components
-	// Disable depth buffering
-	glDisable(GL_DEPTH_TEST);
-	// Enable alpha blending on the color buffer
-	glEnable(GL_BLEND);
-	glBlendEquationSeparate(GL_FUNC_ADD, GL_FUNC_ADD);
-	glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ZERO);
+	// Camera and lighting for every shader
+	UploadFrameData();
 
-	// Set shader/vao as active
-	mSpriteShader->SetActive();
-	mSpriteVerts->SetActive();
-	for (auto sprite : mSprites)
+	// GL objects of assets decoded since the last frame, within budget
+	if (mAssetLoader->Upload(AssetLoader::UploadBudget, mLoadedMeshes) > 0 &&
+		mAssetLoader->GetNumPending() == 0)
+	{
+		const AssetLoader::Stats& stats = mAssetLoader->GetStats();
+		SDL_Log("Assets loaded: %zu textures, %zu meshes, %zu failed, %.1f MB uploaded",
+			stats.mTextures, stats.mMeshes, stats.mFailed, stats.mUploadedBytes / (1024.0 * 1024.0));
+	}
+	OnMeshesLoaded();
+
+	// Meshes then sprites, the queue sets the depth/blend state of each pass
+	mRenderQueue.Clear();
+	CullMeshes();
+	SubmitMeshes();
+	SubmitSprites();
+	mRenderQueue.Sort();
+	mRenderQueue.Execute(mInstanceBuffer->GetBuffer());
+
+#ifdef _DEBUG
+	if (Shader::GetNumLookups() != mUniformLookups)
 	{
-		sprite->Draw(mSpriteShader);
+		SDL_Log("Uniform lookups per frame: %u", Shader::GetNumLookups());
 	}
+#endif
+	mUniformLookups = Shader::GetNumLookups();
 
 	// Swap the buffers
 	SDL_GL_SwapWindow(mWindow);
 }
 
-void Renderer::AddSprite(SpriteComponent* sprite)
+SlotHandle Renderer::AddMeshComp(MeshComponent* mesh)
 {
-	// Find the insertion point in the sorted vector
-	// (The first element with a higher draw order than me)
-	int myDrawOrder = sprite->GetDrawOrder();
-	auto iter = mSprites.begin();
-	for (;
-		iter != mSprites.end();
-		++iter)
-	{
-		if (myDrawOrder < (*iter)->GetDrawOrder())
-		{
-			break;
-		}
-	}
-
-	// Inserts element before position of iterator
-	mSprites.insert(iter, sprite);
-}
-
-void Renderer::RemoveSprite(SpriteComponent* sprite)
-{
-	auto iter = std::find(mSprites.begin(), mSprites.end(), sprite);
-	mSprites.erase(iter);
-}
-
-void Renderer::AddMeshComp(MeshComponent* mesh)
-{
-	mMeshComps.emplace_back(mesh);
+	return mMeshComps.Insert(mesh);
 }
 
-void Renderer::RemoveMeshComp(MeshComponent* mesh)
+void Renderer::RemoveMeshComp(SlotHandle mesh)
 {
-	auto iter = std::find(mMeshComps.begin(), mMeshComps.end(), mesh);
-	mMeshComps.erase(iter);
+	mMeshComps.Remove(mesh);
 }
 
 Texture* Renderer::GetTexture(const std::string& fileName)
@@ -228,7 +250,8 @@ Mesh* Renderer::GetMesh(const std::string& fileName)
 	else
 	{
 		m = new Mesh();
-		if (m->Load(fileName, this))
+		MeshSource source;
+		if (Mesh::Decode(fileName, source) && m->Create(source, fileName, this))
 		{
 			mMeshes.emplace(fileName, m);
 		}
@@ -252,7 +275,8 @@ Mesh* Renderer::GetFBXMesh(const char* fileName)
 	else
 	{
 		m = new Mesh();
-		if (m->LoadFBX(fileName, this))
+		MeshSource source;
+		if (Mesh::DecodeFBX(fileName, source) && m->Create(source, fileName, this))
 		{
 			mMeshes.emplace(fileName, m);
 		}
@@ -265,19 +289,93 @@ Mesh* Renderer::GetFBXMesh(const char* fileName)
 	return m;
 }
 
+Texture* Renderer::GetTextureAsync(const std::string& fileName)
+{
+	auto iter = mTextures.find(fileName);
+	if (iter != mTextures.end())
+	{
+		return iter->second;
+	}
+	Texture* tex = new Texture();
+	tex->CreatePlaceholder();
+	mTextures.emplace(fileName, tex);
+	mAssetLoader->LoadTexture(tex, fileName);
+	return tex;
+}
+
+Mesh* Renderer::GetMeshAsync(const std::string& fileName)
+{
+	auto iter = mMeshes.find(fileName);
+	if (iter != mMeshes.end())
+	{
+		return iter->second;
+	}
+	Mesh* m = new Mesh();
+	mMeshes.emplace(fileName, m);
+	mAssetLoader->LoadMesh(m, fileName, false);
+	return m;
+}
+
+Mesh* Renderer::GetFBXMeshAsync(const std::string& fileName)
+{
+	auto iter = mMeshes.find(fileName);
+	if (iter != mMeshes.end())
+	{
+		return iter->second;
+	}
+	Mesh* m = new Mesh();
+	mMeshes.emplace(fileName, m);
+	mAssetLoader->LoadMesh(m, fileName, true);
+	return m;
+}
+
+void Renderer::FinishLoading()
+{
+	mAssetLoader->Flush(mLoadedMeshes);
+	OnMeshesLoaded();
+}
+
+size_t Renderer::GetNumPendingAssets() const
+{
+	return mAssetLoader ? mAssetLoader->GetNumPending() : 0;
+}
+
+void Renderer::OnMeshesLoaded()
+{
+	if (mLoadedMeshes.empty())
+	{
+		return;
+	}
+	// Components got the mesh while it had no radius
+	for (MeshComponent* mc : mMeshComps)
+	{
+		if (std::find(mLoadedMeshes.begin(), mLoadedMeshes.end(), mc->GetMesh()) != mLoadedMeshes.end())
+		{
+			mc->SetMesh(mc->GetMesh());
+		}
+	}
+	mLoadedMeshes.clear();
+}
+
 bool Renderer::LoadShaders()
 {
+	// Default camera
+	mView = Matrix4::CreateLookAt(Vector3::Zero, Vector3::UnitX, Vector3::UnitZ);
+	mProjection = Matrix4::CreatePerspectiveFOV(Math::ToRadians(70.0f),
+		mScreenWidth, mScreenHeight, NearPlane, FarPlane);
+	mSpriteViewProj = Matrix4::CreateSimpleViewProj(mScreenWidth, mScreenHeight);
+
+	// Size the frame buffer by packing the block once
+	UploadFrameData();
+
 	// Create sprite shader
 	mSpriteShader = new Shader();
 	if (!mSpriteShader->Load("Sprite.vert", "Sprite.frag"))
 	{
 		return false;
 	}
-
-	mSpriteShader->SetActive();
-	// Set the view-projection matrix
-	Matrix4 viewProj = Matrix4::CreateSimpleViewProj(mScreenWidth, mScreenHeight);
-	mSpriteShader->SetMatrixUniform("uViewProjection", viewProj);
+	mSpriteShader->BindUniformBlock("FrameData", *mFrameBuffer);
+	mSpriteUniforms.Resolve(mSpriteShader);
 
 	// Create basic mesh shader
 	mMeshShader = new Shader();
@@ -285,43 +383,203 @@ bool Renderer::LoadShaders()
 	{
 		return false;
 	}
+	mMeshShader->BindUniformBlock("FrameData", *mFrameBuffer);
+	mMeshUniforms.Resolve(mMeshShader);
 
-	mMeshShader->SetActive();
-	// Set the view-projection matrix
-	mView = Matrix4::CreateLookAt(Vector3::Zero, Vector3::UnitX, Vector3::UnitZ);
-	mProjection = Matrix4::CreatePerspectiveFOV(Math::ToRadians(70.0f),
-		mScreenWidth, mScreenHeight, 25.0f, 10000.0f);
-	mMeshShader->SetMatrixUniform("uViewProjection", mView * mProjection);
+	// Same lighting, world transform per instance
+	mInstancedShader = new Shader();
+	if (!mInstancedShader->Load("PhongInstanced.vert", "Phong.frag"))
+	{
+		return false;
+	}
+	mInstancedShader->BindUniformBlock("FrameData", *mFrameBuffer);
+	mInstancedUniforms.Resolve(mInstancedShader);
+	mInstanceBuffer = new InstanceBuffer();
 	return true;
 }
 
-void Renderer::CreateSpriteVerts()
-{
-	float vertices[] = {
-		-0.5f, 0.5f, 0.f, 0.f, 0.f, 0.0f, 0.f, 0.f, // top left
-		0.5f, 0.5f, 0.f, 0.f, 0.f, 0.0f, 1.f, 0.f, // top right
-		0.5f,-0.5f, 0.f, 0.f, 0.f, 0.0f, 1.f, 1.f, // bottom right
-		-0.5f,-0.5f, 0.f, 0.f, 0.f, 0.0f, 0.f, 1.f  // bottom left
-	};
-
-	unsigned int indices[] = {
-		0, 1, 2,
-		2, 3, 0
-	};
-
-	mSpriteVerts = new VertexArray(vertices, 4, indices, 6);
-} 
-
-void Renderer::SetLightUniforms(Shader* shader)
+const Std140Packer& Renderer::PackFrameData()
 {
 	// Camera position is from inverted view
 	Matrix4 invView = mView;
 	invView.Invert();
-	shader->SetVectorUniform("uCameraPosition", invView.GetTranslation());
-	// Ambient light
-	shader->SetVectorUniform("uAmbientLight", mAmbientLight);
-	// Directional light
-	shader->SetVectorUniform("uDirLight.mDirection", mDirLight.mDirection);
-	shader->SetVectorUniform("uDirLight.mDiffuseColor", mDirLight.mDiffuseColor);
-	shader->SetVectorUniform("uDirLight.mSpecColor", mDirLight.mSpecColor);
+	mCameraPos = invView.GetTranslation();
+
+	// Must match the FrameData block in the shaders
+	mFrameData.Reset();
+	mFrameData.Mat4(mView);
+	mFrameData.Mat4(mProjection);
+	mFrameData.Mat4(mView * mProjection);
+	mFrameData.Mat4(mSpriteViewProj);
+	mFrameData.Vec3(mCameraPos);
+	mFrameData.Vec3(mAmbientLight);
+	mFrameData.BeginStruct();
+	mFrameData.Vec3(mDirLight.mDirection);
+	mFrameData.Vec3(mDirLight.mDiffuseColor);
+	mFrameData.Vec3(mDirLight.mSpecColor);
+	mFrameData.EndStruct();
+	mFrameData.End();
+	return mFrameData;
+}
+
+void Renderer::UploadFrameData()
+{
+	PackFrameData();
+	if (!mFrameBuffer)
+	{
+		mFrameBuffer = new UniformBuffer(mFrameData.GetSize(), UniformBuffer::FrameDataBinding);
+	}
+	mFrameBuffer->Update(mFrameData.GetData(), mFrameData.GetSize());
+}
+
+float Renderer::GetDepth(const Vector3& position) const
+{
+	return (position - mCameraPos).Length() / FarPlane;
+}
+
+void Renderer::CullMeshes()
+{
+	mFrustum.SetFromViewProj(mView * mProjection);
+
+	// The tree rejects whole subtrees by their fat boxes, the candidates
+	// are then tested by their exact spheres
+	AABBTree* tree = mGame->GetSpatialTree();
+	mCullSpheres.Clear();
+	mCullComps.clear();
+	tree->QueryFrustum(mFrustum, [this, tree](int proxy)
+	{
+		MeshComponent* mc = static_cast<MeshComponent*>(tree->GetUserData(proxy));
+		Vector3 center;
+		float radius;
+		if (mc->GetWorldSphere(center, radius))
+		{
+			mCullSpheres.Add(center, radius);
+			mCullComps.emplace_back(mc);
+		}
+		return true;
+	});
+
+	mVisibleMeshes = static_cast<unsigned int>(mFrustum.CullSpheres(mCullSpheres, mCullResults));
+	mCulledMeshes = static_cast<unsigned int>(tree->GetProxyCount()) - mVisibleMeshes;
+
+	mVisibleMeshComps.clear();
+	for (size_t i = 0; i < mCullComps.size(); i++)
+	{
+		if (mCullResults[i])
+		{
+			mVisibleMeshComps.emplace_back(mCullComps[i]);
+		}
+	}
+}
+
+void Renderer::SubmitMeshes()
+{
+	if (!mInstancing)
+	{
+		// One draw per component and sub mesh
+		for (auto mc : mVisibleMeshComps)
+		{
+			Mesh* mesh = mc->GetMesh();
+			RenderQueue::Command cmd;
+			cmd.mShader = mMeshShader;
+			cmd.mMesh = mesh;
+			cmd.mMeshUniforms = &mMeshUniforms;
+			cmd.mWorldUniform = mMeshUniforms.mWorldTransform;
+			cmd.mTransform = mRenderQueue.AddTransform(mc->GetOwner()->GetRenderTransform());
+			float depth = GetDepth(mc->GetOwner()->GetRenderTransform().GetTranslation());
+			const std::vector<VertexArray*>& va = mesh->GetVertexArray();
+			for (size_t i = 0; i < va.size(); i++)
+			{
+				// Sub meshes with their own material override the component's texture
+				cmd.mTexture = mesh->GetDrawTexture(i, mc->GetTextureIndex());
+				cmd.mVertexArray = va[i];
+				mRenderQueue.Submit(RenderQueue::MakeOpaqueKey(cmd, depth), cmd);
+			}
+		}
+		return;
+	}
+
+	// Components drawing the same mesh with the same texture end up adjacent
+	mInstanceQueue = mVisibleMeshComps;
+	if (mInstanceQueue.empty())
+	{
+		return;
+	}
+	std::sort(mInstanceQueue.begin(), mInstanceQueue.end(),
+		[](const MeshComponent* a, const MeshComponent* b)
+	{
+		if (a->GetMesh() != b->GetMesh())
+		{
+			return std::less<Mesh*>()(a->GetMesh(), b->GetMesh());
+		}
+		return a->GetTextureIndex() < b->GetTextureIndex();
+	});
+
+	// One upload holds the transforms of every group
+	mInstanceTransforms.clear();
+	for (auto mc : mInstanceQueue)
+	{
+		mInstanceTransforms.emplace_back(mc->GetOwner()->GetRenderTransform());
+	}
+	mInstanceBuffer->Upload(mInstanceTransforms.data(), mInstanceTransforms.size());
+
+	size_t start = 0;
+	while (start < mInstanceQueue.size())
+	{
+		Mesh* mesh = mInstanceQueue[start]->GetMesh();
+		size_t textureIndex = mInstanceQueue[start]->GetTextureIndex();
+		// A group sorts by its nearest instance
+		float depth = GetDepth(mInstanceQueue[start]->GetOwner()->GetRenderTransform().GetTranslation());
+		size_t end = start + 1;
+		while (end < mInstanceQueue.size() && mInstanceQueue[end]->GetMesh() == mesh &&
+			mInstanceQueue[end]->GetTextureIndex() == textureIndex)
+		{
+			depth = Math::Min(depth, GetDepth(mInstanceQueue[end]->GetOwner()->GetRenderTransform().GetTranslation()));
+			end++;
+		}
+
+		RenderQueue::Command cmd;
+		cmd.mShader = mInstancedShader;
+		cmd.mMesh = mesh;
+		cmd.mMeshUniforms = &mInstancedUniforms;
+		cmd.mInstanceStart = static_cast<unsigned int>(start);
+		cmd.mInstanceCount = static_cast<unsigned int>(end - start);
+		const std::vector<VertexArray*>& va = mesh->GetVertexArray();
+		for (size_t i = 0; i < va.size(); i++)
+		{
+			cmd.mTexture = mesh->GetDrawTexture(i, textureIndex);
+			cmd.mVertexArray = va[i];
+			mRenderQueue.Submit(RenderQueue::MakeOpaqueKey(cmd, depth), cmd);
+		}
+		start = end;
+	}
+}
+
+void Renderer::SubmitSprites()
+{
+	// Every quad is already in screen space, one draw per batch
+	mSpriteBatch->Build(mSprites);
+	if (mSpriteBatch->GetBatches().empty())
+	{
+		return;
+	}
+	mSpriteBatch->Upload();
+	unsigned int identity = mRenderQueue.AddTransform(Matrix4::Identity);
+	for (const SpriteBatch::Batch& batch : mSpriteBatch->GetBatches())
+	{
+		RenderQueue::Command cmd;
+		cmd.mShader = mSpriteShader;
+		cmd.mTexture = batch.mTexture;
+		cmd.mVertexArray = mSpriteBatch->GetVertexArray();
+		cmd.mWorldUniform = mSpriteUniforms.mWorldTransform;
+		cmd.mTransform = identity;
+		cmd.mIndexStart = batch.mFirstIndex;
+		cmd.mIndexCount = batch.mIndexCount;
+		mRenderQueue.Submit(RenderQueue::MakeSpriteKey(cmd, batch.mLayer), cmd);
+	}
+}
+
+size_t Renderer::GetSpriteBatches() const
+{
+	return mSpriteBatch ? mSpriteBatch->GetBatches().size() : 0;
 }
@@ -4,6 +4,14 @@
 #include<unordered_map>
 #include<SDL.h>
 #include"Math.h"
+#include"MeshComponent.h"
+#include"SpriteComponent.h"
+#include"Std140Packer.h"
+#include"RenderQueue.h"
+#include"Frustum.h"
+#include"SlotMap.h"
+#include"SpriteRegistry.h"
+#include"TextureAtlas.h"
 
 struct DirectionalLight
 {
@@ -27,27 +35,73 @@ public:
 
 	void Draw();
 
-	void AddSprite(class SpriteComponent* sprite);
-	void RemoveSprite(class SpriteComponent* sprite);
+	// Every sprite component, in draw order
+	SpriteRegistry& GetSprites() { return mSprites; }
+	// Region of a sprite image packed in the sprite atlas (for
+	// SpriteComponent::SetRegion), null if it can't be loaded
+	const AtlasRegion* GetSpriteRegion(const std::string& fileName) { return mSpriteAtlas.GetRegion(fileName); }
+	const TextureAtlas& GetSpriteAtlas() const { return mSpriteAtlas; }
+	// Sprite draws of the last Draw, one per (layer, atlas page) run
+	size_t GetSpriteBatches() const;
 
-	void AddMeshComp(class MeshComponent* mesh);
-	void RemoveMeshComp(class MeshComponent* mesh);
+	SlotHandle AddMeshComp(class MeshComponent* mesh);
+	void RemoveMeshComp(SlotHandle mesh);
 
 	class Texture* GetTexture(const std::string& fileName);
 	class Mesh* GetMesh(const std::string& fileName);
 	class Mesh* GetFBXMesh(const char* fileName);
+	// Same assets, returned at once and decoded on the loader's threads.
+	// Textures show a grey placeholder and meshes draw nothing until Draw
+	// has uploaded them (a few MB per frame). The sync versions return an
+	// asset that is still loading as it is.
+	class Texture* GetTextureAsync(const std::string& fileName);
+	class Mesh* GetMeshAsync(const std::string& fileName);
+	class Mesh* GetFBXMeshAsync(const std::string& fileName);
+	// Wait for every asynchronous load and upload it (a loading screen)
+	void FinishLoading();
+	// Asynchronous loads not uploaded yet
+	size_t GetNumPendingAssets() const;
 
 	void SetViewMatrix(const Matrix4& view) { mView = view; }
+	// Lay out the FrameData uniform block of the shaders, without GL
+	// (UploadFrameData uploads it)
+	const Std140Packer& PackFrameData();
 
 	void SetAmbientLight(const Vector3& ambient) { mAmbientLight = ambient; }
 	DirectionalLight& GetDirectionalLight() { return mDirLight; }
 
 	float GetScreenWidth() const { return mScreenWidth; }
 	float GetScreenHeight() const { return mScreenHeight; }
+	// Whether SwapWindow waits for vertical sync
+	bool IsVSync() const { return mVSync; }
+	// Refresh rate of the window's display in Hz
+	int GetRefreshRate() const { return mRefreshRate; }
+	// Uniform name lookups made during the last Draw (0 when every per frame uniform uses a handle)
+	unsigned int GetUniformLookups() const { return mUniformLookups; }
+	// Draw mesh components sharing a mesh/texture with one instanced draw
+	void SetInstancing(bool instancing) { mInstancing = instancing; }
+	bool IsInstancing() const { return mInstancing; }
+	// Draw calls and state changes of the last Draw
+	const RenderQueue::Stats& GetRenderStats() const { return mRenderQueue.GetStats(); }
+	// Mesh components inside/outside the view frustum in the last Draw
+	unsigned int GetVisibleMeshes() const { return mVisibleMeshes; }
+	unsigned int GetCulledMeshes() const { return mCulledMeshes; }
 private:
 	bool LoadShaders();
-	void CreateSpriteVerts();
-	void SetLightUniforms(class Shader* shader);
+	// Let the components of meshes that just got their vertex arrays
+	// refresh their culling bounds
+	void OnMeshesLoaded();
+	// Pack and upload the FrameData uniform block
+	void UploadFrameData();
+	// Collect the mesh components whose bounding sphere touches the frustum
+	// (candidates come from the game's spatial tree)
+	void CullMeshes();
+	// Submit the visible mesh components to the render queue, grouped by
+	// (mesh, texture index) into instanced draws when instancing is on
+	void SubmitMeshes();
+	void SubmitSprites();
+	// Normalized distance from the camera used for front to back sorting
+	float GetDepth(const Vector3& position) const;
 
 	// Map of textures loaded
 	std::unordered_map < std::string, class Texture* > mTextures;
@@ -55,28 +109,69 @@ private:
 	std::unordered_map<std::string, class Mesh*> mMeshes;
 
 	// All the sprite components drawn
-	std::vector<class SpriteComponent*> mSprites;
+	SpriteRegistry mSprites;
 
 	// All mesh components drawn
-	std::vector<class MeshComponent*> mMeshComps;
+	SlotMap<class MeshComponent*> mMeshComps;
+
+	// Decodes the Get*Async assets, uploaded at the start of Draw
+	class AssetLoader* mAssetLoader;
+	std::vector<class Mesh*> mLoadedMeshes;
 
 	// Game
 	class Game* mGame;
 
 	// Sprite shader
 	class Shader* mSpriteShader;
-	// Sprite vertex array
-	class VertexArray* mSpriteVerts;
+	// Quads of every sprite streamed each frame
+	class SpriteBatch* mSpriteBatch;
+	// Sprite images, packed so sprites share textures
+	TextureAtlas mSpriteAtlas;
 
 	// Mesh shader
 	class Shader* mMeshShader;
+	// Mesh shader reading the world transform per instance
+	class Shader* mInstancedShader;
+	// World transforms of every instanced mesh component this frame
+	class InstanceBuffer* mInstanceBuffer;
+	std::vector<class MeshComponent*> mInstanceQueue;
+	std::vector<Matrix4> mInstanceTransforms;
+	bool mInstancing;
+
+	// Frustum culling, spheres of the tree's candidates packed in mCullComps order
+	Frustum mFrustum;
+	SphereBatch mCullSpheres;
+	std::vector<class MeshComponent*> mCullComps;
+	std::vector<uint8_t> mCullResults;
+	std::vector<class MeshComponent*> mVisibleMeshComps;
+	unsigned int mVisibleMeshes;
+	unsigned int mCulledMeshes;
+
+	// Every draw of the frame, sorted to minimize state changes
+	RenderQueue mRenderQueue;
+
+	// Uniform handles, resolved once in LoadShaders
+	SpriteComponent::Uniforms mSpriteUniforms;
+	MeshComponent::Uniforms mMeshUniforms;
+	MeshComponent::Uniforms mInstancedUniforms;
+	unsigned int mUniformLookups;
+
+	// Per frame camera/lighting data shared by every shader
+	class UniformBuffer* mFrameBuffer;
+	Std140Packer mFrameData;
 
 	// View/projection for 3D shaders
 	Matrix4 mView;
 	Matrix4 mProjection;
+	// Screen space view-projection for sprites
+	Matrix4 mSpriteViewProj;
+	// Camera position from the inverted view
+	Vector3 mCameraPos;
 	// Width/height of screen
 	float mScreenWidth;
 	float mScreenHeight;
+	bool mVSync;
+	int mRefreshRate;
 
 	// Lighting data
 	Vector3 mAmbientLight;
@@ -1,8 +1,11 @@
 #include"Shader.h"
+#include"UniformBuffer.h"
 #include<SDL.h>
 #include<fstream>
 #include<sstream>
 
+unsigned int Shader::sNumLookups = 0;
+
 Shader::Shader() {
 	mVertexShader = 0;
 	mFragShader = 0;
@@ -31,6 +34,7 @@ bool Shader::Load(const std::string& vertName, const std::string& fragName)
 	{
 		return false;
 	}
+	ReflectUniforms();
 	return true;
 }
 
@@ -47,26 +51,115 @@ void Shader::SetActive()
 	glUseProgram(mShaderProgram);
 }
 
-void Shader::SetMatrixUniform(const char* name, const Matrix4& matrix)
+void Shader::SetUniform(UniformHandle<Matrix4> handle, const Matrix4& matrix)
 {
-	// Find the uniform by this name
-	GLuint loc = glGetUniformLocation(mShaderProgram, name);
 	// Send the matrix data to the uniform
-	glUniformMatrix4fv(loc, 1, GL_TRUE, matrix.GetAsFloatPtr());
+	glUniformMatrix4fv(handle.mLocation, 1, GL_TRUE, matrix.GetAsFloatPtr());
+}
+
+void Shader::SetUniform(UniformHandle<Vector3> handle, const Vector3& vector)
+{
+	glUniform3fv(handle.mLocation, 1, vector.GetAsFloatPtr());
+}
+
+void Shader::SetUniform(UniformHandle<Vector2> handle, const Vector2& vector)
+{
+	glUniform2fv(handle.mLocation, 1, vector.GetAsFloatPtr());
+}
+
+void Shader::SetUniform(UniformHandle<float> handle, float value)
+{
+	glUniform1f(handle.mLocation, value);
+}
+
+void Shader::SetMatrixUniform(const char* name, const Matrix4& matrix)
+{
+	SetUniform(GetUniform<Matrix4>(name), matrix);
 }
 
 void Shader::SetVectorUniform(const char* name, const Vector3& vector)
 {
-	GLuint loc = glGetUniformLocation(mShaderProgram, name);
-	// Send the vector data
-	glUniform3fv(loc, 1, vector.GetAsFloatPtr());
+	SetUniform(GetUniform<Vector3>(name), vector);
+}
+
+void Shader::SetVector2Uniform(const char* name, const Vector2& vector)
+{
+	SetUniform(GetUniform<Vector2>(name), vector);
 }
 
 void Shader::SetFloatUniform(const char* name, float value)
 {
-	GLuint loc = glGetUniformLocation(mShaderProgram, name);
-	// Send the float data
-	glUniform1f(loc, value);
+	SetUniform(GetUniform<float>(name), value);
+}
+
+bool Shader::BindUniformBlock(const char* name, const UniformBuffer& buffer)
+{
+	GLuint index = glGetUniformBlockIndex(mShaderProgram, name);
+	if (index == GL_INVALID_INDEX)
+	{
+		return false;
+	}
+
+	// The CPU side packing must match what the compiler laid out
+	GLint size = 0;
+	glGetActiveUniformBlockiv(mShaderProgram, index, GL_UNIFORM_BLOCK_DATA_SIZE, &size);
+	if (static_cast<size_t>(size) != buffer.GetSize())
+	{
+		SDL_Log("Uniform block %s is %d bytes, buffer has %zu", name, size, buffer.GetSize());
+	}
+
+	glUniformBlockBinding(mShaderProgram, index, buffer.GetBinding());
+	return true;
+}
+
+void Shader::ReflectUniforms()
+{
+	mUniforms.clear();
+	GLint count = 0;
+	glGetProgramiv(mShaderProgram, GL_ACTIVE_UNIFORMS, &count);
+	GLint maxLength = 0;
+	glGetProgramiv(mShaderProgram, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+	std::string name(static_cast<size_t>(maxLength) + 1, '\0');
+	for (GLint i = 0; i < count; i++)
+	{
+		GLsizei length = 0;
+		UniformInfo info;
+		glGetActiveUniform(mShaderProgram, static_cast<GLuint>(i), static_cast<GLsizei>(name.size()),
+			&length, &info.mSize, &info.mType, &name[0]);
+		std::string uniformName(name.c_str(), length);
+		info.mLocation = glGetUniformLocation(mShaderProgram, uniformName.c_str());
+		if (info.mLocation < 0)
+		{
+			// Block members have no location
+			continue;
+		}
+
+		// Arrays are reported as "name[0]", also accept the plain name
+		size_t bracket = uniformName.find("[0]");
+		if (bracket != std::string::npos && bracket + 3 == uniformName.size())
+		{
+			mUniforms.emplace(uniformName.substr(0, bracket), info);
+		}
+		mUniforms.emplace(uniformName, info);
+	}
+}
+
+GLint Shader::FindUniform(const char* name, GLenum type)
+{
+	sNumLookups++;
+	auto iter = mUniforms.find(name);
+	if (iter == mUniforms.end())
+	{
+		// Unknown or optimized out, setting it is a no-op
+		return -1;
+	}
+	if (iter->second.mType != type)
+	{
+		SDL_Log("Uniform %s has GL type 0x%x, expected 0x%x", name, iter->second.mType, type);
+		return -1;
+	}
+	return iter->second.mLocation;
 }
 
 bool Shader::CompileShader(const std::string& fileName, GLenum shaderType, GLuint& outShader)
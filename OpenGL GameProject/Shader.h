@@ -1,8 +1,29 @@
 #pragma once
 #include<string>
+#include<unordered_map>
 #include<glew.h>
 #include"Math.h"
 
+// GL type a uniform must have to accept a T
+template <typename T> struct UniformType;
+template <> struct UniformType<Matrix4> { static const GLenum Value = GL_FLOAT_MAT4; };
+template <> struct UniformType<Vector3> { static const GLenum Value = GL_FLOAT_VEC3; };
+template <> struct UniformType<Vector2> { static const GLenum Value = GL_FLOAT_VEC2; };
+template <> struct UniformType<float> { static const GLenum Value = GL_FLOAT; };
+
+// Pre-resolved uniform location accepting values of type T.
+// Invalid handles (unknown or optimized out uniforms) are ignored by Set.
+template <typename T>
+class UniformHandle
+{
+public:
+	UniformHandle() :mLocation(-1) {}
+	bool IsValid() const { return mLocation >= 0; }
+private:
+	friend class Shader;
+	GLint mLocation;
+};
+
 class Shader
 {
 public:
@@ -13,13 +34,41 @@ public:
 	void Unload();
 	//Set this as the active shader program
 	void SetActive();
+	GLuint GetProgram() const { return mShaderProgram; }
+
+	// Resolve a uniform by name (hashed lookup, do this once after Load)
+	template <typename T>
+	UniformHandle<T> GetUniform(const char* name)
+	{
+		UniformHandle<T> handle;
+		handle.mLocation = FindUniform(name, UniformType<T>::Value);
+		return handle;
+	}
+	// Set uniforms through handles (no lookups)
+	void SetUniform(UniformHandle<Matrix4> handle, const Matrix4& matrix);
+	void SetUniform(UniformHandle<Vector3> handle, const Vector3& vector);
+	void SetUniform(UniformHandle<Vector2> handle, const Vector2& vector);
+	void SetUniform(UniformHandle<float> handle, float value);
+
+	// Name based setters look the uniform up on every call,
+	// keep them out of per frame code
 	//Set Matrix uniform
 	void SetMatrixUniform(const char* name, const Matrix4& matrix);
 	// Sets a Vector3 uniform
 	void SetVectorUniform(const char* name, const Vector3& vector);
+	// Sets a Vector2 uniform
+	void SetVector2Uniform(const char* name, const Vector2& vector);
 	// Sets a float uniform
 	void SetFloatUniform(const char* name, float value);
 
+	// Connect a uniform block to buffer's binding point.
+	// Returns false if the program doesn't use the block.
+	bool BindUniformBlock(const char* name, const class UniformBuffer& buffer);
+
+	// Uniform name lookups (all shaders) since the last reset
+	static unsigned int GetNumLookups() { return sNumLookups; }
+	static void ResetNumLookups() { sNumLookups = 0; }
+
 private:
 	//Compile specificed shader
 	bool CompileShader(const std::string& fileName, GLenum shaderType, GLuint& outShader);
@@ -27,10 +76,24 @@ private:
 	bool IsCompiled(GLuint shader);
 	//Check if vertex/fragment programs linked
 	bool isValidProgram();
+	//Read every active uniform of the linked program into mUniforms
+	void ReflectUniforms();
+	//Location of name (-1 if inactive or not of the expected type)
+	GLint FindUniform(const char* name, GLenum type);
 
 	// Store the shader object IDs
 	GLuint mVertexShader;
 	GLuint mFragShader;
 	GLuint mShaderProgram;
 
+	struct UniformInfo
+	{
+		GLint mLocation;
+		GLenum mType;
+		GLint mSize;
+	};
+	// Active uniforms by name
+	std::unordered_map<std::string, UniformInfo> mUniforms;
+
+	static unsigned int sNumLookups;
 };
@@ -0,0 +1,116 @@
+#pragma once
+#include<cstddef>
+#include<cstdint>
+#include<vector>
+
+// Handle to a value in a SlotMap. A slot's generation changes when its
+// value is removed, so a handle outliving its value is detected instead
+// of reaching whatever took the slot next.
+struct SlotHandle
+{
+	uint32_t mIndex = 0xFFFFFFFF;
+	uint32_t mGeneration = 0;
+
+	bool operator==(const SlotHandle& other) const
+	{
+		return mIndex == other.mIndex && mGeneration == other.mGeneration;
+	}
+	bool operator!=(const SlotHandle& other) const { return !(*this == other); }
+};
+
+// Values stored contiguously for iteration, with O(1) insert and remove
+// through handles (a sparse set). Removing moves the last value into the
+// hole, so iteration order isn't kept and pointers to values only last
+// until the next Insert or Remove.
+template<typename T>
+class SlotMap
+{
+public:
+	SlotHandle Insert(const T& value);
+	// False if handle is stale
+	bool Remove(SlotHandle handle);
+
+	bool IsValid(SlotHandle handle) const
+	{
+		return handle.mIndex < mSlots.size() && mSlots[handle.mIndex].mGeneration == handle.mGeneration;
+	}
+	// Null if handle is stale
+	T* Get(SlotHandle handle) { return IsValid(handle) ? &mValues[mSlots[handle.mIndex].mIndex] : nullptr; }
+	const T* Get(SlotHandle handle) const { return IsValid(handle) ? &mValues[mSlots[handle.mIndex].mIndex] : nullptr; }
+
+	// Every value, in no particular order
+	const std::vector<T>& GetValues() const { return mValues; }
+	T* GetData() { return mValues.data(); }
+	size_t GetCount() const { return mValues.size(); }
+	bool IsEmpty() const { return mValues.empty(); }
+	typename std::vector<T>::const_iterator begin() const { return mValues.begin(); }
+	typename std::vector<T>::const_iterator end() const { return mValues.end(); }
+
+private:
+	static const uint32_t NoSlot = 0xFFFFFFFF;
+
+	struct Slot
+	{
+		// Index in mValues, or the next free slot
+		uint32_t mIndex;
+		// Odd while the slot holds a value
+		uint32_t mGeneration;
+	};
+
+	std::vector<T> mValues;
+	// Slot of each value
+	std::vector<uint32_t> mValueSlots;
+	std::vector<Slot> mSlots;
+	uint32_t mFreeSlot = NoSlot;
+};
+
+template<typename T>
+const uint32_t SlotMap<T>::NoSlot;
+
+template<typename T>
+SlotHandle SlotMap<T>::Insert(const T& value)
+{
+	uint32_t slot = mFreeSlot;
+	if (slot != NoSlot)
+	{
+		mFreeSlot = mSlots[slot].mIndex;
+	}
+	else
+	{
+		slot = static_cast<uint32_t>(mSlots.size());
+		mSlots.emplace_back(Slot{ NoSlot, 0 });
+	}
+	mSlots[slot].mIndex = static_cast<uint32_t>(mValues.size());
+	mSlots[slot].mGeneration++;
+	mValues.emplace_back(value);
+	mValueSlots.emplace_back(slot);
+
+	SlotHandle handle;
+	handle.mIndex = slot;
+	handle.mGeneration = mSlots[slot].mGeneration;
+	return handle;
+}
+
+template<typename T>
+bool SlotMap<T>::Remove(SlotHandle handle)
+{
+	if (!IsValid(handle))
+	{
+		return false;
+	}
+	Slot& slot = mSlots[handle.mIndex];
+	uint32_t index = slot.mIndex;
+	uint32_t last = static_cast<uint32_t>(mValues.size() - 1);
+	if (index != last)
+	{
+		mValues[index] = mValues[last];
+		mValueSlots[index] = mValueSlots[last];
+		mSlots[mValueSlots[index]].mIndex = index;
+	}
+	mValues.pop_back();
+	mValueSlots.pop_back();
+	slot.mGeneration++;
+	slot.mIndex = mFreeSlot;
+	mFreeSlot = handle.mIndex;
+	return true;
+}
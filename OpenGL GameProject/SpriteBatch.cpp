@@ -0,0 +1,126 @@
+#include"SpriteBatch.h"
+#include"SpriteRegistry.h"
+#include"SpriteComponent.h"
+#include"Texture.h"
+#include"VertexArray.h"
+#include<algorithm>
+#include<functional>
+
+namespace
+{
+	const unsigned int VertsPerQuad = 4;
+	const unsigned int IndicesPerQuad = 6;
+	const unsigned int MinCapacity = 256;
+
+	// Unit quad corners: top left, top right, bottom right, bottom left
+	const float CornerX[VertsPerQuad] = { -0.5f, 0.5f, 0.5f, -0.5f };
+	const float CornerY[VertsPerQuad] = { 0.5f, 0.5f, -0.5f, -0.5f };
+}
+
+SpriteBatch::SpriteBatch()
+	:mVertexArray(nullptr)
+	, mCapacity(0)
+{
+}
+
+SpriteBatch::~SpriteBatch()
+{
+	delete mVertexArray;
+}
+
+void SpriteBatch::Build(const SpriteRegistry& sprites)
+{
+	mVertices.clear();
+	mBatches.clear();
+	sprites.ForEachLayer([this](int layer, const std::vector<SpriteComponent*>& layerSprites)
+	{
+		mLayerSprites.clear();
+		for (const SpriteComponent* sprite : layerSprites)
+		{
+			if (sprite->GetTexture())
+			{
+				mLayerSprites.emplace_back(sprite);
+			}
+		}
+		// Stable, so sprites on one texture keep their registry order.
+		// Textures without a GL object all have ID 0, the address keeps
+		// them apart.
+		std::stable_sort(mLayerSprites.begin(), mLayerSprites.end(),
+			[](const SpriteComponent* a, const SpriteComponent* b)
+		{
+			unsigned int idA = a->GetTexture()->GetTextureID();
+			unsigned int idB = b->GetTexture()->GetTextureID();
+			return idA != idB ? idA < idB : std::less<const Texture*>()(a->GetTexture(), b->GetTexture());
+		});
+
+		for (const SpriteComponent* sprite : mLayerSprites)
+		{
+			unsigned int firstIndex = static_cast<unsigned int>(mVertices.size() / VertsPerQuad * IndicesPerQuad);
+			if (mBatches.empty() || mBatches.back().mLayer != layer ||
+				mBatches.back().mTexture != sprite->GetTexture())
+			{
+				mBatches.emplace_back(Batch{ sprite->GetTexture(), layer, firstIndex, 0 });
+			}
+			mBatches.back().mIndexCount += IndicesPerQuad;
+			AddQuad(sprite);
+		}
+	});
+}
+
+void SpriteBatch::AddQuad(const SpriteComponent* sprite)
+{
+	// A corner (x, y, 0, 1) times the row vector transform is just
+	// x * row 0 + y * row 1 + row 3
+	Matrix4 world = sprite->GetSpriteTransform();
+	const Vector2& uvMin = sprite->GetUVMin();
+	const Vector2& uvMax = sprite->GetUVMax();
+	const float u[VertsPerQuad] = { uvMin.x, uvMax.x, uvMax.x, uvMin.x };
+	const float v[VertsPerQuad] = { uvMin.y, uvMin.y, uvMax.y, uvMax.y };
+	for (unsigned int i = 0; i < VertsPerQuad; i++)
+	{
+		SpriteVertex vert;
+		for (int c = 0; c < 3; c++)
+		{
+			vert.mPosition[c] = CornerX[i] * world.matrix[0][c] + CornerY[i] * world.matrix[1][c] + world.matrix[3][c];
+			vert.mNormal[c] = 0.0f;
+		}
+		vert.mUV[0] = u[i];
+		vert.mUV[1] = v[i];
+		mVertices.emplace_back(vert);
+	}
+}
+
+void SpriteBatch::Upload()
+{
+	unsigned int numQuads = static_cast<unsigned int>(mVertices.size() / VertsPerQuad);
+	if (numQuads == 0)
+	{
+		return;
+	}
+	// The indices never change, only rebuild them when out of quads
+	if (numQuads > mCapacity)
+	{
+		unsigned int capacity = std::max(mCapacity * 2, MinCapacity);
+		while (capacity < numQuads)
+		{
+			capacity *= 2;
+		}
+		std::vector<unsigned int> indices;
+		indices.reserve(capacity * IndicesPerQuad);
+		for (unsigned int i = 0; i < capacity; i++)
+		{
+			unsigned int base = i * VertsPerQuad;
+			indices.emplace_back(base);
+			indices.emplace_back(base + 1);
+			indices.emplace_back(base + 2);
+			indices.emplace_back(base + 2);
+			indices.emplace_back(base + 3);
+			indices.emplace_back(base);
+		}
+		delete mVertexArray;
+		mVertexArray = new VertexArray(VertexFormat::EPosNormTex, indices.data(),
+			static_cast<unsigned int>(indices.size()));
+		mCapacity = capacity;
+	}
+	mVertexArray->SetVertices(mVertices.data(), static_cast<unsigned int>(mVertices.size()));
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include<vector>
+#include"Math.h"
+
+// Vertex of a batched sprite quad, laid out as VertexFormat::EPosNormTex
+// so the sprite shader reads it unchanged. Positions are already in
+// screen space (the normal is unused).
+struct SpriteVertex
+{
+	float mPosition[3];
+	float mNormal[3];
+	float mUV[2];
+};
+
+// Writes the quads of every visible sprite into one vertex stream each
+// frame and splits it into batches, one per (layer, texture) run. With
+// sprites sharing atlas pages a whole layer is usually a single draw.
+class SpriteBatch
+{
+public:
+	// Quads [mFirstIndex / 6, (mFirstIndex + mIndexCount) / 6) of the stream
+	struct Batch
+	{
+		class Texture* mTexture;
+		int mLayer;
+		unsigned int mFirstIndex;
+		unsigned int mIndexCount;
+	};
+
+	SpriteBatch();
+	~SpriteBatch();
+
+	// Quads of the textured sprites of sprites, layers lowest first and
+	// sorted by texture within a layer (the order the render queue used
+	// for separate sprite draws)
+	void Build(const class SpriteRegistry& sprites);
+	// Stream the built quads to the vertex array, growing it as needed
+	void Upload();
+
+	const std::vector<Batch>& GetBatches() const { return mBatches; }
+	const std::vector<SpriteVertex>& GetVertices() const { return mVertices; }
+	// Null until something is uploaded
+	class VertexArray* GetVertexArray() const { return mVertexArray; }
+
+private:
+	void AddQuad(const class SpriteComponent* sprite);
+
+	std::vector<SpriteVertex> mVertices;
+	std::vector<Batch> mBatches;
+	// Sprites of the layer being built
+	std::vector<const class SpriteComponent*> mLayerSprites;
+	class VertexArray* mVertexArray;
+	// Quads the vertex array's index buffer covers
+	unsigned int mCapacity;
+};
@@ -13,12 +13,19 @@ SpriteComponent::SpriteComponent(Actor* owner, int drawOrder)
 	mDrawOrder = drawOrder;
 	mTextureWidth = 0;
 	mTextureHeight = 0;
-	mOwner->GetGame()->AddSprite(this);
+	mUVMax = Vector2(1.0f, 1.0f);
+	mRegistryHandle = mOwner->GetGame()->GetRenderer()->GetSprites().Add(this, mDrawOrder);
 }
 
 SpriteComponent::~SpriteComponent()
 {
-	mOwner->GetGame()->RemoveSprite(this);
+	mOwner->GetGame()->GetRenderer()->GetSprites().Remove(mRegistryHandle);
+}
+
+void SpriteComponent::SetDrawOrder(int drawOrder)
+{
+	mDrawOrder = drawOrder;
+	mOwner->GetGame()->GetRenderer()->GetSprites().SetDrawOrder(mRegistryHandle, drawOrder);
 }
 
 void SpriteComponent::SetSDLTexture(SDL_Texture* sdltexture)
@@ -33,6 +40,17 @@ void SpriteComponent::SetTexture(Texture* texture)
 	mTexture = texture;
 	mTextureWidth = texture->GetWidth();
 	mTextureHeight = texture->GetHeight();
+	mUVMin = Vector2::Zero;
+	mUVMax = Vector2(1.0f, 1.0f);
+}
+
+void SpriteComponent::SetRegion(const AtlasRegion& region)
+{
+	mTexture = region.mPage;
+	mTextureWidth = region.mWidth;
+	mTextureHeight = region.mHeight;
+	mUVMin = region.mUVMin;
+	mUVMax = region.mUVMax;
 }
 
 void SpriteComponent::Draw(SDL_Renderer* renderer)
@@ -55,22 +73,14 @@ void SpriteComponent::Draw(SDL_Renderer* renderer)
 	
 }
 
-void SpriteComponent::Draw(Shader* shader)
+void SpriteComponent::Uniforms::Resolve(Shader* shader)
 {
-	if (mTexture)
-	{
-		glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
-
-		Matrix4 scaleMat = Matrix4::CreateScale(static_cast<float>(mTextureWidth),
-			static_cast<float>(mTextureHeight), 1.0f);
-
-		Matrix4 world = scaleMat * mOwner->GetWorldTransform();
-
-		shader->SetMatrixUniform("uWorldTransform", world);
-		glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
-
-		mTexture->SetActive();
+	mWorldTransform = shader->GetUniform<Matrix4>("uWorldTransform");
+}
 
-		glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
-	}
+Matrix4 SpriteComponent::GetSpriteTransform() const
+{
+	Matrix4 scaleMat = Matrix4::CreateScale(static_cast<float>(mTextureWidth),
+		static_cast<float>(mTextureHeight), 1.0f);
+	return scaleMat * mOwner->GetRenderTransform();
 }
\ No newline at end of file
@@ -2,20 +2,49 @@
 #include"Component.h"
 #include"SDL.h"
 #include<glew.h>
+#include"Shader.h"
+#include"SpriteRegistry.h"
+#include"TextureAtlas.h"
 
 class SpriteComponent : public Component
 {
 public:
+	// drawOrder is 0 to SpriteRegistry::NumLayers - 1 (255), lowest draws
+	// first. Others are logged and clamped into that range.
 	SpriteComponent(class Actor* owner, int drawOrder = 100);
 	~SpriteComponent();
 	virtual void Draw(SDL_Renderer* renderer);
-	virtual void Draw(class Shader* shader);
+	// Sprites only update their own animation/scrolling
+	ComponentAccess GetAccess() const override
+	{
+		return ComponentAccess::Owner(ComponentData::ESprite, ComponentData::ESprite);
+	}
+	// Uniforms set when drawing, resolved once per shader
+	struct Uniforms
+	{
+		UniformHandle<Matrix4> mWorldTransform;
+
+		void Resolve(Shader* shader);
+	};
 	virtual void SetSDLTexture(SDL_Texture* sdltexture);
+	// Draw the whole of texture
 	virtual void SetTexture(class Texture* texture);
+	// Draw a region of an atlas page
+	virtual void SetRegion(const AtlasRegion& region);
 
 	int GetDrawOrder() const { return mDrawOrder; }
+	// Same range as the constructor's drawOrder. GetDrawOrder returns the
+	// value given even when it was clamped.
+	// Changes the registry, so not from a component's parallel Update.
+	void SetDrawOrder(int drawOrder);
 	int GetTextureWidth() const{ return mTextureWidth; }
 	int GetTextureheight() const { return mTextureHeight; }
+	class Texture* GetTexture() const { return mTexture; }
+	// Part of the texture drawn
+	const Vector2& GetUVMin() const { return mUVMin; }
+	const Vector2& GetUVMax() const { return mUVMax; }
+	// World transform of the unit sprite quad scaled to the texture
+	Matrix4 GetSpriteTransform() const;
 
 protected:
 
@@ -25,4 +54,8 @@ protected:
 
 	int mTextureWidth;
 	int mTextureHeight;
+	Vector2 mUVMin;
+	Vector2 mUVMax;
+	// Entry in the renderer's SpriteRegistry
+	SpriteRegistry::Handle mRegistryHandle;
 };
@@ -0,0 +1,68 @@
+#include"SpriteRegistry.h"
+#include"Math.h"
+#include"SDL.h"
+
+const int SpriteRegistry::NumLayers;
+
+namespace
+{
+	// Out of range draw orders still draw, at the nearest layer
+	int ToLayer(int drawOrder)
+	{
+		int layer = SpriteRegistry::GetLayer(drawOrder);
+		if (layer != drawOrder)
+		{
+			SDL_Log("Sprite draw order %d is outside [0, %d], drawn at %d", drawOrder,
+				SpriteRegistry::NumLayers - 1, layer);
+		}
+		return layer;
+	}
+}
+
+SpriteRegistry::SpriteRegistry()
+	:mCount(0)
+{
+}
+
+int SpriteRegistry::GetLayer(int drawOrder)
+{
+	return Math::Clamp(drawOrder, 0, NumLayers - 1);
+}
+
+SpriteRegistry::Handle SpriteRegistry::Add(SpriteComponent* sprite, int drawOrder)
+{
+	Handle handle;
+	handle.mLayer = ToLayer(drawOrder);
+	if (static_cast<size_t>(handle.mLayer) >= mLayers.size())
+	{
+		mLayers.resize(handle.mLayer + 1);
+	}
+	handle.mSlot = mLayers[handle.mLayer].Insert(sprite);
+	mCount++;
+	return handle;
+}
+
+void SpriteRegistry::Remove(const Handle& handle)
+{
+	if (mLayers[handle.mLayer].Remove(handle.mSlot))
+	{
+		mCount--;
+	}
+}
+
+void SpriteRegistry::SetDrawOrder(Handle& handle, int drawOrder)
+{
+	int layer = ToLayer(drawOrder);
+	if (layer == handle.mLayer)
+	{
+		return;
+	}
+	SpriteComponent* const* sprite = mLayers[handle.mLayer].Get(handle.mSlot);
+	if (!sprite)
+	{
+		return;
+	}
+	SpriteComponent* moved = *sprite;
+	Remove(handle);
+	handle = Add(moved, layer);
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include<cstddef>
+#include<vector>
+#include"SlotMap.h"
+
+// Every sprite component, bucketed by draw order. Each draw order is a
+// layer with a dense array of its sprites, so adding, removing and
+// changing a sprite's draw order are O(1), and ForEach visits sprites
+// in draw order without sorting. Draw orders are clamped to
+// [0, NumLayers), Add and SetDrawOrder log when they clamp one.
+// Sprites within a layer have no particular order.
+class SpriteRegistry
+{
+public:
+	static const int NumLayers = 256;
+
+	struct Handle
+	{
+		int mLayer = 0;
+		SlotHandle mSlot;
+	};
+
+	SpriteRegistry();
+
+	Handle Add(class SpriteComponent* sprite, int drawOrder);
+	void Remove(const Handle& handle);
+	// Move the sprite of handle to the layer of drawOrder, handle is updated
+	void SetDrawOrder(Handle& handle, int drawOrder);
+
+	// function(sprite) for every sprite, lowest draw order first
+	template<typename Function>
+	void ForEach(const Function& function) const;
+	// function(layer, sprites) for every non-empty layer, lowest first
+	template<typename Function>
+	void ForEachLayer(const Function& function) const;
+
+	size_t GetCount() const { return mCount; }
+	// drawOrder clamped to [0, NumLayers)
+	static int GetLayer(int drawOrder);
+
+private:
+	// Grown up to the highest layer used
+	std::vector<SlotMap<class SpriteComponent*>> mLayers;
+	size_t mCount;
+};
+
+template<typename Function>
+void SpriteRegistry::ForEach(const Function& function) const
+{
+	for (const auto& layer : mLayers)
+	{
+		for (class SpriteComponent* sprite : layer)
+		{
+			function(sprite);
+		}
+	}
+}
+
+template<typename Function>
+void SpriteRegistry::ForEachLayer(const Function& function) const
+{
+	for (size_t i = 0; i < mLayers.size(); i++)
+	{
+		if (!mLayers[i].IsEmpty())
+		{
+			function(static_cast<int>(i), mLayers[i].GetValues());
+		}
+	}
+}
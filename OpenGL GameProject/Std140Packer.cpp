@@ -0,0 +1,42 @@
+#include"Std140Packer.h"
+#include<cstring>
+
+Std140Packer::Std140Packer()
+{
+	mData.reserve(512);
+}
+
+void Std140Packer::Float(float value)
+{
+	Write(&value, sizeof(float), sizeof(float));
+}
+
+void Std140Packer::Vec2(const Vector2& value)
+{
+	Write(value.GetAsFloatPtr(), sizeof(float) * 2, sizeof(float) * 2);
+}
+
+void Std140Packer::Vec3(const Vector3& value)
+{
+	Write(value.GetAsFloatPtr(), sizeof(float) * 3, VectorAlign);
+}
+
+void Std140Packer::Mat4(const Matrix4& value)
+{
+	// Four vec4 rows, already VectorAlign sized
+	Write(value.GetAsFloatPtr(), sizeof(float) * 16, VectorAlign);
+}
+
+void Std140Packer::Align(size_t alignment)
+{
+	size_t aligned = (mData.size() + alignment - 1) & ~(alignment - 1);
+	mData.resize(aligned, 0);
+}
+
+void Std140Packer::Write(const void* data, size_t size, size_t alignment)
+{
+	Align(alignment);
+	size_t offset = mData.size();
+	mData.resize(offset + size);
+	memcpy(mData.data() + offset, data, size);
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include<cstddef>
+#include<vector>
+#include"Math.h"
+
+// Lays values out by the std140 rules into a CPU side image of a
+// uniform block. No GL calls, the result is handed to UniformBuffer.
+// Matrices are written as stored in Matrix4, which matches blocks
+// declared row_major (the same convention as SetMatrixUniform).
+class Std140Packer
+{
+public:
+	// Base alignment of vec4, structs and matrix rows
+	static const size_t VectorAlign = 16;
+
+	Std140Packer();
+
+	// Start a new block, keeping the allocation
+	void Reset() { mData.clear(); }
+
+	void Float(float value);
+	void Vec2(const Vector2& value);
+	// Aligned like a vec4, the next float may fill the 4th component
+	void Vec3(const Vector3& value);
+	void Mat4(const Matrix4& value);
+	// Struct members start and end on VectorAlign
+	void BeginStruct() { Align(VectorAlign); }
+	void EndStruct() { Align(VectorAlign); }
+
+	// Pad the block to its final size (a VectorAlign multiple, like GL_UNIFORM_BLOCK_DATA_SIZE)
+	void End() { Align(VectorAlign); }
+
+	const unsigned char* GetData() const { return mData.data(); }
+	size_t GetSize() const { return mData.size(); }
+	// Offset the next value would be written at before its alignment
+	size_t GetOffset() const { return mData.size(); }
+
+private:
+	void Align(size_t alignment);
+	void Write(const void* data, size_t size, size_t alignment);
+
+	std::vector<unsigned char> mData;
+};
@@ -8,6 +8,7 @@ Texture::Texture() {
 	mTextureID = 0;
 	mWidth = 0;
 	mHeight = 0;
+	mPlaceholder = false;
 }
 
 Texture::~Texture() {
@@ -16,8 +17,10 @@ Texture::~Texture() {
 
 bool Texture::Load(const std::string& fileName)
 {
+	int width = 0;
+	int height = 0;
 	int channels = 0;
-	unsigned char* image = SOIL_load_image(fileName.c_str(), &mWidth, &mHeight, &channels, SOIL_LOAD_AUTO);
+	unsigned char* image = SOIL_load_image(fileName.c_str(), &width, &height, &channels, SOIL_LOAD_AUTO);
 
 	if (image == nullptr)
 	{
@@ -25,18 +28,54 @@ bool Texture::Load(const std::string& fileName)
 		return false;
 	}
 
+	glGenTextures(1, &mTextureID);
+	SetImage(width, height, channels, image);
+
+	SOIL_free_image_data(image);
+
+	return true;
+}
+
+bool Texture::CreatePlaceholder()
+{
+	const unsigned char grey[] = { 128, 128, 128, 255 };
+	glGenTextures(1, &mTextureID);
+	SetImage(1, 1, 4, grey);
+	mPlaceholder = true;
+	return true;
+}
+
+void Texture::SetImage(int width, int height, int channels, const unsigned char* pixels)
+{
+	mWidth = width;
+	mHeight = height;
+	mPlaceholder = false;
+
 	int format = GL_RGB;
 	if (channels == 4)
 	{
 		format = GL_RGBA;
 	}
 
-	glGenTextures(1, &mTextureID);
 	glBindTexture(GL_TEXTURE_2D, mTextureID);
+	// RGB rows aren't always 4 byte aligned
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, format, mWidth, mHeight, 0, format, GL_UNSIGNED_BYTE, pixels);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 
-	glTexImage2D(GL_TEXTURE_2D, 0, format, mWidth, mHeight, 0, format, GL_UNSIGNED_BYTE, image);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+}
 
-	SOIL_free_image_data(image);
+bool Texture::Create(int width, int height)
+{
+	mWidth = width;
+	mHeight = height;
+
+	glGenTextures(1, &mTextureID);
+	glBindTexture(GL_TEXTURE_2D, mTextureID);
+
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, mWidth, mHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
 
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -44,6 +83,11 @@ bool Texture::Load(const std::string& fileName)
 	return true;
 }
 
+void Texture::SetSubImage(int x, int y, int width, int height, const unsigned char* pixels)
+{
+	glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+}
+
 void Texture::Unload()
 {
 	glDeleteTextures(1, &mTextureID);
@@ -8,15 +8,28 @@ public:
 	~Texture();
 
 	bool Load(const std::string& fileName);
+	// Empty RGBA texture, filled with SetSubImage
+	bool Create(int width, int height);
+	// 1x1 grey texture standing in until SetImage gives the real one
+	bool CreatePlaceholder();
+	// Replace the whole image with decoded pixels (3 or 4 channels),
+	// the texture keeps its ID
+	void SetImage(int width, int height, int channels, const unsigned char* pixels);
+	// Copy width x height RGBA pixels to (x, y), must be active
+	void SetSubImage(int x, int y, int width, int height, const unsigned char* pixels);
 	void Unload();
 
 	void SetActive();
 
 	int GetWidth() const { return mWidth; }
 	int GetHeight() const { return mHeight; }
+	unsigned int GetTextureID() const { return mTextureID; }
+	// Still showing the placeholder of an asynchronous load
+	bool IsPlaceholder() const { return mPlaceholder; }
 
 private:
 	unsigned int mTextureID;
+	bool mPlaceholder;
 
 	int mWidth;
 	int mHeight;
@@ -0,0 +1,142 @@
+#include"TextureAtlas.h"
+#include"Texture.h"
+#include"SDL.h"
+#include"SOIL.h"
+#include<cstring>
+
+const int TextureAtlas::PageSize;
+const int TextureAtlas::Padding;
+
+TextureAtlas::TextureAtlas()
+	:mNumImages(0)
+	, mImagePixels(0)
+{
+}
+
+TextureAtlas::~TextureAtlas()
+{
+	Unload();
+}
+
+const AtlasRegion* TextureAtlas::GetRegion(const std::string& fileName)
+{
+	auto iter = mRegions.find(fileName);
+	if (iter != mRegions.end())
+	{
+		return &iter->second;
+	}
+
+	int width = 0;
+	int height = 0;
+	int channels = 0;
+	unsigned char* image = SOIL_load_image(fileName.c_str(), &width, &height, &channels, SOIL_LOAD_RGBA);
+	if (image == nullptr)
+	{
+		SDL_Log("SOIL failed to load image %s: %s", fileName.c_str(), SOIL_last_result());
+		return nullptr;
+	}
+	AtlasRegion region;
+	bool added = Add(image, width, height, region);
+	SOIL_free_image_data(image);
+	if (!added)
+	{
+		SDL_Log("Image %s (%dx%d) is larger than an atlas page", fileName.c_str(), width, height);
+		return nullptr;
+	}
+	return &mRegions.emplace(fileName, region).first->second;
+}
+
+void TextureAtlas::PadImage(const unsigned char* pixels, int width, int height)
+{
+	int paddedWidth = width + 2 * Padding;
+	int paddedHeight = height + 2 * Padding;
+	mPadded.resize(static_cast<size_t>(paddedWidth) * paddedHeight * 4);
+	for (int y = 0; y < paddedHeight; y++)
+	{
+		int srcY = Math::Clamp(y - Padding, 0, height - 1);
+		const unsigned char* src = pixels + static_cast<size_t>(srcY) * width * 4;
+		unsigned char* dst = mPadded.data() + static_cast<size_t>(y) * paddedWidth * 4;
+		for (int x = 0; x < Padding; x++)
+		{
+			memcpy(dst + x * 4, src, 4);
+			memcpy(dst + (Padding + width + x) * 4, src + (width - 1) * 4, 4);
+		}
+		memcpy(dst + Padding * 4, src, static_cast<size_t>(width) * 4);
+	}
+}
+
+bool TextureAtlas::Add(const unsigned char* pixels, int width, int height, AtlasRegion& outRegion)
+{
+	int paddedWidth = width + 2 * Padding;
+	int paddedHeight = height + 2 * Padding;
+	if (width <= 0 || height <= 0 || paddedWidth > PageSize || paddedHeight > PageSize)
+	{
+		return false;
+	}
+	// Earlier pages still have gaps small images fit in
+	AtlasRect rect;
+	Page* page = nullptr;
+	for (Page& p : mPages)
+	{
+		if (p.mPacker.Insert(paddedWidth, paddedHeight, rect))
+		{
+			page = &p;
+			break;
+		}
+	}
+	if (!page)
+	{
+		Texture* texture = new Texture();
+		texture->Create(PageSize, PageSize);
+		mPages.emplace_back(Page{ texture, AtlasPacker(PageSize, PageSize) });
+		page = &mPages.back();
+		page->mPacker.Insert(paddedWidth, paddedHeight, rect);
+	}
+	PadImage(pixels, width, height);
+	page->mTexture->SetActive();
+	page->mTexture->SetSubImage(rect.mX, rect.mY, paddedWidth, paddedHeight, mPadded.data());
+	mNumImages++;
+	mImagePixels += static_cast<int64_t>(width) * height;
+
+	// The region is the image inside its padding
+	float size = static_cast<float>(PageSize);
+	int x = rect.mX + Padding;
+	int y = rect.mY + Padding;
+	outRegion.mPage = page->mTexture;
+	outRegion.mUVMin = Vector2(x / size, y / size);
+	outRegion.mUVMax = Vector2((x + width) / size, (y + height) / size);
+	outRegion.mWidth = width;
+	outRegion.mHeight = height;
+	return true;
+}
+
+TextureAtlas::Stats TextureAtlas::GetStats() const
+{
+	Stats stats;
+	stats.mPages = mPages.size();
+	stats.mImages = mNumImages;
+	stats.mImagePixels = mImagePixels;
+	for (const Page& page : mPages)
+	{
+		stats.mPaddedPixels += page.mPacker.GetUsedArea();
+	}
+	if (!mPages.empty())
+	{
+		double pagePixels = static_cast<double>(PageSize) * PageSize * mPages.size();
+		stats.mEfficiency = static_cast<float>(mImagePixels / pagePixels);
+	}
+	return stats;
+}
+
+void TextureAtlas::Unload()
+{
+	for (Page& page : mPages)
+	{
+		page.mTexture->Unload();
+		delete page.mTexture;
+	}
+	mPages.clear();
+	mRegions.clear();
+	mNumImages = 0;
+	mImagePixels = 0;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include<string>
+#include<unordered_map>
+#include<vector>
+#include"Math.h"
+#include"AtlasPacker.h"
+
+// Part of an atlas page a sprite draws. UVs have v = 0 at the top row
+// of the image, as the sprite quad expects.
+struct AtlasRegion
+{
+	class Texture* mPage = nullptr;
+	Vector2 mUVMin;
+	Vector2 mUVMax = Vector2(1.0f, 1.0f);
+	int mWidth = 0;
+	int mHeight = 0;
+};
+
+// Sprite images packed into a few large RGBA textures as they load, so
+// sprites sharing a page draw in one batch. Each image goes in the first
+// page with room (AtlasPacker), a new page is started when none has.
+// Images are surrounded by Padding pixels repeating their edges, so
+// filtering at a region's border never samples a neighbour.
+class TextureAtlas
+{
+public:
+	static const int PageSize = 2048;
+	static const int Padding = 2;
+
+	struct Stats
+	{
+		size_t mPages = 0;
+		size_t mImages = 0;
+		// Pixels of the images, and with their padding
+		int64_t mImagePixels = 0;
+		int64_t mPaddedPixels = 0;
+		// Image pixels over the pixels of every page, 0 to 1
+		float mEfficiency = 0.0f;
+	};
+
+	TextureAtlas();
+	~TextureAtlas();
+
+	// Region of the image in fileName, loaded and packed on first use.
+	// Null if it can't be loaded or doesn't fit a page.
+	const AtlasRegion* GetRegion(const std::string& fileName);
+	// Pack width x height RGBA pixels, false if they don't fit a page
+	bool Add(const unsigned char* pixels, int width, int height, AtlasRegion& outRegion);
+	void Unload();
+
+	size_t GetNumPages() const { return mPages.size(); }
+	Stats GetStats() const;
+
+private:
+	struct Page
+	{
+		class Texture* mTexture;
+		AtlasPacker mPacker;
+	};
+
+	// Copy width x height pixels into mPadded with the edges repeated
+	// Padding times around them
+	void PadImage(const unsigned char* pixels, int width, int height);
+
+	std::vector<Page> mPages;
+	std::unordered_map<std::string, AtlasRegion> mRegions;
+	size_t mNumImages;
+	int64_t mImagePixels;
+	std::vector<unsigned char> mPadded;
+};
@@ -0,0 +1,478 @@
+#include"TransformStore.h"
+#include"JobSystem.h"
+
+namespace
+{
+	// Transforms per job, smaller batches aren't worth handing out
+	const size_t ComposeGrain = 1024;
+}
+
+const TransformHandle TransformStore::InvalidHandle;
+
+TransformStore::TransformStore(JobSystem* jobs)
+	:mJobs(jobs)
+{
+}
+
+template<typename Function>
+void TransformStore::ForRange(size_t count, const Function& function)
+{
+	if (mJobs && count > ComposeGrain)
+	{
+		mJobs->ParallelFor(0, count, ComposeGrain, function);
+	}
+	else
+	{
+		function(0, count);
+	}
+}
+
+TransformHandle TransformStore::Create(Actor* owner)
+{
+	TransformHandle handle;
+	if (mFreeHandles.empty())
+	{
+		handle = static_cast<TransformHandle>(mIndices.size());
+		mIndices.emplace_back(0);
+	}
+	else
+	{
+		handle = mFreeHandles.back();
+		mFreeHandles.pop_back();
+	}
+	mIndices[handle] = static_cast<uint32_t>(mOwners.size());
+
+	mPositions.emplace_back(Vector3::Zero);
+	mRotations.emplace_back(Quaternion::Identity);
+	mScales.emplace_back(1.0f);
+	m2DPositions.emplace_back(Vector2::Zero);
+	m2DRotations.emplace_back(0.0f);
+	mDirty.emplace_back(0);
+	mLocalTransforms.emplace_back(Matrix4::Identity);
+	mWorldTransforms.emplace_back(Matrix4::Identity);
+	mPrevWorldTransforms.emplace_back(Matrix4::Identity);
+	mRenderTransforms.emplace_back(Matrix4::Identity);
+	mMoved.emplace_back(ENew);
+	mMovedHandles.emplace_back(handle);
+	mOwners.emplace_back(owner);
+	mHandles.emplace_back(handle);
+	mParents.emplace_back(InvalidHandle);
+	mFirstChild.emplace_back(InvalidHandle);
+	mNextSibling.emplace_back(InvalidHandle);
+	mPrevSibling.emplace_back(InvalidHandle);
+	mDepths.emplace_back(0);
+	return handle;
+}
+
+void TransformStore::Destroy(TransformHandle handle)
+{
+	uint32_t index = mIndices[handle];
+
+	// Children become roots
+	while (mFirstChild[index] != InvalidHandle)
+	{
+		SetParent(mFirstChild[index], InvalidHandle);
+	}
+	Unlink(index);
+
+	// Swap the last transform into the hole
+	uint32_t last = static_cast<uint32_t>(mOwners.size() - 1);
+	if (index != last)
+	{
+		mPositions[index] = mPositions[last];
+		mRotations[index] = mRotations[last];
+		mScales[index] = mScales[last];
+		m2DPositions[index] = m2DPositions[last];
+		m2DRotations[index] = m2DRotations[last];
+		mDirty[index] = mDirty[last];
+		mLocalTransforms[index] = mLocalTransforms[last];
+		mWorldTransforms[index] = mWorldTransforms[last];
+		mPrevWorldTransforms[index] = mPrevWorldTransforms[last];
+		mRenderTransforms[index] = mRenderTransforms[last];
+		mMoved[index] = mMoved[last];
+		mOwners[index] = mOwners[last];
+		mHandles[index] = mHandles[last];
+		mParents[index] = mParents[last];
+		mFirstChild[index] = mFirstChild[last];
+		mNextSibling[index] = mNextSibling[last];
+		mPrevSibling[index] = mPrevSibling[last];
+		mDepths[index] = mDepths[last];
+		mIndices[mHandles[index]] = index;
+	}
+	mPositions.pop_back();
+	mRotations.pop_back();
+	mScales.pop_back();
+	m2DPositions.pop_back();
+	m2DRotations.pop_back();
+	mDirty.pop_back();
+	mLocalTransforms.pop_back();
+	mWorldTransforms.pop_back();
+	mPrevWorldTransforms.pop_back();
+	mRenderTransforms.pop_back();
+	mMoved.pop_back();
+	mOwners.pop_back();
+	mHandles.pop_back();
+	mParents.pop_back();
+	mFirstChild.pop_back();
+	mNextSibling.pop_back();
+	mPrevSibling.pop_back();
+	mDepths.pop_back();
+
+	// ComposeDirty and Interpolate skip handles that are no longer live
+	mIndices[handle] = InvalidHandle;
+	mFreeHandles.emplace_back(handle);
+}
+
+void TransformStore::Unlink(uint32_t index)
+{
+	TransformHandle parent = mParents[index];
+	if (parent == InvalidHandle)
+	{
+		return;
+	}
+	TransformHandle prev = mPrevSibling[index];
+	TransformHandle next = mNextSibling[index];
+	if (prev != InvalidHandle)
+	{
+		mNextSibling[mIndices[prev]] = next;
+	}
+	else
+	{
+		mFirstChild[mIndices[parent]] = next;
+	}
+	if (next != InvalidHandle)
+	{
+		mPrevSibling[mIndices[next]] = prev;
+	}
+	mParents[index] = InvalidHandle;
+	mPrevSibling[index] = InvalidHandle;
+	mNextSibling[index] = InvalidHandle;
+}
+
+bool TransformStore::SetParent(TransformHandle handle, TransformHandle parent)
+{
+	uint32_t index = mIndices[handle];
+	if (mParents[index] == parent)
+	{
+		return true;
+	}
+	// No cycles
+	for (TransformHandle p = parent; p != InvalidHandle; p = mParents[mIndices[p]])
+	{
+		if (p == handle)
+		{
+			return false;
+		}
+	}
+
+	Unlink(index);
+	unsigned int depth = 0;
+	if (parent != InvalidHandle)
+	{
+		uint32_t parentIndex = mIndices[parent];
+		mParents[index] = parent;
+		mNextSibling[index] = mFirstChild[parentIndex];
+		if (mFirstChild[parentIndex] != InvalidHandle)
+		{
+			mPrevSibling[mIndices[mFirstChild[parentIndex]]] = handle;
+		}
+		mFirstChild[parentIndex] = handle;
+		depth = mDepths[parentIndex] + 1;
+	}
+	SetDepth(index, depth);
+	MarkDirty(handle, EDirtyWorld);
+	return true;
+}
+
+void TransformStore::SetDepth(uint32_t index, unsigned int depth)
+{
+	// Iterative, hierarchies can be deep
+	mDepths[index] = depth;
+	std::vector<uint32_t> stack(1, index);
+	while (!stack.empty())
+	{
+		uint32_t parent = stack.back();
+		stack.pop_back();
+		for (TransformHandle child = mFirstChild[parent]; child != InvalidHandle;
+			child = mNextSibling[mIndices[child]])
+		{
+			uint32_t childIndex = mIndices[child];
+			mDepths[childIndex] = mDepths[parent] + 1;
+			stack.emplace_back(childIndex);
+		}
+	}
+}
+
+void TransformStore::MarkDirty(TransformHandle handle, uint8_t flags)
+{
+	// Components on different actors set transforms from several jobs
+	uint8_t& dirty = mDirty[mIndices[handle]];
+	if (!dirty)
+	{
+		std::lock_guard<std::mutex> lock(mDirtyMutex);
+		mDirtyHandles.emplace_back(handle);
+	}
+	dirty |= flags;
+}
+
+void TransformStore::SetPosition(TransformHandle handle, const Vector3& position)
+{
+	mPositions[mIndices[handle]] = position;
+	MarkDirty(handle, EDirtyLocal);
+}
+
+void TransformStore::SetRotation(TransformHandle handle, const Quaternion& rotation)
+{
+	mRotations[mIndices[handle]] = rotation;
+	MarkDirty(handle, EDirtyLocal);
+}
+
+void TransformStore::SetScale(TransformHandle handle, float scale)
+{
+	mScales[mIndices[handle]] = scale;
+	MarkDirty(handle, EDirtyLocal);
+}
+
+void TransformStore::Set2DPosition(TransformHandle handle, const Vector2& position)
+{
+	m2DPositions[mIndices[handle]] = position;
+	MarkDirty(handle, EDirtyLocal);
+}
+
+void TransformStore::Set2DRotation(TransformHandle handle, float rotation)
+{
+	m2DRotations[mIndices[handle]] = rotation;
+	MarkDirty(handle, EDirtyLocal);
+}
+
+void TransformStore::ComposeOne(uint32_t index)
+{
+	if (mDirty[index] & EDirtyLocal)
+	{
+		ComposeLocal(&index, 1);
+	}
+	MarkMoved(index);
+	ComposeWorld(index);
+	mDirty[index] = 0;
+	for (TransformHandle child = mFirstChild[index]; child != InvalidHandle;
+		child = mNextSibling[mIndices[child]])
+	{
+		MarkDirty(child, EDirtyWorld);
+	}
+}
+
+void TransformStore::MarkMoved(uint32_t index)
+{
+	// Keep the world the step started with
+	if (mMoved[index] == EStill)
+	{
+		mPrevWorldTransforms[index] = mWorldTransforms[index];
+		mMoved[index] = EMoved;
+		mMovedHandles.emplace_back(mHandles[index]);
+	}
+	else if (mMoved[index] == ENew)
+	{
+		mMoved[index] = ESnap;
+	}
+}
+
+void TransformStore::ComposeWorld(uint32_t index)
+{
+	TransformHandle parent = mParents[index];
+	mWorldTransforms[index] = parent == InvalidHandle ? mLocalTransforms[index] :
+		mLocalTransforms[index] * mWorldTransforms[mIndices[parent]];
+}
+
+bool TransformStore::Compose(TransformHandle handle)
+{
+	uint32_t index = mIndices[handle];
+	if (!(mDirty[index] & (EDirtyLocal | EDirtyWorld)))
+	{
+		return false;
+	}
+	// Stays in mDirtyHandles, ComposeDirty skips it once clean
+	ComposeOne(index);
+	return true;
+}
+
+void TransformStore::Enqueue(uint32_t index)
+{
+	unsigned int depth = mDepths[index];
+	if (depth >= mDepthQueues.size())
+	{
+		mDepthQueues.resize(depth + 1);
+	}
+	mDepthQueues[depth].emplace_back(index);
+	mDirty[index] |= EQueued;
+}
+
+const std::vector<Actor*>& TransformStore::ComposeDirty()
+{
+	mUpdated.clear();
+	for (TransformHandle handle : mDirtyHandles)
+	{
+		// Skip destroyed, already clean or already queued transforms
+		uint32_t index = mIndices[handle];
+		if (index != InvalidHandle && mDirty[index] && !(mDirty[index] & EQueued))
+		{
+			Enqueue(index);
+		}
+	}
+	mDirtyHandles.clear();
+
+	// Shallowest first, so every parent's world is final before its children
+	for (size_t depth = 0; depth < mDepthQueues.size(); depth++)
+	{
+		if (mDepthQueues[depth].empty())
+		{
+			continue;
+		}
+		// Children go in the next array, make sure queuing them can't
+		// reallocate the one being walked
+		if (mDepthQueues.size() < depth + 2)
+		{
+			mDepthQueues.resize(depth + 2);
+		}
+		std::vector<uint32_t>& queue = mDepthQueues[depth];
+
+		mLocalIndices.clear();
+		for (uint32_t index : queue)
+		{
+			if (mDirty[index] & EDirtyLocal)
+			{
+				mLocalIndices.emplace_back(index);
+			}
+		}
+		// Transforms in one depth array don't depend on each other, the
+		// matrices can be built in parallel. Bookkeeping stays serial.
+		ForRange(mLocalIndices.size(), [this](size_t first, size_t last)
+		{
+			ComposeLocal(mLocalIndices.data() + first, last - first);
+		});
+		for (uint32_t index : queue)
+		{
+			MarkMoved(index);
+		}
+		ForRange(queue.size(), [this, &queue](size_t first, size_t last)
+		{
+			for (size_t i = first; i < last; i++)
+			{
+				ComposeWorld(queue[i]);
+			}
+		});
+
+		for (uint32_t index : queue)
+		{
+			mDirty[index] = 0;
+			mUpdated.emplace_back(mOwners[index]);
+
+			// The whole subtree below moves with this transform
+			for (TransformHandle child = mFirstChild[index]; child != InvalidHandle;
+				child = mNextSibling[mIndices[child]])
+			{
+				uint32_t childIndex = mIndices[child];
+				if (!(mDirty[childIndex] & EQueued))
+				{
+					Enqueue(childIndex);
+				}
+			}
+		}
+		queue.clear();
+	}
+	return mUpdated;
+}
+
+void TransformStore::BeginStep()
+{
+	// Transforms that were never composed stay listed until they are
+	size_t kept = 0;
+	for (TransformHandle handle : mMovedHandles)
+	{
+		uint32_t index = mIndices[handle];
+		if (index == InvalidHandle)
+		{
+			continue;
+		}
+		if (mMoved[index] == ENew)
+		{
+			mMovedHandles[kept++] = handle;
+		}
+		else
+		{
+			mMoved[index] = EStill;
+		}
+	}
+	mMovedHandles.resize(kept);
+}
+
+void TransformStore::Interpolate(float alpha)
+{
+	alpha = Math::Clamp(alpha, 0.0f, 1.0f);
+	for (TransformHandle handle : mMovedHandles)
+	{
+		uint32_t index = mIndices[handle];
+		if (index == InvalidHandle || mMoved[index] != EMoved)
+		{
+			continue;
+		}
+		// Per step rotations are small, so blending the matrices
+		// elementwise stays close to a rigid transform
+		const float(*prev)[4] = mPrevWorldTransforms[index].matrix;
+		const float(*curr)[4] = mWorldTransforms[index].matrix;
+		float(*out)[4] = mRenderTransforms[index].matrix;
+		for (int r = 0; r < 4; r++)
+		{
+			for (int c = 0; c < 4; c++)
+			{
+				out[r][c] = Math::Lerp(prev[r][c], curr[r][c], alpha);
+			}
+		}
+	}
+}
+
+void TransformStore::ComposeLocal(const uint32_t* indices, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		uint32_t index = indices[i];
+		const Quaternion& q = mRotations[index];
+		const Vector3& p = mPositions[index];
+		const Vector2& p2 = m2DPositions[index];
+		float s = mScales[index];
+		float c = Math::Cos(m2DRotations[index]);
+		float sn = Math::Sin(m2DRotations[index]);
+
+		// Rows of the quaternion rotation (as Matrix4::CreateFromQuaternion)
+		float r0x = 1.0f - 2.0f * q.y * q.y - 2.0f * q.z * q.z;
+		float r0y = 2.0f * q.x * q.y + 2.0f * q.w * q.z;
+		float r0z = 2.0f * q.x * q.z - 2.0f * q.w * q.y;
+		float r1x = 2.0f * q.x * q.y - 2.0f * q.w * q.z;
+		float r1y = 1.0f - 2.0f * q.x * q.x - 2.0f * q.z * q.z;
+		float r1z = 2.0f * q.y * q.z + 2.0f * q.w * q.x;
+		float r2x = 2.0f * q.x * q.z + 2.0f * q.w * q.y;
+		float r2y = 2.0f * q.y * q.z - 2.0f * q.w * q.x;
+		float r2z = 1.0f - 2.0f * q.x * q.x - 2.0f * q.y * q.y;
+
+		// scale * rotZ only mixes the first two rows
+		float (*m)[4] = mLocalTransforms[index].matrix;
+		m[0][0] = s * (c * r0x + sn * r1x);
+		m[0][1] = s * (c * r0y + sn * r1y);
+		m[0][2] = s * (c * r0z + sn * r1z);
+		m[0][3] = 0.0f;
+		m[1][0] = s * (c * r1x - sn * r0x);
+		m[1][1] = s * (c * r1y - sn * r0y);
+		m[1][2] = s * (c * r1z - sn * r0z);
+		m[1][3] = 0.0f;
+		m[2][0] = s * r2x;
+		m[2][1] = s * r2y;
+		m[2][2] = s * r2z;
+		m[2][3] = 0.0f;
+		// 2D translation goes through the rotation, then the position
+		m[3][0] = p2.x * r0x + p2.y * r1x + p.x;
+		m[3][1] = p2.x * r0y + p2.y * r1y + p.y;
+		m[3][2] = p2.x * r0z + p2.y * r1z + p.z;
+		m[3][3] = 1.0f;
+
+		mDirty[index] &= static_cast<uint8_t>(~EDirtyLocal);
+	}
+}
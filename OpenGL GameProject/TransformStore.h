@@ -0,0 +1,160 @@
+#pragma once
+#include<cstdint>
+#include<mutex>
+#include<vector>
+#include"Math.h"
+
+typedef uint32_t TransformHandle;
+
+// Local transforms and world matrices of every actor, one array per
+// field. Actors keep a handle; setters mark the transform dirty and
+// ComposeDirty rebuilds every dirty world matrix in one pass.
+//
+// Local = scale * rotZ(2D rotation) * translate(2D position)
+//       * rotate(quaternion) * translate(position), built directly
+//       without general matrix multiplies.
+// World = local * parent world.
+//
+// Dirty transforms are processed in arrays ordered by depth so parents
+// are always done before their children. Only the subtrees below dirty
+// transforms are visited.
+//
+// For fixed timestep updates the world matrix from the start of the
+// current step is kept for every transform that moved during it, and
+// Interpolate blends between the two for rendering.
+class TransformStore
+{
+public:
+	static const TransformHandle InvalidHandle = 0xFFFFFFFF;
+
+	// Large batches of dirty transforms are composed on jobs (jobs may be null)
+	TransformStore(class JobSystem* jobs = nullptr);
+
+	TransformHandle Create(class Actor* owner);
+	// Children of handle are detached and keep their local transform
+	void Destroy(TransformHandle handle);
+
+	// Attach handle under parent (InvalidHandle detaches it).
+	// Returns false if parent is handle or one of its descendants.
+	bool SetParent(TransformHandle handle, TransformHandle parent);
+	TransformHandle GetParent(TransformHandle handle) const { return mParents[mIndices[handle]]; }
+	class Actor* GetOwner(TransformHandle handle) const { return mOwners[mIndices[handle]]; }
+	// 0 for a root
+	unsigned int GetDepth(TransformHandle handle) const { return mDepths[mIndices[handle]]; }
+
+	void SetPosition(TransformHandle handle, const Vector3& position);
+	const Vector3& GetPosition(TransformHandle handle) const { return mPositions[mIndices[handle]]; }
+	void SetRotation(TransformHandle handle, const Quaternion& rotation);
+	const Quaternion& GetRotation(TransformHandle handle) const { return mRotations[mIndices[handle]]; }
+	void SetScale(TransformHandle handle, float scale);
+	float GetScale(TransformHandle handle) const { return mScales[mIndices[handle]]; }
+	void Set2DPosition(TransformHandle handle, const Vector2& position);
+	const Vector2& Get2DPosition(TransformHandle handle) const { return m2DPositions[mIndices[handle]]; }
+	void Set2DRotation(TransformHandle handle, float rotation);
+	float Get2DRotation(TransformHandle handle) const { return m2DRotations[mIndices[handle]]; }
+
+	const Matrix4& GetLocalTransform(TransformHandle handle) const { return mLocalTransforms[mIndices[handle]]; }
+	const Matrix4& GetWorldTransform(TransformHandle handle) const { return mWorldTransforms[mIndices[handle]]; }
+	bool IsDirty(TransformHandle handle) const { return mDirty[mIndices[handle]] != 0; }
+
+	// Rebuild one world matrix if it is dirty (its parent's world is used
+	// as is), returns true if it was. Its children are marked dirty.
+	bool Compose(TransformHandle handle);
+	// Rebuild every dirty world matrix and the subtrees below them,
+	// returns the owners whose transform changed (valid until the next call)
+	const std::vector<class Actor*>& ComposeDirty();
+
+	// Start a simulation step: worlds composed from here on are blended
+	// from their current value by Interpolate
+	void BeginStep();
+	// Blend the render transforms of everything that moved this step,
+	// alpha 0 is the previous step and 1 the current one
+	void Interpolate(float alpha);
+	// World transform to draw with, as of the last Interpolate
+	const Matrix4& GetRenderTransform(TransformHandle handle) const
+	{
+		uint32_t index = mIndices[handle];
+		return mMoved[index] == EMoved ? mRenderTransforms[index] : mWorldTransforms[index];
+	}
+
+	size_t GetCount() const { return mOwners.size(); }
+
+private:
+	enum DirtyFlags : uint8_t
+	{
+		// Local transform needs composing
+		EDirtyLocal = 1,
+		// Parent's world changed
+		EDirtyWorld = 2,
+		// Already in a depth array this ComposeDirty
+		EQueued = 4
+	};
+
+	enum MoveState : uint8_t
+	{
+		// Not composed since BeginStep
+		EStill,
+		// Composed since BeginStep, mPrevWorldTransforms holds the old world
+		EMoved,
+		// Created and never composed
+		ENew,
+		// First composed this step, drawn at its world without blending
+		ESnap
+	};
+
+	void MarkDirty(TransformHandle handle, uint8_t flags);
+	void Unlink(uint32_t index);
+	// Set the depth of index and everything below it
+	void SetDepth(uint32_t index, unsigned int depth);
+	// Queue index in the array of its depth
+	void Enqueue(uint32_t index);
+	// Build the local matrices of the given dense indices
+	void ComposeLocal(const uint32_t* indices, size_t count);
+	// Local and world matrix of index, children marked EDirtyWorld
+	void ComposeOne(uint32_t index);
+	// World matrix of index from its local and its parent's world
+	void ComposeWorld(uint32_t index);
+	// Save the world of index the first time it is composed in a step
+	void MarkMoved(uint32_t index);
+	// Run function(first, last) over [0, count), on jobs when it is large
+	template<typename Function>
+	void ForRange(size_t count, const Function& function);
+
+	// Dense arrays, indexed by mIndices[handle]
+	std::vector<Vector3> mPositions;
+	std::vector<Quaternion> mRotations;
+	std::vector<float> mScales;
+	std::vector<Vector2> m2DPositions;
+	std::vector<float> m2DRotations;
+	std::vector<uint8_t> mDirty;
+	std::vector<Matrix4> mLocalTransforms;
+	std::vector<Matrix4> mWorldTransforms;
+	// World at the start of the step and the blended one, for EMoved only
+	std::vector<Matrix4> mPrevWorldTransforms;
+	std::vector<Matrix4> mRenderTransforms;
+	std::vector<uint8_t> mMoved;
+	std::vector<class Actor*> mOwners;
+	std::vector<TransformHandle> mHandles;
+	// Hierarchy, as handles: children are a doubly linked sibling list
+	std::vector<TransformHandle> mParents;
+	std::vector<TransformHandle> mFirstChild;
+	std::vector<TransformHandle> mNextSibling;
+	std::vector<TransformHandle> mPrevSibling;
+	std::vector<unsigned int> mDepths;
+
+	// Handle -> dense index, and handles free for reuse
+	std::vector<uint32_t> mIndices;
+	std::vector<TransformHandle> mFreeHandles;
+
+	// Handles marked dirty since the last ComposeDirty, guarded by mDirtyMutex
+	std::vector<TransformHandle> mDirtyHandles;
+	std::mutex mDirtyMutex;
+	// Dense indices to compose, one array per depth
+	std::vector<std::vector<uint32_t>> mDepthQueues;
+	std::vector<uint32_t> mLocalIndices;
+	std::vector<class Actor*> mUpdated;
+
+	class JobSystem* mJobs;
+	// Handles composed since BeginStep or never composed
+	std::vector<TransformHandle> mMovedHandles;
+};
@@ -0,0 +1,32 @@
+#include"UniformBuffer.h"
+#include"glew.h"
+#include<SDL_log.h>
+
+UniformBuffer::UniformBuffer(size_t size, unsigned int binding)
+	:mBuffer(0)
+	, mSize(size)
+	, mBinding(binding)
+{
+	glGenBuffers(1, &mBuffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, mBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+	glBindBufferBase(GL_UNIFORM_BUFFER, binding, mBuffer);
+}
+
+UniformBuffer::~UniformBuffer()
+{
+	glDeleteBuffers(1, &mBuffer);
+}
+
+void UniformBuffer::Update(const void* data, size_t size)
+{
+	if (size > mSize)
+	{
+		SDL_Log("Uniform buffer update of %zu bytes exceeds its %zu bytes", size, mSize);
+		return;
+	}
+	glBindBuffer(GL_UNIFORM_BUFFER, mBuffer);
+	// Orphan the old storage so the driver doesn't wait on last frame's draws
+	glBufferData(GL_UNIFORM_BUFFER, mSize, nullptr, GL_DYNAMIC_DRAW);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, size, data);
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include<cstddef>
+
+// GL uniform buffer object bound to a fixed binding point.
+// Shaders connect their block to the same point with
+// Shader::BindUniformBlock.
+class UniformBuffer
+{
+public:
+	// Binding point of the per frame FrameData block
+	static const unsigned int FrameDataBinding = 0;
+
+	UniformBuffer(size_t size, unsigned int binding);
+	~UniformBuffer();
+
+	// Replace the whole contents (size must not exceed the buffer)
+	void Update(const void* data, size_t size);
+
+	size_t GetSize() const { return mSize; }
+	unsigned int GetBinding() const { return mBinding; }
+
+private:
+	unsigned int mBuffer;
+	size_t mSize;
+	unsigned int mBinding;
+};
@@ -1,28 +1,61 @@
 #include"VertexArray.h"
 #include"glew.h"
 
+namespace
+{
+	GLenum GetGLType(AttributeType type)
+	{
+		switch (type)
+		{
+		case AttributeType::ESnorm16:
+			return GL_SHORT;
+		case AttributeType::EUnorm16:
+			return GL_UNSIGNED_SHORT;
+		default:
+			return GL_FLOAT;
+		}
+	}
+}
+
 VertexArray::VertexArray(const float* verts, unsigned int numVerts,
+	const unsigned int* indices, unsigned int numIndices)
+	:VertexArray(verts, numVerts, VertexFormat::EPosNormTex, indices, numIndices)
+{
+}
+
+VertexArray::VertexArray(const void* verts, unsigned int numVerts, VertexFormat format,
 	const unsigned int* indices, unsigned int numIndices)
 	:mNumVerts(numVerts)
 	, mNumIndices(numIndices)
+	, mVertexFormat(format)
 {
+	const VertexLayout& layout = VertexEncoder::GetLayout(format);
+
 	glGenVertexArrays(1, &mVertexArray);
 	glBindVertexArray(mVertexArray);
 
 	glGenBuffers(1, &mVertexBuffer);
 	glBindBuffer(GL_ARRAY_BUFFER, mVertexBuffer);
-	glBufferData(GL_ARRAY_BUFFER, numVerts * 8 * sizeof(float), verts, GL_STATIC_DRAW);/////////
+	glBufferData(GL_ARRAY_BUFFER, numVerts * layout.mStride, verts, GL_STATIC_DRAW);
 
 	glGenBuffers(1, &mIndexBuffer);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mIndexBuffer);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, numIndices * sizeof(unsigned int), indices, GL_STATIC_DRAW);
 
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 8, 0);
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 8, reinterpret_cast<void*>(sizeof(float) * 3));
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 8, reinterpret_cast<void*>(sizeof(float) * 6));
+	// Integer attributes are normalized, the shader rescales them
+	for (unsigned int i = 0; i < VertexLayout::NumAttributes; i++)
+	{
+		const VertexAttribute& attrib = layout.mAttributes[i];
+		glEnableVertexAttribArray(i);
+		glVertexAttribPointer(i, attrib.mComponents, GetGLType(attrib.mType),
+			attrib.mType == AttributeType::EFloat ? GL_FALSE : GL_TRUE,
+			layout.mStride, reinterpret_cast<void*>(static_cast<size_t>(attrib.mOffset)));
+	}
+}
+
+VertexArray::VertexArray(VertexFormat format, const unsigned int* indices, unsigned int numIndices)
+	:VertexArray(nullptr, 0, format, indices, numIndices)
+{
 }
 
 VertexArray::~VertexArray()
@@ -35,4 +68,27 @@ VertexArray::~VertexArray()
 void VertexArray::SetActive()
 {
 	glBindVertexArray(mVertexArray);
-}
\ No newline at end of file
+}
+
+void VertexArray::SetVertices(const void* verts, unsigned int numVerts)
+{
+	const VertexLayout& layout = VertexEncoder::GetLayout(mVertexFormat);
+	glBindVertexArray(mVertexArray);
+	glBindBuffer(GL_ARRAY_BUFFER, mVertexBuffer);
+	// Fresh storage each time, so the driver doesn't wait for last frame's draws
+	glBufferData(GL_ARRAY_BUFFER, numVerts * layout.mStride, verts, GL_STREAM_DRAW);
+	mNumVerts = numVerts;
+}
+
+void VertexArray::SetInstanceData(unsigned int buffer, size_t offset)
+{
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	for (unsigned int i = 0; i < 4; i++)
+	{
+		GLuint attrib = InstanceAttribute + i;
+		glEnableVertexAttribArray(attrib);
+		glVertexAttribPointer(attrib, 4, GL_FLOAT, GL_FALSE, sizeof(Matrix4),
+			reinterpret_cast<void*>(offset + i * sizeof(float) * 4));
+		glVertexAttribDivisor(attrib, 1);
+	}
+}
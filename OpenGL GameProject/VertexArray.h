@@ -1,19 +1,39 @@
 #pragma once
+#include<cstddef>
+#include"VertexFormat.h"
 
 class VertexArray
 {
 public:
+	// First of the four vec4 rows of the instance world transform
+	static const unsigned int InstanceAttribute = VertexLayout::NumAttributes;
+
+	// Float position 3, normal 3, uv 2 vertices
 	VertexArray(const float* verts, unsigned int numVerts, 
 		const unsigned int* indices, unsigned int numIndices);
+	// Vertices already encoded in format
+	VertexArray(const void* verts, unsigned int numVerts, VertexFormat format,
+		const unsigned int* indices, unsigned int numIndices);
+	// Vertices streamed with SetVertices, fixed indices
+	VertexArray(VertexFormat format, const unsigned int* indices, unsigned int numIndices);
 	~VertexArray();
 
 	void SetActive();
+	// Replace the vertices of a streamed vertex array (the previous
+	// storage is orphaned), leaves it active
+	void SetVertices(const void* verts, unsigned int numVerts);
+	// Point the per instance world transform attributes at buffer, a
+	// Matrix4 per instance starting at offset bytes (must be active)
+	void SetInstanceData(unsigned int buffer, size_t offset);
 	unsigned int GetNumIndices() const { return mNumIndices; }
 	unsigned int GetNumVerts() const { return mNumVerts; }
+	VertexFormat GetVertexFormat() const { return mVertexFormat; }
+	unsigned int GetID() const { return mVertexArray; }
 
 private:
 	unsigned int mNumVerts;
 	unsigned int mNumIndices;
+	VertexFormat mVertexFormat;
 	unsigned int mVertexBuffer;
 	unsigned int mIndexBuffer;
 	unsigned int mVertexArray;
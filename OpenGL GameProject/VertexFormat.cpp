@@ -0,0 +1,316 @@
+#include"VertexFormat.h"
+#include"MeshData.h"
+#include<cstring>
+#include<cmath>
+#include<SDL_log.h>
+
+namespace
+{
+	const VertexLayout Layouts[] =
+	{
+		// EPosNormTex
+		{ 32, { { 3, AttributeType::EFloat, 0 }, { 3, AttributeType::EFloat, 12 }, { 2, AttributeType::EFloat, 24 } } },
+		// EPosOctTex
+		{ 20, { { 3, AttributeType::EFloat, 0 }, { 2, AttributeType::ESnorm16, 12 }, { 2, AttributeType::EUnorm16, 16 } } },
+		// EQuantPosOctTex (position padded to 8 bytes to keep the normal 4 byte aligned)
+		{ 16, { { 3, AttributeType::EUnorm16, 0 }, { 2, AttributeType::ESnorm16, 8 }, { 2, AttributeType::EUnorm16, 12 } } },
+	};
+
+	const char* Names[] =
+	{
+		"PosNormTex",
+		"PosOctTex",
+		"QuantPosOctTex",
+	};
+
+	static_assert(sizeof(Layouts) / sizeof(Layouts[0]) == static_cast<size_t>(VertexFormat::ECount),
+		"Every vertex format needs a layout");
+	static_assert(sizeof(Names) / sizeof(Names[0]) == static_cast<size_t>(VertexFormat::ECount),
+		"Every vertex format needs a name");
+
+	float SignNotZero(float value)
+	{
+		return value >= 0.0f ? 1.0f : -1.0f;
+	}
+
+	// Project the unit sphere onto an octahedron and unfold it to [-1, 1]^2
+	void OctEncode(const float* normal, float* outOct)
+	{
+		float l1 = Math::Abs(normal[0]) + Math::Abs(normal[1]) + Math::Abs(normal[2]);
+		if (l1 <= 0.0f)
+		{
+			outOct[0] = 0.0f;
+			outOct[1] = 0.0f;
+			return;
+		}
+		float x = normal[0] / l1;
+		float y = normal[1] / l1;
+		if (normal[2] < 0.0f)
+		{
+			// Fold the lower hemisphere over the diagonals
+			float fx = (1.0f - Math::Abs(y)) * SignNotZero(x);
+			float fy = (1.0f - Math::Abs(x)) * SignNotZero(y);
+			x = fx;
+			y = fy;
+		}
+		outOct[0] = x;
+		outOct[1] = y;
+	}
+
+	// Same as the decode in Phong.vert
+	void OctDecode(const float* oct, float* outNormal)
+	{
+		Vector3 n(oct[0], oct[1], 1.0f - Math::Abs(oct[0]) - Math::Abs(oct[1]));
+		float t = Math::Max(-n.z, 0.0f);
+		n.x += n.x >= 0.0f ? -t : t;
+		n.y += n.y >= 0.0f ? -t : t;
+		n.Normalize();
+		outNormal[0] = n.x;
+		outNormal[1] = n.y;
+		outNormal[2] = n.z;
+	}
+
+	void WriteAttribute(unsigned char* dest, const VertexAttribute& attrib, const float* values)
+	{
+		dest += attrib.mOffset;
+		for (unsigned int i = 0; i < attrib.mComponents; i++)
+		{
+			switch (attrib.mType)
+			{
+			case AttributeType::EFloat:
+				memcpy(dest + i * sizeof(float), &values[i], sizeof(float));
+				break;
+			case AttributeType::ESnorm16:
+			{
+				int16_t v = static_cast<int16_t>(lroundf(Math::Clamp(values[i], -1.0f, 1.0f) * 32767.0f));
+				memcpy(dest + i * sizeof(int16_t), &v, sizeof(int16_t));
+				break;
+			}
+			case AttributeType::EUnorm16:
+			{
+				uint16_t v = static_cast<uint16_t>(lroundf(Math::Clamp(values[i], 0.0f, 1.0f) * 65535.0f));
+				memcpy(dest + i * sizeof(uint16_t), &v, sizeof(uint16_t));
+				break;
+			}
+			}
+		}
+	}
+
+	// Reads values the way GL expands normalized attributes
+	void ReadAttribute(const unsigned char* src, const VertexAttribute& attrib, float* outValues)
+	{
+		src += attrib.mOffset;
+		for (unsigned int i = 0; i < attrib.mComponents; i++)
+		{
+			switch (attrib.mType)
+			{
+			case AttributeType::EFloat:
+				memcpy(&outValues[i], src + i * sizeof(float), sizeof(float));
+				break;
+			case AttributeType::ESnorm16:
+			{
+				int16_t v;
+				memcpy(&v, src + i * sizeof(int16_t), sizeof(int16_t));
+				outValues[i] = Math::Max(v / 32767.0f, -1.0f);
+				break;
+			}
+			case AttributeType::EUnorm16:
+			{
+				uint16_t v;
+				memcpy(&v, src + i * sizeof(uint16_t), sizeof(uint16_t));
+				outValues[i] = v / 65535.0f;
+				break;
+			}
+			}
+		}
+	}
+
+	// Bounds of components [first, first + count) across all vertices
+	void GetBounds(const float* verts, unsigned int numVerts, unsigned int first, unsigned int count,
+		float* outMin, float* outMax)
+	{
+		for (unsigned int c = 0; c < count; c++)
+		{
+			outMin[c] = numVerts > 0 ? verts[first + c] : 0.0f;
+			outMax[c] = outMin[c];
+		}
+		for (unsigned int v = 0; v < numVerts; v++)
+		{
+			const float* src = verts + v * MeshData::VertexSize + first;
+			for (unsigned int c = 0; c < count; c++)
+			{
+				outMin[c] = Math::Min(outMin[c], src[c]);
+				outMax[c] = Math::Max(outMax[c], src[c]);
+			}
+		}
+	}
+
+	float Normalize(float value, float offset, float scale)
+	{
+		return scale > 0.0f ? (value - offset) / scale : 0.0f;
+	}
+}
+
+const VertexLayout& VertexEncoder::GetLayout(VertexFormat format)
+{
+	size_t index = static_cast<size_t>(format);
+	return Layouts[index < static_cast<size_t>(VertexFormat::ECount) ? index : 0];
+}
+
+bool VertexEncoder::HasOctNormals(VertexFormat format)
+{
+	return GetLayout(format).mAttributes[1].mComponents == 2;
+}
+
+const char* VertexEncoder::GetName(VertexFormat format)
+{
+	size_t index = static_cast<size_t>(format);
+	return index < static_cast<size_t>(VertexFormat::ECount) ? Names[index] : "Unknown";
+}
+
+bool VertexEncoder::Parse(const std::string& name, VertexFormat& outFormat)
+{
+	for (size_t i = 0; i < static_cast<size_t>(VertexFormat::ECount); i++)
+	{
+		if (name == Names[i])
+		{
+			outFormat = static_cast<VertexFormat>(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+void VertexEncoder::Encode(const float* verts, unsigned int numVerts, VertexFormat format,
+	std::vector<unsigned char>& outVerts, VertexQuantization& outQuant)
+{
+	const VertexLayout& layout = GetLayout(format);
+	outQuant = VertexQuantization();
+
+	// Normalized positions/uvs cover the mesh bounds
+	if (layout.mAttributes[0].mType != AttributeType::EFloat)
+	{
+		float min[3], max[3];
+		GetBounds(verts, numVerts, 0, 3, min, max);
+		outQuant.mPosOffset = Vector3(min[0], min[1], min[2]);
+		outQuant.mPosScale = Vector3(max[0] - min[0], max[1] - min[1], max[2] - min[2]);
+	}
+	if (layout.mAttributes[2].mType != AttributeType::EFloat)
+	{
+		float min[2], max[2];
+		GetBounds(verts, numVerts, 6, 2, min, max);
+		outQuant.mUVOffset = Vector2(min[0], min[1]);
+		outQuant.mUVScale = Vector2(max[0] - min[0], max[1] - min[1]);
+	}
+
+	outVerts.assign(numVerts * layout.mStride, 0);
+	for (unsigned int v = 0; v < numVerts; v++)
+	{
+		const float* src = verts + v * MeshData::VertexSize;
+		unsigned char* dest = outVerts.data() + v * layout.mStride;
+
+		float pos[3] =
+		{
+			Normalize(src[0], outQuant.mPosOffset.x, outQuant.mPosScale.x),
+			Normalize(src[1], outQuant.mPosOffset.y, outQuant.mPosScale.y),
+			Normalize(src[2], outQuant.mPosOffset.z, outQuant.mPosScale.z)
+		};
+		if (layout.mAttributes[0].mType == AttributeType::EFloat)
+		{
+			memcpy(pos, src, sizeof(pos));
+		}
+
+		float normal[3] = { src[3], src[4], src[5] };
+		if (HasOctNormals(format))
+		{
+			OctEncode(src + 3, normal);
+		}
+
+		float uv[2] =
+		{
+			Normalize(src[6], outQuant.mUVOffset.x, outQuant.mUVScale.x),
+			Normalize(src[7], outQuant.mUVOffset.y, outQuant.mUVScale.y)
+		};
+		if (layout.mAttributes[2].mType == AttributeType::EFloat)
+		{
+			memcpy(uv, src + 6, sizeof(uv));
+		}
+
+		WriteAttribute(dest, layout.mAttributes[0], pos);
+		WriteAttribute(dest, layout.mAttributes[1], normal);
+		WriteAttribute(dest, layout.mAttributes[2], uv);
+	}
+}
+
+void VertexEncoder::Decode(const unsigned char* vert, VertexFormat format,
+	const VertexQuantization& quant, float* outVert)
+{
+	const VertexLayout& layout = GetLayout(format);
+	float values[3] = {};
+
+	ReadAttribute(vert, layout.mAttributes[0], values);
+	outVert[0] = values[0] * quant.mPosScale.x + quant.mPosOffset.x;
+	outVert[1] = values[1] * quant.mPosScale.y + quant.mPosOffset.y;
+	outVert[2] = values[2] * quant.mPosScale.z + quant.mPosOffset.z;
+
+	ReadAttribute(vert, layout.mAttributes[1], values);
+	if (HasOctNormals(format))
+	{
+		OctDecode(values, outVert + 3);
+	}
+	else
+	{
+		memcpy(outVert + 3, values, sizeof(float) * 3);
+	}
+
+	ReadAttribute(vert, layout.mAttributes[2], values);
+	outVert[6] = values[0] * quant.mUVScale.x + quant.mUVOffset.x;
+	outVert[7] = values[1] * quant.mUVScale.y + quant.mUVOffset.y;
+}
+
+VertexError VertexEncoder::Measure(const float* verts, unsigned int numVerts, VertexFormat format,
+	const unsigned char* encoded, const VertexQuantization& quant)
+{
+	VertexError error;
+	unsigned int stride = GetStride(format);
+	double totalPosition = 0.0;
+	for (unsigned int v = 0; v < numVerts; v++)
+	{
+		const float* src = verts + v * MeshData::VertexSize;
+		float decoded[MeshData::VertexSize];
+		Decode(encoded + v * stride, format, quant, decoded);
+
+		Vector3 pos = Vector3(src[0], src[1], src[2]) - Vector3(decoded[0], decoded[1], decoded[2]);
+		float posError = pos.Length();
+		error.mMaxPosition = Math::Max(error.mMaxPosition, posError);
+		totalPosition += posError;
+
+		Vector3 normal(src[3], src[4], src[5]);
+		Vector3 decodedNormal(decoded[3], decoded[4], decoded[5]);
+		if (normal.LengthSq() > 0.0f && decodedNormal.LengthSq() > 0.0f)
+		{
+			normal.Normalize();
+			decodedNormal.Normalize();
+			float cosAngle = Vector3::Dot(normal, decodedNormal);
+			float angle = Math::ToDegrees(Math::Acos(Math::Clamp(cosAngle, -1.0f, 1.0f)));
+			error.mMaxNormalDegrees = Math::Max(error.mMaxNormalDegrees, angle);
+		}
+
+		error.mMaxUV = Math::Max(error.mMaxUV, Math::Abs(src[6] - decoded[6]));
+		error.mMaxUV = Math::Max(error.mMaxUV, Math::Abs(src[7] - decoded[7]));
+	}
+	if (numVerts > 0)
+	{
+		error.mMeanPosition = static_cast<float>(totalPosition / numVerts);
+	}
+	return error;
+}
+
+void VertexEncoder::LogError(const std::string& name, const float* verts, unsigned int numVerts,
+	VertexFormat format, const unsigned char* encoded, const VertexQuantization& quant)
+{
+	VertexError error = Measure(verts, numVerts, format, encoded, quant);
+	SDL_Log("Mesh %s: %s %u -> %u bytes/vertex, position error max %g mean %g, normal max %.4f deg, uv max %g",
+		name.c_str(), GetName(format), GetStride(VertexFormat::EPosNormTex), GetStride(format),
+		error.mMaxPosition, error.mMeanPosition, error.mMaxNormalDegrees, error.mMaxUV);
+}
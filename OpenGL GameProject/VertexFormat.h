@@ -0,0 +1,90 @@
+#pragma once
+#include<cstdint>
+#include<string>
+#include<vector>
+#include"Math.h"
+
+// GPU side vertex layouts. Source meshes are always float
+// position 3, normal 3, uv 2 (MeshData::VertexSize); the format
+// only selects how they are encoded in the vertex buffer.
+enum class VertexFormat : uint32_t
+{
+	// float position 3, normal 3, uv 2 (32 bytes)
+	EPosNormTex = 0,
+	// float position 3, octahedral snorm16 normal 2, unorm16 uv 2 (20 bytes)
+	EPosOctTex = 1,
+	// unorm16 position 3 (+pad), octahedral snorm16 normal 2, unorm16 uv 2 (16 bytes)
+	EQuantPosOctTex = 2,
+	ECount
+};
+
+// Component type of one vertex attribute
+enum class AttributeType
+{
+	EFloat,
+	ESnorm16,
+	EUnorm16
+};
+
+struct VertexAttribute
+{
+	unsigned int mComponents;
+	AttributeType mType;
+	// Byte offset inside the vertex
+	unsigned int mOffset;
+};
+
+// Attribute 0 is position, 1 is normal, 2 is tex coords
+struct VertexLayout
+{
+	static const unsigned int NumAttributes = 3;
+
+	unsigned int mStride;
+	VertexAttribute mAttributes[NumAttributes];
+};
+
+// Maps normalized positions/uvs back to mesh space:
+// value = encoded * scale + offset (identity for float attributes)
+struct VertexQuantization
+{
+	Vector3 mPosScale = Vector3(1.0f, 1.0f, 1.0f);
+	Vector3 mPosOffset;
+	Vector2 mUVScale = Vector2(1.0f, 1.0f);
+	Vector2 mUVOffset;
+};
+
+// Quantization loss measured against the float source
+struct VertexError
+{
+	float mMaxPosition = 0.0f;
+	float mMeanPosition = 0.0f;
+	float mMaxNormalDegrees = 0.0f;
+	float mMaxUV = 0.0f;
+};
+
+class VertexEncoder
+{
+public:
+	static const VertexLayout& GetLayout(VertexFormat format);
+	static unsigned int GetStride(VertexFormat format) { return GetLayout(format).mStride; }
+	// True if the normal attribute is octahedral encoded
+	static bool HasOctNormals(VertexFormat format);
+
+	// Names used by the gpmesh "vertexformat" field
+	static const char* GetName(VertexFormat format);
+	static bool Parse(const std::string& name, VertexFormat& outFormat);
+
+	// Encode float vertices (MeshData::VertexSize each) into format,
+	// quantizing against the bounds of all of them
+	static void Encode(const float* verts, unsigned int numVerts, VertexFormat format,
+		std::vector<unsigned char>& outVerts, VertexQuantization& outQuant);
+	// Decode one vertex back to MeshData::VertexSize floats
+	static void Decode(const unsigned char* vert, VertexFormat format,
+		const VertexQuantization& quant, float* outVert);
+	// Compare encoded vertices against their float source
+	static VertexError Measure(const float* verts, unsigned int numVerts, VertexFormat format,
+		const unsigned char* encoded, const VertexQuantization& quant);
+	// Measure and log the error report for a mesh
+	static void LogError(const std::string& name, const float* verts, unsigned int numVerts,
+		VertexFormat format, const unsigned char* encoded, const VertexQuantization& quant);
+};